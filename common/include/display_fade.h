@@ -0,0 +1,76 @@
+/**
+ * @file display_fade.h
+ * @brief Header for display_fade.c file.
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+
+#ifndef DISPLAY_FADE_H_
+#define DISPLAY_FADE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* HW dependent includes */
+#include "port_display.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/**
+ * @brief Maximum number of frames of a sequence. It is the longest sequence that the HW can play.
+ *
+ */
+#define DISPLAY_FADE_MAX_FRAMES PORT_DISPLAY_MAX_FRAMES
+
+/**
+ * @brief Brightness at the dimmest frame of a pulse, in percentage of the perceived brightness of the color.
+ *
+ */
+#define DISPLAY_FADE_PULSE_DIM_PERCENT 20
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Perceived brightness of a level of a LED.
+ *
+ * The eye perceives the brightness of a LED roughly as the square root of its duty cycle (a gamma of 2), so the sequences are interpolated in this scale to look even.
+ *
+ * @param level Level of the LED, from 0 to `PORT_DISPLAY_RGB_MAX_VALUE`.
+ * @return uint32_t Perceived brightness, from 0 to `PORT_DISPLAY_RGB_MAX_VALUE`.
+ */
+uint32_t display_fade_to_perceptual(uint32_t level);
+
+/**
+ * @brief Level of a LED of a perceived brightness. Inverse of `display_fade_to_perceptual()`.
+ *
+ * @param perceptual Perceived brightness, from 0 to `PORT_DISPLAY_RGB_MAX_VALUE`.
+ * @return uint32_t Level of the LED, from 0 to `PORT_DISPLAY_RGB_MAX_VALUE`.
+ */
+uint32_t display_fade_from_perceptual(uint32_t perceptual);
+
+/**
+ * @brief Build the frames of a fade from a color to another one.
+ *
+ * The perceived brightness of each channel changes in equal steps. The first frame is already one step away from `from` (the color being shown) and the last frame is exactly `to`.
+ *
+ * @param p_frames Array where the frames are stored. It must have room for `DISPLAY_FADE_MAX_FRAMES` frames.
+ * @param from Color at the start of the fade.
+ * @param to Color at the end of the fade.
+ * @param num_frames Number of frames, from 1 to `DISPLAY_FADE_MAX_FRAMES`. Out of range values are clamped.
+ * @return uint32_t Number of frames stored.
+ */
+uint32_t display_fade_build(rgb_color_t *p_frames, rgb_color_t from, rgb_color_t to, uint32_t num_frames);
+
+/**
+ * @brief Build the frames of a pulse of a color, to be played in a loop.
+ *
+ * The first frame is the color. The perceived brightness decreases in equal steps down to `DISPLAY_FADE_PULSE_DIM_PERCENT` at the middle frame and increases again, so that the last frame joins the first one.
+ *
+ * @param p_frames Array where the frames are stored. It must have room for `DISPLAY_FADE_MAX_FRAMES` frames.
+ * @param color Color of the pulse.
+ * @param num_frames Number of frames of a period of the pulse, from 2 to `DISPLAY_FADE_MAX_FRAMES`. Out of range values are clamped.
+ * @return uint32_t Number of frames stored.
+ */
+uint32_t display_fade_build_pulse(rgb_color_t *p_frames, rgb_color_t color, uint32_t num_frames);
+
+#endif /* DISPLAY_FADE_H_ */
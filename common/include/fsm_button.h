@@ -69,6 +69,8 @@ void fsm_button_destroy (fsm_button_t *p_fsm);
  * 
  * This function is used to fire the button FSM. It is used to check the transitions and execute the actions of the button FSM.
  * 
+ * The pending events of the interrupt are processed one by one, in order: the transitions are checked at the time of each event, so a press and a release between two calls are both seen and the duration is measured between the events. If the queue overflowed, the newest events were lost, so the level of the button is read from its GPIO. Then the transitions are checked at the current time.
+ * 
  * @param p_fsm Pointer to an `fsm_button_t` structure.
  */
 void fsm_button_fire (fsm_button_t *p_fsm);
@@ -15,6 +15,7 @@
 #include <stdbool.h>
 
 #include "fsm.h"
+#include "output_conditioner.h"
 
 /* Defines and enums ----------------------------------------------------------*/
 /* Defines */
@@ -73,13 +74,28 @@ void fsm_buzzer_destroy(fsm_buzzer_t *p_fsm);
 /**
  * @brief Set the buzzer system to show the distance in cm.
  *
- * This function is used to set the buzzer system to show the distance in cm.
+ * This function is used to set the buzzer system to show the distance in cm. The distance goes through the conditioning of the buzzer (see `fsm_buzzer_set_conditioning()`), and the sound is only updated if the conditioned distance changes.
  *
  * @param p_fsm 	Pointer to an `fsm_buzzer_t` struct.
  * @param distance_cm Distance in cm to show in the buzzer system.
  */
 void fsm_buzzer_set_distance(fsm_buzzer_t *p_fsm, uint32_t distance_cm);
 
+/**
+ * @brief Set the conditioning of the distances sounded by a buzzer.
+ *
+ * A distance that dithers around a zone boundary does not change to the farther zone (and tone) until it goes past the boundary by more than its hysteresis, and a zone is sounded for at least `hold_ms` before a farther one. A closer zone is sounded at once. By default there is no conditioning.
+ *
+ * @param p_fsm Pointer to an `fsm_buzzer_t` struct.
+ * @param p_boundaries Array of zone boundaries sorted by distance, or NULL if `num_boundaries` is 0.
+ * @param num_boundaries Number of boundaries, from 0 to `OUTPUT_CONDITIONER_MAX_BOUNDARIES`.
+ * @param deadband_cm Change in cm of the distance inside a zone that is ignored. 0 to follow every change.
+ * @param hold_ms Minimum time in ms in a zone before changing to a farther one.
+ * @return true If the configuration is valid.
+ * @return false Otherwise. The conditioning is not changed.
+ */
+bool fsm_buzzer_set_conditioning(fsm_buzzer_t *p_fsm, const output_conditioner_boundary_t *p_boundaries, uint32_t num_boundaries, uint32_t deadband_cm, uint32_t hold_ms);
+
 /**
  * @brief Fire the buzzer FSM.
  *
@@ -89,6 +105,16 @@ void fsm_buzzer_set_distance(fsm_buzzer_t *p_fsm, uint32_t distance_cm);
  */
 void fsm_buzzer_fire(fsm_buzzer_t *p_fsm);
 
+/**
+ * @brief Get the distance in cm sounded by the buzzer FSM, after its conditioning.
+ *
+ * This function might be used for testing and debugging purposes.
+ *
+ * @param p_fsm Pointer to an `fsm_buzzer_t` struct.
+ * @return uint32_t Distance in cm.
+ */
+uint32_t fsm_buzzer_get_distance(fsm_buzzer_t *p_fsm);
+
 /**
  * @brief Get the status of the buzzer FSM.
  *
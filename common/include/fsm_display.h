@@ -15,6 +15,8 @@
 #include <stdbool.h>
 
 #include "fsm.h"
+#include "port_display.h"
+#include "output_conditioner.h"
 
 /* Defines and enums ----------------------------------------------------------*/
 /* Defines */
@@ -60,6 +62,12 @@
  */
 #define OK_MAX_CM 200
 
+/**
+ * @brief Number of entries of the distance-to-color lookup table of a display: one per cm from 0 to `OK_MAX_CM`. Farther distances are shown as `COLOR_OFF`.
+ *
+ */
+#define FSM_DISPLAY_LUT_SIZE (OK_MAX_CM + 1)
+
 /* Enums */
 /**
  * @brief Enumerator for the display system finite state machine.
@@ -80,6 +88,19 @@ enum FSM_DISPLAY_SYSTEM
  */
 typedef struct fsm_display_t fsm_display_t;
 
+/**
+ * @brief Zone of distances of a color profile of a display.
+ *
+ * A zone starts just after the end of the previous zone (or at 0 cm for the first zone) and ends at `max_cm`, both included for the first zone. The color is interpolated linearly from `color_min` at the start of the zone to `color_max` at `max_cm`.
+ *
+ */
+typedef struct
+{
+    uint32_t max_cm;        /*!< Last distance in cm of the zone */
+    rgb_color_t color_min;  /*!< Color at the start of the zone */
+    rgb_color_t color_max;  /*!< Color at `max_cm` */
+} fsm_display_zone_t;
+
 /* Function prototypes and explanation -------------------------------------------------*/
 /**
  * @brief Create a new display FSM.
@@ -103,13 +124,54 @@ void fsm_display_destroy(fsm_display_t *p_fsm);
 /**
  * @brief Set the display system to show the distance in cm.
  *
- * This function is used to set the display system to show the distance in cm.
+ * This function is used to set the display system to show the distance in cm. The distance goes through the conditioning of the display (see `fsm_display_set_conditioning()`), and the color is only updated if the conditioned distance changes.
  *
  * @param p_fsm 	Pointer to an `fsm_display_t` struct.
  * @param distance_cm Distance in cm to show in the display system.
  */
 void fsm_display_set_distance(fsm_display_t *p_fsm, uint32_t distance_cm);
 
+/**
+ * @brief Set the color profile of a display.
+ *
+ * The profile is a table of zones of distances and colors (see `fsm_display_zone_t`), so each vehicle can have its own profile without changing the code. The profile is converted once into a lookup table with the color of every cm, so showing a distance is just an indexed read.
+ *
+ * The default profile goes from red at `DANGER_MIN_CM` to yellow at `WARNING_MIN_CM`, green at `NO_PROBLEM_MIN_CM`, turquoise at `INFO_MIN_CM`, blue at `OK_MIN_CM` and off at `OK_MAX_CM`.
+ *
+ * @param p_fsm Pointer to an `fsm_display_t` struct.
+ * @param p_zones Array of zones sorted by distance, or NULL to set the default profile.
+ * @param num_zones Number of zones.
+ * @return true If the profile is valid: at least one zone, increasing `max_cm` and all the zones below `FSM_DISPLAY_LUT_SIZE`.
+ * @return false Otherwise. The profile is not changed.
+ */
+bool fsm_display_set_profile(fsm_display_t *p_fsm, const fsm_display_zone_t *p_zones, uint32_t num_zones);
+
+/**
+ * @brief Set the conditioning of the distances shown by a display.
+ *
+ * A distance that dithers around a zone boundary does not change to the farther zone (and color) until it goes past the boundary by more than its hysteresis, and a zone is shown for at least `hold_ms` before a farther one. A closer zone is shown at once. By default there is no conditioning.
+ *
+ * @param p_fsm Pointer to an `fsm_display_t` struct.
+ * @param p_boundaries Array of zone boundaries sorted by distance, or NULL if `num_boundaries` is 0. Usually the `max_cm` of the zones of the color profile.
+ * @param num_boundaries Number of boundaries, from 0 to `OUTPUT_CONDITIONER_MAX_BOUNDARIES`.
+ * @param deadband_cm Change in cm of the distance inside a zone that is ignored. 0 to follow every change.
+ * @param hold_ms Minimum time in ms in a zone before changing to a farther one.
+ * @return true If the configuration is valid.
+ * @return false Otherwise. The conditioning is not changed.
+ */
+bool fsm_display_set_conditioning(fsm_display_t *p_fsm, const output_conditioner_boundary_t *p_boundaries, uint32_t num_boundaries, uint32_t deadband_cm, uint32_t hold_ms);
+
+/**
+ * @brief Set the transitions between the colors of a display.
+ *
+ * The sequences are played by the HW of the display, one frame per `PORT_DISPLAY_FRAME_MS`, so the CPU is not involved once a sequence has started. By default both the fade and the pulse are disabled and the color changes at once.
+ *
+ * @param p_fsm Pointer to an `fsm_display_t` struct.
+ * @param fade_ms Duration in ms of the fade from the color being shown to a new color. 0 (or less than a frame) to change the color at once.
+ * @param pulse_period_ms Period in ms of the pulse of the color in the danger zone (the first zone of the color profile). 0 (or less than a frame) to not pulse. The period is limited to `PORT_DISPLAY_MAX_FRAMES` frames.
+ */
+void fsm_display_set_fade(fsm_display_t *p_fsm, uint32_t fade_ms, uint32_t pulse_period_ms);
+
 /**
  * @brief Fire the display FSM.
  *
@@ -19,11 +19,179 @@
 
 /* Defines and enums ----------------------------------------------------------*/
 /**
- * @brief Number of measurements to store in the array.
+ * @brief Number of measurements in the sliding window used to compute the median distance.
+ * 
+ * Once the window is full, a new median is published after every measurement. It should be an odd number so that the median is a real measurement.
  * 
  */
 #define FSM_ULTRASOUND_NUM_MEASUREMENTS 5
 
+/**
+ * @brief Distance in cm stored in the window of measurements when the echo signal has been lost.
+ * 
+ * It is beyond the range of the HC-SR04 (400 cm), so it is treated as "out of range" by the median filter and by the consumers of the distance.
+ * 
+ */
+#define FSM_ULTRASOUND_NO_ECHO_CM 500
+
+/**
+ * @brief Default range of interest in cm of an ultrasound sensor: the maximum range of the HC-SR04.
+ * 
+ * Echoes longer than the range of interest are abandoned as soon as they exceed it (see `fsm_ultrasound_set_max_range()`).
+ * 
+ */
+#define FSM_ULTRASOUND_MAX_RANGE_CM 400
+
+/**
+ * @brief Shortest period in ms between measurements. It is used with very near obstacles or when an obstacle approaches fast.
+ * 
+ */
+#define FSM_ULTRASOUND_MIN_PERIOD_MS 50
+
+/**
+ * @brief Longest period in ms between measurements. It is used when the measurements are far and stable.
+ * 
+ */
+#define FSM_ULTRASOUND_MAX_PERIOD_MS 300
+
+/**
+ * @brief Distance in cm below which the period between measurements shrinks linearly down to `FSM_ULTRASOUND_MIN_PERIOD_MS`.
+ * 
+ */
+#define FSM_ULTRASOUND_NEAR_CM 100
+
+/**
+ * @brief Distance in cm from which stable measurements lengthen the period between measurements to `FSM_ULTRASOUND_MAX_PERIOD_MS`.
+ * 
+ */
+#define FSM_ULTRASOUND_FAR_CM 250
+
+/**
+ * @brief Maximum difference in cm between two consecutive measurements to consider them stable.
+ * 
+ */
+#define FSM_ULTRASOUND_STABLE_CM 3
+
+/**
+ * @brief Number of consecutive stable measurements needed to lengthen the period between measurements.
+ * 
+ */
+#define FSM_ULTRASOUND_STABLE_MEASUREMENTS 10
+
+/**
+ * @brief Closing speed in cm/s from which the period between measurements is `FSM_ULTRASOUND_MIN_PERIOD_MS` regardless of the distance.
+ * 
+ */
+#define FSM_ULTRASOUND_FAST_CLOSING_CM_S 50
+
+/**
+ * @brief Gain of the distance correction of the alpha-beta tracker, in Q8 fixed point (128 is 0.5).
+ * 
+ */
+#define FSM_ULTRASOUND_TRACKER_ALPHA_Q8 128
+
+/**
+ * @brief Gain of the speed correction of the alpha-beta tracker, in Q8 fixed point. It is `alpha^2 / (2 - alpha)` (43 is about 0.167) for a critically damped response.
+ * 
+ */
+#define FSM_ULTRASOUND_TRACKER_BETA_Q8 43
+
+/**
+ * @brief Maximum time in ms between two distances used by the tracker. If it is exceeded, the tracker restarts from the last distance with null speed.
+ * 
+ */
+#define FSM_ULTRASOUND_TRACKER_RESET_MS 1000
+
+/**
+ * @brief Time to collision returned when the obstacle does not approach.
+ * 
+ */
+#define FSM_ULTRASOUND_TTC_INFINITE UINT32_MAX
+
+/**
+ * @brief Shortest duration in us of a plausible echo signal: the echo of an obstacle at 2 cm, the minimum range of the HC-SR04.
+ * 
+ */
+#define FSM_ULTRASOUND_MIN_ECHO_US 116
+
+/**
+ * @brief Shortest plausible delay in us from the start of a measurement to the start of its echo signal.
+ * 
+ * The HC-SR04 raises the echo signal after the trigger pulse and its burst of 8 cycles at 40 kHz (200 us), so an earlier edge is not its answer.
+ * 
+ */
+#define FSM_ULTRASOUND_MIN_ECHO_DELAY_US 150
+
+/**
+ * @brief Longest plausible delay in us from the start of a measurement to the start of its echo signal.
+ * 
+ */
+#define FSM_ULTRASOUND_MAX_ECHO_DELAY_US 5000
+
+/**
+ * @brief Deviation in cm from the distance predicted by the tracker that is fully plausible, besides the movement allowed by `FSM_ULTRASOUND_MAX_SPEED_CM_S`.
+ * 
+ * The score of a measurement decreases linearly from 100 at this deviation to 0 at twice this deviation.
+ * 
+ */
+#define FSM_ULTRASOUND_PLAUSIBLE_DEVIATION_CM 30
+
+/**
+ * @brief Highest plausible relative speed in cm/s of an obstacle. It widens the plausible deviation with the time since the last distance of the tracker.
+ * 
+ */
+#define FSM_ULTRASOUND_MAX_SPEED_CM_S 200
+
+/**
+ * @brief Lowest plausibility score (0 to 100) of a measurement to be used. Measurements with a lower score are rejected.
+ * 
+ */
+#define FSM_ULTRASOUND_MIN_SCORE 50
+
+/**
+ * @brief Number of consecutive measurements rejected for their deviation from the tracker after which the window and the tracker are restarted with the next one.
+ * 
+ * It lets the filter follow an obstacle that appears suddenly (e.g. a pedestrian in front of a far wall).
+ * 
+ */
+#define FSM_ULTRASOUND_MAX_REJECTIONS 3
+
+/**
+ * @brief Number of measurements kept in the history of each ultrasound sensor.
+ * 
+ */
+#define FSM_ULTRASOUND_HISTORY_SIZE 16
+
+/**
+ * @brief Lowest temperature of the air in degrees Celsius compensated in the speed of sound. Colder temperatures are saturated.
+ * 
+ */
+#define FSM_ULTRASOUND_MIN_TEMPERATURE_C -20
+
+/**
+ * @brief Highest temperature of the air in degrees Celsius compensated in the speed of sound. Hotter temperatures are saturated.
+ * 
+ */
+#define FSM_ULTRASOUND_MAX_TEMPERATURE_C 45
+
+/**
+ * @brief Temperature of the air in degrees Celsius assumed until one is set with `fsm_ultrasound_set_temperature()`.
+ * 
+ */
+#define FSM_ULTRASOUND_DEFAULT_TEMPERATURE_C 20
+
+/**
+ * @enum FSM_ULTRASOUND_SAMPLE_STATUS
+ * 
+ * @brief Result of a measurement stored in the history of an ultrasound sensor.
+ */
+enum FSM_ULTRASOUND_SAMPLE_STATUS {
+    FSM_ULTRASOUND_SAMPLE_OK = 0,           /**< The echo signal was received completely*/
+    FSM_ULTRASOUND_SAMPLE_NO_ECHO,          /**< The echo signal was lost (timeout)*/
+    FSM_ULTRASOUND_SAMPLE_OUT_OF_RANGE,     /**< The echo signal was abandoned because it exceeded the range of interest*/
+    FSM_ULTRASOUND_SAMPLE_REJECTED          /**< The echo signal was received but it was not plausible (see `fsm_ultrasound_get_rejections()`)*/
+};
+
 /**
  * @enum FSM_ULTRASOUND
  * 
@@ -32,11 +200,11 @@
  * This enumerator defines the different states that the ultrasound finite state machine can be in. Each state represents a specific condition or step in the ultrasound distance measurement process.
  */
 enum FSM_ULTRASOUND {
-    WAIT_START = 0,     /**< Starting state. Also comes here when the distance measurement has been completed or a timeout has occurred*/
+    WAIT_START = 0,     /**< Starting state. Also comes here when the ultrasound sensor is stopped after a measurement*/
     TRIGGER_START,      /**< State to send the trigger pulse to the ultrasound sensor*/
     WAIT_ECHO_START,    /**< State to wait for the echo signal*/
     WAIT_ECHO_END,      /**< State to wait for the echo signal*/
-    SET_DISTANCE        /**< State to compute the distance from the echo signal*/
+    SET_DISTANCE        /**< State to compute the distance from the echo signal. Also comes here when the echo signal has been lost (timeout)*/
 };
 
 /* Typedefs --------------------------------------------------------------------*/
@@ -48,6 +216,29 @@ enum FSM_ULTRASOUND {
  */
 typedef struct fsm_ultrasound_t fsm_ultrasound_t;
 
+/**
+ * @brief Measurement stored in the history of an ultrasound sensor.
+ * 
+ */
+typedef struct
+{
+    uint32_t echo_ticks;     /*!< Duration of the echo signal in ticks of the echo timer (see `port_ultrasound_get_echo_ticks_per_us()`). For lost or abandoned echoes, time waited */
+    uint32_t distance_cm;    /*!< Filtered distance in cm after the measurement (see `fsm_ultrasound_get_filtered_distance()`) */
+    uint32_t timestamp_tick; /*!< Tick of the echo timebase of the start of the echo signal, or of the start of the measurement if its status is `FSM_ULTRASOUND_SAMPLE_NO_ECHO`. The timebase wraps around every 2^32 ticks, so only differences modulo 2^32 are meaningful. Divide them by `port_ultrasound_get_echo_ticks_per_us()` to get us */
+    uint8_t status;          /*!< Result of the measurement. One of `FSM_ULTRASOUND_SAMPLE_STATUS` */
+} fsm_ultrasound_sample_t;
+
+/**
+ * @brief Iterator over the history of an ultrasound sensor. It is filled by `fsm_ultrasound_history_begin()` and it must not be modified by the user.
+ * 
+ */
+typedef struct
+{
+    const fsm_ultrasound_t *p_fsm;  /*!< Ultrasound FSM whose history is iterated */
+    uint32_t index;                 /*!< Index in the history of the sample returned last */
+    uint32_t remaining;             /*!< Number of samples not returned yet */
+} fsm_ultrasound_history_it_t;
+
 /* Function prototypes and explanation -------------------------------------------------*/
 /**
  * @brief Create a new ultrasound FSM.
@@ -79,15 +270,174 @@ void 	fsm_ultrasound_destroy (fsm_ultrasound_t *p_fsm);
  */
 uint32_t 	fsm_ultrasound_get_distance (fsm_ultrasound_t *p_fsm);
 
+/**
+ * @brief Return the distance of the last object detected by the ultrasound sensor in millimetres.
+ * 
+ * It is the same measurement as `fsm_ultrasound_get_distance()` before the truncation to cm. The duration of the echo signal is converted in fixed point (see `port_ultrasound_get_echo_ticks_per_us()` for the resolution of the echo timer). The function also resets the field `new_measurement`.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return uint32_t Distance measured by the ultrasound sensor in millimetres.
+ */
+uint32_t 	fsm_ultrasound_get_distance_mm (fsm_ultrasound_t *p_fsm);
+
+/**
+ * @brief Return the confidence of the last distance returned by `fsm_ultrasound_get_distance()`.
+ * 
+ * The confidence is the percentage of the median window that was filled when the distance was computed. It is lower than 100 during the warm-up after `fsm_ultrasound_start()`, when the distance is the median of only 1, 3, ... measurements.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return uint8_t Confidence of the distance in percentage (0 if no distance has been computed yet).
+ */
+uint8_t 	fsm_ultrasound_get_confidence (fsm_ultrasound_t *p_fsm);
+
+/**
+ * @brief Set the range of interest of the ultrasound sensor.
+ * 
+ * When the echo signal lasts longer than the time of flight of an obstacle at `max_range_cm`, the measurement is abandoned before the end of the echo signal and `FSM_ULTRASOUND_NO_ECHO_CM` is stored as distance. The next measurement is triggered as soon as the sensor is free, so the measurement rate increases when the obstacles are near.
+ * 
+ * The echo timeout is recomputed too, so that the echo of an obstacle in the range is never taken as lost (see `fsm_ultrasound_get_echo_timeout_ms()`).
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param max_range_cm Range of interest in cm. The default value is `FSM_ULTRASOUND_MAX_RANGE_CM`.
+ */
+void 	fsm_ultrasound_set_max_range (fsm_ultrasound_t *p_fsm, uint32_t max_range_cm);
+
+/**
+ * @brief Get the range of interest of the ultrasound sensor.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return uint32_t Range of interest in cm.
+ */
+uint32_t 	fsm_ultrasound_get_max_range (fsm_ultrasound_t *p_fsm);
+
+/**
+ * @brief Get the time since the start of a measurement after which its echo signal is considered lost.
+ * 
+ * It covers the latest start of a valid echo signal (`FSM_ULTRASOUND_MAX_ECHO_DELAY_US`) plus the echo of an obstacle at the range of interest, and it is never shorter than `FSM_ULTRASOUND_ECHO_TIMEOUT_MS`.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return uint32_t Echo timeout in ms.
+ */
+uint32_t 	fsm_ultrasound_get_echo_timeout_ms (fsm_ultrasound_t *p_fsm);
+
+/**
+ * @brief Set the temperature of the air, to compensate the speed of sound.
+ * 
+ * The speed of sound grows with the temperature (331.3 m/s at 0 degrees Celsius, about 0.6 m/s more per degree), so a fixed speed gives an error of several percent at the extremes of the operating range. The factor that converts the duration of the echo signal to distance is read from a precomputed table, so every conversion is still a single multiplication. The range of interest is also converted again.
+ * 
+ * The temperature can come from the internal sensor of the platform (see `port_temperature_get_celsius()`) or from any other source.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param temperature_c Temperature in degrees Celsius. It is saturated to [`FSM_ULTRASOUND_MIN_TEMPERATURE_C`, `FSM_ULTRASOUND_MAX_TEMPERATURE_C`].
+ */
+void 	fsm_ultrasound_set_temperature (fsm_ultrasound_t *p_fsm, int32_t temperature_c);
+
+/**
+ * @brief Get the temperature of the air used to compensate the speed of sound.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return int32_t Temperature in degrees Celsius, after the saturation.
+ */
+int32_t 	fsm_ultrasound_get_temperature (fsm_ultrasound_t *p_fsm);
+
+/**
+ * @brief Get the current period in ms between measurements of the ultrasound sensor.
+ * 
+ * The period adapts after every measurement: it shrinks as the obstacle gets nearer or approaches faster, and it grows when the measurements are far and stable.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return uint32_t Period in ms between measurements.
+ */
+uint32_t 	fsm_ultrasound_get_measurement_period_ms (fsm_ultrasound_t *p_fsm);
+
+/**
+ * @brief Get the number of measurements rejected since the FSM was created because they were not plausible.
+ * 
+ * Each received echo signal gets a plausibility score from 0 to 100:
+ * - 0 if the echo signal is shorter than `FSM_ULTRASOUND_MIN_ECHO_US`, or if it started earlier than `FSM_ULTRASOUND_MIN_ECHO_DELAY_US` or later than `FSM_ULTRASOUND_MAX_ECHO_DELAY_US` after the start of the measurement. These are spurious edges, not the answer of the sensor.
+ * - Otherwise, it decreases with the deviation from the distance predicted by the tracker (see `FSM_ULTRASOUND_PLAUSIBLE_DEVIATION_CM`). Echoes shortened by the ping of a neighbouring sensor are far from the prediction.
+ * 
+ * Measurements with a score below `FSM_ULTRASOUND_MIN_SCORE` are stored in the history as `FSM_ULTRASOUND_SAMPLE_REJECTED` but they do not enter the median window nor the tracker. The others correct the tracker in proportion to their score.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return uint32_t Number of rejected measurements.
+ */
+uint32_t 	fsm_ultrasound_get_rejections (fsm_ultrasound_t *p_fsm);
+
+/**
+ * @brief Get the number of measurement periods missed since the FSM was created.
+ * 
+ * A period is missed when the timer of new measurements expires again before the previous expiry has started a measurement, e.g. because the main loop has stalled. Each expiry is an event of the `port`, so the repeated expiries are counted instead of being merged into one.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return uint32_t Number of missed periods.
+ */
+uint32_t 	fsm_ultrasound_get_missed_periods (fsm_ultrasound_t *p_fsm);
+
+/**
+ * @brief Return the distance to the obstacle estimated by the tracker of the ultrasound sensor.
+ * 
+ * The tracker is an alpha-beta filter fed with the published distances and the time of each measurement. Unlike `fsm_ultrasound_get_distance()`, this function does not reset the `new_measurement` flag.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return uint32_t Filtered distance in cm. It is the last published distance if the tracker is not valid (e.g. the obstacle is out of range).
+ */
+uint32_t 	fsm_ultrasound_get_filtered_distance (fsm_ultrasound_t *p_fsm);
+
+/**
+ * @brief Return the speed at which the obstacle approaches the ultrasound sensor, estimated by the tracker.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return int32_t Closing speed in cm/s. It is positive when the obstacle approaches, negative when it moves away and 0 if the tracker is not valid.
+ */
+int32_t 	fsm_ultrasound_get_closing_speed (fsm_ultrasound_t *p_fsm);
+
+/**
+ * @brief Return the time to collision with the obstacle, i.e. the filtered distance divided by the closing speed.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return uint32_t Time to collision in ms. It is `FSM_ULTRASOUND_TTC_INFINITE` if the obstacle does not approach or the tracker is not valid.
+ */
+uint32_t 	fsm_ultrasound_get_ttc_ms (fsm_ultrasound_t *p_fsm);
+
+/**
+ * @brief Start iterating over the history of measurements of the ultrasound sensor, from the newest to the oldest.
+ * 
+ * The samples are returned by pointer, without copying them. They are valid until the next measurement of the sensor, so the history must be iterated from the same context that fires the FSM.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param p_it Pointer to the iterator to initialize.
+ * @return const fsm_ultrasound_sample_t* Newest measurement, or NULL if the history is empty.
+ */
+const fsm_ultrasound_sample_t * 	fsm_ultrasound_history_begin (const fsm_ultrasound_t *p_fsm, fsm_ultrasound_history_it_t *p_it);
+
+/**
+ * @brief Return the next (older) measurement of the history of the ultrasound sensor.
+ * 
+ * @param p_it Pointer to an iterator initialized by `fsm_ultrasound_history_begin()`.
+ * @return const fsm_ultrasound_sample_t* Next measurement, or NULL if there are no more measurements (at most `FSM_ULTRASOUND_HISTORY_SIZE`).
+ */
+const fsm_ultrasound_sample_t * 	fsm_ultrasound_history_next (fsm_ultrasound_history_it_t *p_it);
+
 /**
  * @brief Fire the ultrasound FSM.
  * 
  * This function is used to fire the ultrasound FSM. It is used to check the transitions and execute the actions of the ultrasound FSM.
  * 
+ * The pending events of the interrupts of the `port` are popped one by one, in order: each one is applied to its flag and the transitions are checked before the next one (see `port_ultrasound_pop_event()`). Then the transitions are checked once more for the echo signal and the timeouts.
+ * 
  * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
  */
 void 	fsm_ultrasound_fire (fsm_ultrasound_t *p_fsm);
 
+/**
+ * @brief Get the ID of the ultrasound sensor of the FSM. It is also the sensor ID of the records that the FSM publishes in the measurement bus (see `measurement_bus.h`).
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return uint32_t Ultrasound ID.
+ */
+uint32_t 	fsm_ultrasound_get_id (fsm_ultrasound_t *p_fsm);
+
 /**
  * @brief Get the status of the ultrasound transceiver FSM.
  * 
@@ -147,6 +497,34 @@ void 	fsm_ultrasound_stop (fsm_ultrasound_t *p_fsm);
  */
 void 	fsm_ultrasound_start (fsm_ultrasound_t *p_fsm);
 
+/**
+ * @brief Let a scheduler trigger the measurements of the ultrasound sensor.
+ * 
+ * When the measurements are scheduled, the timer of new measurements is not used: a measurement starts only after `fsm_ultrasound_request_measurement()`, so a scheduler above the FSMs (see `ultrasound_scheduler.h`) owns the trigger timeline of several sensors. The adaptive period between measurements does not apply.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param scheduled `true` to trigger the measurements on request, `false` to trigger them with the timer of new measurements.
+ */
+void 	fsm_ultrasound_set_scheduled (fsm_ultrasound_t *p_fsm, bool scheduled);
+
+/**
+ * @brief Request a measurement of a scheduled ultrasound sensor. It starts in the next fire of the FSM if the sensor is active.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ */
+void 	fsm_ultrasound_request_measurement (fsm_ultrasound_t *p_fsm);
+
+/**
+ * @brief Check if the ultrasound sensor has a measurement in progress, from its request until the end of its echo signal.
+ * 
+ * A scheduler must not trigger other sensors that may hear this one while it returns `true`.
+ * 
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return true If a measurement has been requested, or it has started and its echo signal has not ended.
+ * @return false Otherwise.
+ */
+bool 	fsm_ultrasound_is_measuring (fsm_ultrasound_t *p_fsm);
+
 /**
  * @brief Get the inner FSM of the ultrasound.
  * 
@@ -12,6 +12,7 @@
 /* Includes ------------------------------------------------------------------*/
 /* Standard C includes */
 #include <stdint.h>
+#include <stdbool.h>
 
 /* Other includes */
 #include "fsm_button.h"
@@ -20,6 +21,18 @@
 #include "fsm_buzzer.h"
 
 /* Defines and enums ----------------------------------------------------------*/
+/**
+ * @brief Time to collision in ms below which the driver is warned even if the obstacle is still far.
+ *
+ */
+#define URBANITE_TTC_WARNING_MS 1500
+
+/**
+ * @brief Distance in cm shown by the display and the buzzer when the time to collision is below `URBANITE_TTC_WARNING_MS` and the obstacle is farther.
+ *
+ */
+#define URBANITE_TTC_WARNING_CM WARNING_MIN_CM
+
 /**
  * @brief Enumerator for the Urbanite finite state machine.
  *
@@ -80,4 +93,25 @@ void fsm_urbanite_fire(fsm_urbanite_t *p_fsm);
  */
 void fsm_urbanite_destroy(fsm_urbanite_t *p_fsm);
 
+/**
+ * @brief Set whether the front and rear ultrasounds measure at the same time.
+ * 
+ * If both sides are measured, each display shows the distance of its own side and the buzzer sounds the closer side. Changing the current side (front or rear) is then instant, because no ultrasound is stopped and no sliding window has to be filled again. Otherwise only the current side is measured, as by default.
+ * 
+ * If the system is ON, the ultrasound of the other side is started or stopped right away.
+ * 
+ * @param p_fsm Pointer to an `fsm_urbanite_t` struct.
+ * @param measure_both true to measure both sides, false to measure only the current side.
+ */
+void fsm_urbanite_set_measure_both(fsm_urbanite_t *p_fsm, bool measure_both);
+
+/**
+ * @brief Get whether the front and rear ultrasounds measure at the same time.
+ * 
+ * @param p_fsm Pointer to an `fsm_urbanite_t` struct.
+ * @return true If both sides are measured.
+ * @return false If only the current side is measured.
+ */
+bool fsm_urbanite_get_measure_both(fsm_urbanite_t *p_fsm);
+
 #endif /* FSM_URBANITE_H_ */
\ No newline at end of file
@@ -0,0 +1,109 @@
+/**
+ * @file measurement_bus.h
+ * @brief Header for measurement_bus.c file.
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+
+#ifndef MEASUREMENT_BUS_H_
+#define MEASUREMENT_BUS_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/**
+ * @brief Maximum number of subscribers of the bus.
+ *
+ */
+#define MEASUREMENT_BUS_MAX_SUBSCRIBERS 8
+
+/**
+ * @brief Maximum number of sensors that publish in the bus. The sensor IDs must be lower.
+ *
+ */
+#define MEASUREMENT_BUS_MAX_SENSORS 8
+
+/**
+ * @brief Sensor mask of a filter that accepts the records of all the sensors.
+ *
+ */
+#define MEASUREMENT_BUS_ALL_SENSORS ((1U << MEASUREMENT_BUS_MAX_SENSORS) - 1)
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Measurement published by a sensor.
+ *
+ */
+typedef struct
+{
+    uint32_t sensor_id;     /*!< ID of the sensor that measured the distance */
+    uint32_t timestamp_ms;  /*!< System time in ms when the distance was published */
+    uint32_t distance_cm;   /*!< Distance in cm */
+    uint32_t distance_mm;   /*!< Distance in mm */
+    uint32_t ttc_ms;        /*!< Time to collision in ms */
+    uint8_t confidence;     /*!< Confidence of the distance from 0 to 100 */
+} measurement_record_t;
+
+/**
+ * @brief Filter of the records delivered to a subscriber. Each condition is evaluated per sensor, and the first record of each sensor is always delivered.
+ *
+ */
+typedef struct
+{
+    uint32_t sensor_mask;   /*!< Sensors whose records are delivered (bit `i` is the sensor with ID `i`) */
+    uint32_t min_change_cm; /*!< Minimum change in cm from the last distance delivered. 0 to deliver every distance */
+    uint32_t min_period_ms; /*!< Minimum time in ms from the last record delivered. 0 for no rate limit */
+} measurement_bus_filter_t;
+
+/**
+ * @brief Function called when a record passes the filter of a subscriber.
+ *
+ * The record is passed by reference and it belongs to the publisher: it is only valid until the next measurement of the same sensor, so the subscriber must not store the pointer beyond that.
+ *
+ * @param p_record Pointer to the record.
+ * @param p_context Pointer given when subscribing.
+ */
+typedef void (*measurement_bus_callback_t)(const measurement_record_t *p_record, void *p_context);
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Remove all the subscribers of the bus.
+ *
+ * The bus is empty at start-up, so it is only needed to reuse the bus (e.g. in the unit tests).
+ */
+void measurement_bus_init(void);
+
+/**
+ * @brief Subscribe to the records of the bus.
+ *
+ * The bus has static storage for `MEASUREMENT_BUS_MAX_SUBSCRIBERS` subscribers: it never allocates memory.
+ *
+ * @param p_filter Pointer to the filter of the records. It is copied.
+ * @param callback Function called with each record that passes the filter.
+ * @param p_context Pointer passed to `callback`.
+ * @return int32_t ID of the subscriber, or -1 if there is no room for another subscriber.
+ */
+int32_t measurement_bus_subscribe(const measurement_bus_filter_t *p_filter, measurement_bus_callback_t callback, void *p_context);
+
+/**
+ * @brief Cancel a subscription.
+ *
+ * @param subscriber_id ID returned by `measurement_bus_subscribe()`.
+ */
+void measurement_bus_unsubscribe(int32_t subscriber_id);
+
+/**
+ * @brief Publish a record to the subscribers whose filter accepts it.
+ *
+ * The callbacks are called in the order of subscription, in the context of the publisher.
+ *
+ * @param p_record Pointer to the record. It is not copied.
+ * @return uint32_t Number of subscribers that have received the record.
+ */
+uint32_t measurement_bus_publish(const measurement_record_t *p_record);
+
+#endif /* MEASUREMENT_BUS_H_ */
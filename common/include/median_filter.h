@@ -0,0 +1,72 @@
+/**
+ * @file median_filter.h
+ * @brief Header for median_filter.c file.
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+
+#ifndef MEDIAN_FILTER_H_
+#define MEDIAN_FILTER_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Median of 3 values using a sorting network.
+ *
+ * @param p_values Pointer to an array of 3 values. **The array is reordered.**
+ * @return uint32_t Median of the 3 values.
+ */
+uint32_t median_filter_3(uint32_t *p_values);
+
+/**
+ * @brief Median of 5 values using a sorting network.
+ *
+ * @param p_values Pointer to an array of 5 values. **The array is reordered.**
+ * @return uint32_t Median of the 5 values.
+ */
+uint32_t median_filter_5(uint32_t *p_values);
+
+/**
+ * @brief Median of 7 values using a sorting network.
+ *
+ * @param p_values Pointer to an array of 7 values. **The array is reordered.**
+ * @return uint32_t Median of the 7 values.
+ */
+uint32_t median_filter_7(uint32_t *p_values);
+
+/**
+ * @brief Median of 9 values using a sorting network.
+ *
+ * @param p_values Pointer to an array of 9 values. **The array is reordered.**
+ * @return uint32_t Median of the 9 values.
+ */
+uint32_t median_filter_9(uint32_t *p_values);
+
+/**
+ * @brief Return the element of rank `k` (0 is the smallest) using quickselect.
+ *
+ * Iterative version of Hoare's selection algorithm. It works in place, does not allocate memory and does not recurse.
+ *
+ * @param p_values Pointer to the array of values. **The array is reordered.**
+ * @param n Number of values in the array.
+ * @param k Rank of the element to return. Must be lower than `n`.
+ * @return uint32_t Element of rank `k`.
+ */
+uint32_t median_filter_quickselect(uint32_t *p_values, uint32_t n, uint32_t k);
+
+/**
+ * @brief Return the median of an array of values.
+ *
+ * The median is the element of rank `n / 2`, i.e. the upper median if `n` is even. Sizes 3, 5, 7 and 9 use a branchless sorting network, any other size falls back to `median_filter_quickselect()`.
+ *
+ * @param p_values Pointer to the array of values. **The array is reordered.**
+ * @param n Number of values in the array. If it is 0, the function returns 0.
+ * @return uint32_t Median of the values.
+ */
+uint32_t median_filter_select(uint32_t *p_values, uint32_t n);
+
+#endif /* MEDIAN_FILTER_H_ */
@@ -0,0 +1,96 @@
+/**
+ * @file output_conditioner.h
+ * @brief Header for output_conditioner.c file.
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+
+#ifndef OUTPUT_CONDITIONER_H_
+#define OUTPUT_CONDITIONER_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/**
+ * @brief Maximum number of zone boundaries of a conditioner.
+ *
+ */
+#define OUTPUT_CONDITIONER_MAX_BOUNDARIES 8
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Boundary between two zones of distances, with its hysteresis.
+ *
+ */
+typedef struct
+{
+    uint32_t max_cm;        /*!< Last distance in cm of the zone below the boundary. The zone above starts at `max_cm + 1` */
+    uint32_t hysteresis_cm; /*!< Distance in cm that a measurement must go past the boundary to change to the farther zone */
+} output_conditioner_boundary_t;
+
+/**
+ * @brief Conditioner of the distances shown by an output (display, buzzer...).
+ *
+ * It filters the distances before they reach the output, so that an output is only updated when the change is meaningful. The fields must not be modified by the user.
+ *
+ */
+typedef struct
+{
+    output_conditioner_boundary_t boundaries[OUTPUT_CONDITIONER_MAX_BOUNDARIES]; /*!< Zone boundaries, sorted by distance */
+    uint32_t num_boundaries;    /*!< Number of boundaries. There is one zone more than boundaries */
+    uint32_t deadband_cm;       /*!< Change in cm inside a zone that is ignored */
+    uint32_t hold_ms;           /*!< Minimum time in ms in a zone before changing to a farther one */
+    uint32_t zone;              /*!< Current zone, from 0 to `num_boundaries` */
+    uint32_t distance_cm;       /*!< Last distance in cm returned */
+    uint32_t zone_start_ms;     /*!< Time in ms when the current zone was entered */
+    bool valid;                 /*!< Flag to indicate if a distance has been returned since the last reset */
+} output_conditioner_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Initialize a conditioner.
+ *
+ * With no boundaries, no deadband and no hold time the distances are not changed.
+ *
+ * @param p_cond Pointer to the conditioner.
+ * @param p_boundaries Array of boundaries sorted by increasing `max_cm`, or NULL if `num_boundaries` is 0.
+ * @param num_boundaries Number of boundaries, from 0 to `OUTPUT_CONDITIONER_MAX_BOUNDARIES`.
+ * @param deadband_cm Change in cm of the distance inside a zone that is ignored. 0 to follow every change.
+ * @param hold_ms Minimum time in ms in a zone before changing to a farther one. 0 to change at once.
+ * @return true If the configuration is valid.
+ * @return false Otherwise. The conditioner is not changed.
+ */
+bool output_conditioner_init(output_conditioner_t *p_cond, const output_conditioner_boundary_t *p_boundaries, uint32_t num_boundaries, uint32_t deadband_cm, uint32_t hold_ms);
+
+/**
+ * @brief Forget the last distance of a conditioner. The next distance is returned as it is.
+ *
+ * @param p_cond Pointer to the conditioner.
+ */
+void output_conditioner_reset(output_conditioner_t *p_cond);
+
+/**
+ * @brief Condition a new distance.
+ *
+ * A closer zone is entered as soon as the distance is inside it. A farther zone is only entered if the distance goes past the boundary by more than its hysteresis, and if the current zone has been held for `hold_ms`; meanwhile, the distance returned is kept at the edge of the current zone. Inside a zone, changes up to `deadband_cm` are ignored.
+ *
+ * @param p_cond Pointer to the conditioner.
+ * @param distance_cm Distance in cm measured.
+ * @param now_ms Current time in ms.
+ * @return uint32_t Distance in cm to show in the output. The output only has to be updated if it differs from the previous one.
+ */
+uint32_t output_conditioner_update(output_conditioner_t *p_cond, uint32_t distance_cm, uint32_t now_ms);
+
+/**
+ * @brief Get the current zone of a conditioner.
+ *
+ * @param p_cond Pointer to the conditioner.
+ * @return uint32_t Current zone, from 0 (below the first boundary) to `num_boundaries`.
+ */
+uint32_t output_conditioner_get_zone(const output_conditioner_t *p_cond);
+
+#endif /* OUTPUT_CONDITIONER_H_ */
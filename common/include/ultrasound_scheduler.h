@@ -0,0 +1,155 @@
+/**
+ * @file ultrasound_scheduler.h
+ * @brief Header for ultrasound_scheduler.c file.
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+
+#ifndef ULTRASOUND_SCHEDULER_H_
+#define ULTRASOUND_SCHEDULER_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/**
+ * @brief Maximum number of ultrasound sensors handled by a scheduler.
+ *
+ */
+#define ULTRASOUND_SCHEDULER_MAX_SENSORS 8
+
+/**
+ * @brief Default guard interval in ms between the end of the measurements of a group and the trigger of the next group.
+ *
+ * It lets the residual echoes of the previous pings (multiple reflections) fade out before the next sensors listen.
+ *
+ */
+#define ULTRASOUND_SCHEDULER_GUARD_MS 10
+
+/**
+ * @enum ULTRASOUND_SCHEDULER_PHASE
+ *
+ * @brief Phase of the trigger timeline of a scheduler.
+ */
+enum ULTRASOUND_SCHEDULER_PHASE {
+    ULTRASOUND_SCHEDULER_IDLE = 0,  /**< No group has been triggered yet */
+    ULTRASOUND_SCHEDULER_MEASURING, /**< The sensors of the current group are measuring */
+    ULTRASOUND_SCHEDULER_GUARD      /**< The current group has finished and the guard interval is running */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Statistics of a sensor handled by a scheduler, since the last reset of the statistics.
+ *
+ */
+typedef struct
+{
+    uint32_t measurements;      /*!< Number of measurements completed */
+    uint32_t rate_mhz;          /*!< Achieved measurement rate in mHz (measurements per 1000 s) */
+    uint32_t max_interval_ms;   /*!< Longest time in ms between two consecutive triggers of the sensor */
+} ultrasound_scheduler_stats_t;
+
+/**
+ * @brief Time-division scheduler of the triggers of several ultrasound sensors.
+ *
+ * The sensors are identified by their position along the bumper (0 to `num_sensors - 1`), so that sensors `i` and `i + 1` are neighbours. The fields must not be modified by the user.
+ *
+ */
+typedef struct
+{
+    uint32_t num_sensors;                                   /*!< Number of sensors */
+    uint32_t num_groups;                                    /*!< Number of groups of sensors */
+    uint32_t guard_ms;                                      /*!< Guard interval in ms between groups */
+    uint32_t group_mask[ULTRASOUND_SCHEDULER_MAX_SENSORS];  /*!< Sensors of each group (bit `i` is sensor `i`) */
+    uint32_t enabled_mask;                                  /*!< Sensors that can be triggered */
+    uint32_t group;                                         /*!< Current group */
+    uint32_t fired_mask;                                    /*!< Sensors triggered in the current group */
+    uint8_t phase;                                          /*!< Phase of the timeline. One of `ULTRASOUND_SCHEDULER_PHASE` */
+    uint32_t guard_start_ms;                                /*!< Time in ms when the guard interval started */
+    uint32_t stats_start_ms;                                /*!< Time in ms when the statistics were reset */
+    uint32_t measurements[ULTRASOUND_SCHEDULER_MAX_SENSORS];    /*!< Measurements completed by each sensor */
+    uint32_t last_fire_ms[ULTRASOUND_SCHEDULER_MAX_SENSORS];    /*!< Time in ms of the last trigger of each sensor */
+    uint32_t max_interval_ms[ULTRASOUND_SCHEDULER_MAX_SENSORS]; /*!< Longest time in ms between two triggers of each sensor */
+    uint32_t fire_count[ULTRASOUND_SCHEDULER_MAX_SENSORS];      /*!< Triggers of each sensor */
+} ultrasound_scheduler_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Initialize a scheduler with interleaved groups.
+ *
+ * Sensor `i` belongs to group `i % num_groups`, so neighbouring sensors never fire together if there are at least 2 groups. 2 groups give the highest aggregate rate; more groups leave more distance between the sensors that fire together, if the crosstalk reaches beyond the closest neighbours. All the sensors are enabled.
+ *
+ * @param p_sched Pointer to the scheduler.
+ * @param num_sensors Number of sensors, from 1 to `ULTRASOUND_SCHEDULER_MAX_SENSORS`.
+ * @param num_groups Number of groups, from 1 to `num_sensors`. It must be at least 2 if there is more than one sensor.
+ * @param guard_ms Guard interval in ms between the end of a group and the trigger of the next one.
+ * @param now_ms Current time in ms. The statistics start at this time.
+ * @return true If the configuration is valid.
+ * @return false Otherwise. The scheduler must not be used.
+ */
+bool ultrasound_scheduler_init(ultrasound_scheduler_t *p_sched, uint32_t num_sensors, uint32_t num_groups, uint32_t guard_ms, uint32_t now_ms);
+
+/**
+ * @brief Set the sensors of the groups of a scheduler.
+ *
+ * The groups are triggered in the order of the array. The timeline restarts from the first group.
+ *
+ * @param p_sched Pointer to the scheduler.
+ * @param p_group_mask Array of masks with the sensors of each group (bit `i` is sensor `i`).
+ * @param num_groups Number of groups, from 1 to `num_sensors`.
+ * @return true If every sensor belongs to exactly one group and no group contains two neighbouring sensors.
+ * @return false Otherwise. The groups are not changed.
+ */
+bool ultrasound_scheduler_set_groups(ultrasound_scheduler_t *p_sched, const uint32_t *p_group_mask, uint32_t num_groups);
+
+/**
+ * @brief Set the sensors that can be triggered. Disabled sensors are skipped and the groups left empty take no time.
+ *
+ * @param p_sched Pointer to the scheduler.
+ * @param enabled_mask Mask of the enabled sensors (bit `i` is sensor `i`).
+ */
+void ultrasound_scheduler_set_enabled(ultrasound_scheduler_t *p_sched, uint32_t enabled_mask);
+
+/**
+ * @brief Advance the trigger timeline of a scheduler.
+ *
+ * It must be called periodically (e.g. in the main loop). The next group is triggered as soon as all the sensors of the current group have finished their measurements and the guard interval has elapsed, so the sensors measure as often as the rules allow.
+ *
+ * @param p_sched Pointer to the scheduler.
+ * @param now_ms Current time in ms.
+ * @param busy_mask Mask of the sensors that are measuring (bit `i` is sensor `i`).
+ * @return uint32_t Mask of the sensors that must be triggered now.
+ */
+uint32_t ultrasound_scheduler_update(ultrasound_scheduler_t *p_sched, uint32_t now_ms, uint32_t busy_mask);
+
+/**
+ * @brief Get the statistics of a sensor since the last reset.
+ *
+ * @param p_sched Pointer to the scheduler.
+ * @param sensor Position of the sensor.
+ * @param now_ms Current time in ms.
+ * @param p_stats Pointer to the structure where the statistics are stored.
+ */
+void ultrasound_scheduler_get_stats(const ultrasound_scheduler_t *p_sched, uint32_t sensor, uint32_t now_ms, ultrasound_scheduler_stats_t *p_stats);
+
+/**
+ * @brief Get the aggregate measurement rate of all the sensors since the last reset.
+ *
+ * @param p_sched Pointer to the scheduler.
+ * @param now_ms Current time in ms.
+ * @return uint32_t Aggregate rate in mHz (measurements per 1000 s).
+ */
+uint32_t ultrasound_scheduler_get_total_rate_mhz(const ultrasound_scheduler_t *p_sched, uint32_t now_ms);
+
+/**
+ * @brief Reset the statistics of all the sensors.
+ *
+ * @param p_sched Pointer to the scheduler.
+ * @param now_ms Current time in ms.
+ */
+void ultrasound_scheduler_reset_stats(ultrasound_scheduler_t *p_sched, uint32_t now_ms);
+
+#endif /* ULTRASOUND_SCHEDULER_H_ */
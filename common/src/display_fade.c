@@ -0,0 +1,123 @@
+/**
+ * @file display_fade.c
+ * @brief Sequences of colors of the displays: fades between colors and pulses.
+ *
+ * The sequences are built once by the CPU and then played by the HW of the display (see `port_display_play()`), one frame per period of the PWM.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Project includes */
+#include "display_fade.h"
+
+/* Private functions -----------------------------------------------------------*/
+/**
+ * @brief Integer square root.
+ *
+ * @param value Value.
+ * @return uint32_t Largest integer whose square is not greater than `value`.
+ */
+static uint32_t _isqrt(uint32_t value)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1U << 30;
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/**
+ * @brief Interpolate a channel in the perceptual scale.
+ *
+ * @param from Perceived brightness at step 0.
+ * @param to Perceived brightness at step `steps`.
+ * @param step Step, from 0 to `steps`.
+ * @param steps Number of steps.
+ * @return uint8_t Level of the LED at `step`.
+ */
+static uint8_t _interp(uint32_t from, uint32_t to, uint32_t step, uint32_t steps)
+{
+    int32_t perceptual = (int32_t)from + ((int32_t)to - (int32_t)from) * (int32_t)step / (int32_t)steps;
+    return (uint8_t)display_fade_from_perceptual((uint32_t)perceptual);
+}
+
+/* Public functions -----------------------------------------------------------*/
+uint32_t display_fade_to_perceptual(uint32_t level)
+{
+    return _isqrt(level * PORT_DISPLAY_RGB_MAX_VALUE);
+}
+
+uint32_t display_fade_from_perceptual(uint32_t perceptual)
+{
+    return (perceptual * perceptual + PORT_DISPLAY_RGB_MAX_VALUE / 2) / PORT_DISPLAY_RGB_MAX_VALUE;
+}
+
+uint32_t display_fade_build(rgb_color_t *p_frames, rgb_color_t from, rgb_color_t to, uint32_t num_frames)
+{
+    if (num_frames == 0)
+    {
+        num_frames = 1;
+    }
+    if (num_frames > DISPLAY_FADE_MAX_FRAMES)
+    {
+        num_frames = DISPLAY_FADE_MAX_FRAMES;
+    }
+    uint32_t r0 = display_fade_to_perceptual(from.r), r1 = display_fade_to_perceptual(to.r);
+    uint32_t g0 = display_fade_to_perceptual(from.g), g1 = display_fade_to_perceptual(to.g);
+    uint32_t b0 = display_fade_to_perceptual(from.b), b1 = display_fade_to_perceptual(to.b);
+    for (uint32_t i = 0; i < num_frames - 1; i++)
+    {
+        p_frames[i] = (rgb_color_t){_interp(r0, r1, i + 1, num_frames), _interp(g0, g1, i + 1, num_frames), _interp(b0, b1, i + 1, num_frames)};
+    }
+    // The rounding of the perceptual scale must not change the final color
+    p_frames[num_frames - 1] = to;
+    return num_frames;
+}
+
+uint32_t display_fade_build_pulse(rgb_color_t *p_frames, rgb_color_t color, uint32_t num_frames)
+{
+    if (num_frames < 2)
+    {
+        num_frames = 2;
+    }
+    if (num_frames > DISPLAY_FADE_MAX_FRAMES)
+    {
+        num_frames = DISPLAY_FADE_MAX_FRAMES;
+    }
+    uint32_t r = display_fade_to_perceptual(color.r);
+    uint32_t g = display_fade_to_perceptual(color.g);
+    uint32_t b = display_fade_to_perceptual(color.b);
+    uint32_t half = num_frames / 2;
+    p_frames[0] = color;
+    for (uint32_t i = 1; i < num_frames; i++)
+    {
+        // Triangle: down from the color to the dimmest frame at `half`, and up again until frame `num_frames` (the first frame of the next period)
+        uint32_t step = (i <= half) ? i : num_frames - i;
+        uint32_t steps = (i <= half) ? half : num_frames - half;
+        p_frames[i] = (rgb_color_t){_interp(r, r * DISPLAY_FADE_PULSE_DIM_PERCENT / 100, step, steps),
+                                    _interp(g, g * DISPLAY_FADE_PULSE_DIM_PERCENT / 100, step, steps),
+                                    _interp(b, b * DISPLAY_FADE_PULSE_DIM_PERCENT / 100, step, steps)};
+    }
+    return num_frames;
+}
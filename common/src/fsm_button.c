@@ -55,6 +55,18 @@ struct fsm_button_t
      */
     uint32_t duration;
 
+    /**
+     * @brief Time in ms at which the transitions are checked: the timestamp of the event being processed, or the current time.
+     * 
+     */
+    uint32_t now_ms;
+
+    /**
+     * @brief Number of events lost by the queue of the button the last time it was checked.
+     * 
+     */
+    uint32_t event_overflows;
+
     /**
      * @brief Button ID. Must be unique.
      * 
@@ -102,7 +114,7 @@ static bool check_button_released(fsm_t *p_this)
 static bool check_timeout(fsm_t *p_this)
 {
     fsm_button_t *p_fsm = (fsm_button_t *)(p_this);
-    return port_system_get_millis() > p_fsm->next_timeout;
+    return p_fsm->now_ms > p_fsm->next_timeout;
 }
 
 /**
@@ -113,7 +125,7 @@ static bool check_timeout(fsm_t *p_this)
 static void do_store_tick_pressed(fsm_t *p_this)
 {
     fsm_button_t *p_fsm = (fsm_button_t *)(p_this);
-    uint32_t tiempo = port_system_get_millis();
+    uint32_t tiempo = p_fsm->now_ms;
     p_fsm->tick_pressed = tiempo;
     p_fsm->next_timeout = tiempo + p_fsm->debounce_time_ms;
 }
@@ -126,7 +138,7 @@ static void do_store_tick_pressed(fsm_t *p_this)
 static void do_set_duration(fsm_t *p_this)
 {
     fsm_button_t *p_fsm = (fsm_button_t *)(p_this);
-    uint32_t tiempo = port_system_get_millis();
+    uint32_t tiempo = p_fsm->now_ms;
     p_fsm->duration = tiempo - p_fsm->tick_pressed;
     p_fsm->next_timeout = tiempo + p_fsm->debounce_time_ms;
 }
@@ -178,8 +190,10 @@ void fsm_button_init(fsm_button_t *p_fsm_button, uint32_t debounce_time, uint32_
     p_fsm_button->button_id = button_id;
     p_fsm_button->tick_pressed = 0;
     p_fsm_button->duration = 0;
+    p_fsm_button->now_ms = port_system_get_millis();
     
     port_button_init(button_id);
+    p_fsm_button->event_overflows = port_button_get_event_overflows(button_id);
 }
 
 /* Public functions -----------------------------------------------------------*/
@@ -195,6 +209,23 @@ fsm_button_t *fsm_button_new(uint32_t debounce_time, uint32_t button_id)
 
 void fsm_button_fire(fsm_button_t *p_fsm)
 {
+    // The interrupt only queues its events: each one is applied and checked at the time it happened
+    port_event_t event;
+    while (port_button_pop_event(p_fsm->button_id, &event))
+    {
+        p_fsm->now_ms = event.timestamp_ms;
+        fsm_fire(&p_fsm->f); // A debounce time that expired before the event
+        port_button_set_pressed(p_fsm->button_id, event.type == PORT_BUTTON_EVENT_PRESSED);
+        fsm_fire(&p_fsm->f);
+    }
+    p_fsm->now_ms = port_system_get_millis();
+    uint32_t event_overflows = port_button_get_event_overflows(p_fsm->button_id);
+    if (event_overflows != p_fsm->event_overflows)
+    {
+        // The queue was full, so the newest events (the settled level) were lost: read the level from the GPIO, which is active low as in the ISR
+        p_fsm->event_overflows = event_overflows;
+        port_button_set_pressed(p_fsm->button_id, !port_button_get_value(p_fsm->button_id));
+    }
     fsm_fire(&p_fsm->f); // Is it also possible to it in this way: fsm_fire((fsm_t *)p_fsm);
 }
 
@@ -61,6 +61,18 @@ struct fsm_buzzer_t
      *
      */
     uint32_t buzzer_id;
+
+    /**
+     * @brief Last sound level set in the buzzer.
+     *
+     */
+    uint8_t sound;
+
+    /**
+     * @brief Conditioner of the distances set, so that the tone does not chatter with changes that are only noise.
+     *
+     */
+    output_conditioner_t conditioner;
 };
 
 /* Private functions -----------------------------------------------------------*/
@@ -136,10 +148,11 @@ static void do_set_on(fsm_t *p_this)
 {
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
     port_buzzer_set_sound(p_fsm->buzzer_id, PORT_BUZZER_MIN_VALUE);
+    p_fsm->sound = PORT_BUZZER_MIN_VALUE;
 }
 
 /**
- * @brief Turn the buzzer system ON for the first time.
+ * @brief Set the sound of the distance. The buzzer is not reprogrammed if the sound level does not change.
  *
  * @param p_this Pointer to an `fsm_t` struct than contains an `fsm_buzzer_t`.
  */
@@ -147,7 +160,11 @@ static void do_set_sound(fsm_t *p_this)
 {
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
     uint8_t sound = _compute_buzzer_levels(p_fsm->distance_cm);
-    port_buzzer_set_sound(p_fsm->buzzer_id, sound);
+    if (sound != p_fsm->sound)
+    {
+        port_buzzer_set_sound(p_fsm->buzzer_id, sound);
+        p_fsm->sound = sound;
+    }
     p_fsm->new_sound = false;
     p_fsm->idle = true;
 }
@@ -161,6 +178,9 @@ static void do_set_off(fsm_t *p_this)
 {
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
     port_buzzer_set_sound(p_fsm->buzzer_id, PORT_BUZZER_MIN_VALUE);
+    p_fsm->sound = PORT_BUZZER_MIN_VALUE;
+    p_fsm->distance_cm = -1;
+    output_conditioner_reset(&p_fsm->conditioner);
     p_fsm->idle = false;
 }
 
@@ -200,6 +220,8 @@ static void fsm_buzzer_init(fsm_buzzer_t *p_fsm_buzzer, uint32_t buzzer_id)
     p_fsm_buzzer->new_sound = false;
     p_fsm_buzzer->status = false;
     p_fsm_buzzer->idle = false;
+    p_fsm_buzzer->sound = PORT_BUZZER_MIN_VALUE;
+    output_conditioner_init(&p_fsm_buzzer->conditioner, NULL, 0, 0, 0);
     port_buzzer_init(buzzer_id);
 }
 
@@ -221,10 +243,24 @@ void fsm_buzzer_fire(fsm_buzzer_t *p_fsm)
     fsm_fire(&p_fsm->f); // Is it also possible to it in this way: fsm_fire((fsm_t *)p_fsm);
 }
 
+bool fsm_buzzer_set_conditioning(fsm_buzzer_t *p_fsm, const output_conditioner_boundary_t *p_boundaries, uint32_t num_boundaries, uint32_t deadband_cm, uint32_t hold_ms)
+{
+    return output_conditioner_init(&p_fsm->conditioner, p_boundaries, num_boundaries, deadband_cm, hold_ms);
+}
+
 void fsm_buzzer_set_distance(fsm_buzzer_t *p_fsm, uint32_t distance_cm)
 {
-    p_fsm->distance_cm = distance_cm;
-    p_fsm->new_sound = true;
+    distance_cm = output_conditioner_update(&p_fsm->conditioner, distance_cm, port_system_get_millis());
+    if (distance_cm != (uint32_t)p_fsm->distance_cm)
+    {
+        p_fsm->distance_cm = distance_cm;
+        p_fsm->new_sound = true;
+    }
+}
+
+uint32_t fsm_buzzer_get_distance(fsm_buzzer_t *p_fsm)
+{
+    return p_fsm->distance_cm;
 }
 
 bool fsm_buzzer_get_status(fsm_buzzer_t *p_fsm)
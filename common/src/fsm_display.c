@@ -18,6 +18,7 @@
 /* Project includes */
 #include "fsm.h"
 #include "fsm_display.h"
+#include "display_fade.h"
 
 /* Typedefs --------------------------------------------------------------------*/
 /**
@@ -61,6 +62,62 @@ struct fsm_display_t
      *
      */
     uint32_t display_id;
+
+    /**
+     * @brief Color of every distance in cm from 0 to `FSM_DISPLAY_LUT_SIZE - 1`, computed from the color profile (see `fsm_display_set_profile()`).
+     *
+     */
+    rgb_color_t color_lut[FSM_DISPLAY_LUT_SIZE];
+
+    /**
+     * @brief Last distance in cm of the first zone of the color profile (the danger zone).
+     *
+     */
+    uint32_t danger_max_cm;
+
+    /**
+     * @brief Number of frames of the fade between two colors. 0 to change the color at once.
+     *
+     */
+    uint32_t fade_frames;
+
+    /**
+     * @brief Number of frames of a period of the pulse of the danger zone. 0 to not pulse.
+     *
+     */
+    uint32_t pulse_frames;
+
+    /**
+     * @brief Last color set in the display. With fades, it is the color at the end of the fade.
+     *
+     */
+    rgb_color_t color;
+
+    /**
+     * @brief Flag to indicate if the display is pulsing.
+     *
+     */
+    bool pulsing;
+
+    /**
+     * @brief Conditioner of the distances set, so that the color is not recomputed for changes that are only noise.
+     *
+     */
+    output_conditioner_t conditioner;
+};
+
+/* Global variables ------------------------------------------------------------*/
+/**
+ * @brief Default color profile of the displays.
+ *
+ */
+static const fsm_display_zone_t default_zones_arr[] = {
+    {.max_cm = DANGER_MIN_CM, .color_min = COLOR_RED, .color_max = COLOR_RED},
+    {.max_cm = WARNING_MIN_CM, .color_min = COLOR_RED, .color_max = COLOR_YELLOW},
+    {.max_cm = NO_PROBLEM_MIN_CM, .color_min = COLOR_YELLOW, .color_max = COLOR_GREEN},
+    {.max_cm = INFO_MIN_CM, .color_min = COLOR_GREEN, .color_max = COLOR_TURQUOISE},
+    {.max_cm = OK_MIN_CM, .color_min = COLOR_TURQUOISE, .color_max = COLOR_BLUE},
+    {.max_cm = OK_MAX_CM, .color_min = COLOR_BLUE, .color_max = COLOR_OFF},
 };
 
 /* Private functions -----------------------------------------------------------*/
@@ -85,43 +142,70 @@ rgb_color_t _linear_interp(rgb_color_t color_inf, rgb_color_t color_sup, int32_t
 }
 
 /**
- * @brief Set color levels of the RGB LEDs according to the distance.
+ * @brief Fill the distance-to-color lookup table of a display from a table of zones.
  *
- * This function sets the levels of an RGB LED according to the distance measured by the ultrasound sensor. This RGB LED structure is later passed to the `port_display_set_rgb()` function to set the color of the RGB LED.
+ * The colors are interpolated with `_linear_interp()` once per cm here, instead of every time the color changes.
  *
- * @param p_color Pointer to an `rgb_color_t` struct that will store the levels of the RGB LED.
- * @param distance_cm Distance measured by the ultrasound sensor in centimeters.
+ * @param p_fsm Pointer to an `fsm_display_t` struct.
+ * @param p_zones Array of zones. They must have been validated.
+ * @param num_zones Number of zones.
  */
-void _compute_display_levels(rgb_color_t *p_color, int32_t distance_cm)
+static void _build_color_lut(fsm_display_t *p_fsm, const fsm_display_zone_t *p_zones, uint32_t num_zones)
 {
-    if ((distance_cm >= HIGH_DANGER_MIN_CM) && (distance_cm <= DANGER_MIN_CM))
-    {
-        *p_color = COLOR_RED;
-    }
-    else if ((distance_cm > DANGER_MIN_CM) && (distance_cm <= WARNING_MIN_CM))
+    uint32_t distance_cm = 0;
+    uint32_t min_cm = 0;
+    for (uint32_t i = 0; i < num_zones; i++)
     {
-        *p_color = _linear_interp(COLOR_RED, COLOR_YELLOW, DANGER_MIN_CM, WARNING_MIN_CM, distance_cm);
+        const fsm_display_zone_t *p_zone = &p_zones[i];
+        for (; distance_cm <= p_zone->max_cm; distance_cm++)
+        {
+            // A zone of a single cm has the color of its end
+            p_fsm->color_lut[distance_cm] = (p_zone->max_cm == min_cm) ? p_zone->color_max : _linear_interp(p_zone->color_min, p_zone->color_max, min_cm, p_zone->max_cm, distance_cm);
+        }
+        min_cm = p_zone->max_cm;
     }
-    else if ((distance_cm > WARNING_MIN_CM) && (distance_cm <= NO_PROBLEM_MIN_CM))
+    for (; distance_cm < FSM_DISPLAY_LUT_SIZE; distance_cm++)
     {
-        *p_color = _linear_interp(COLOR_YELLOW, COLOR_GREEN, WARNING_MIN_CM, NO_PROBLEM_MIN_CM, distance_cm);
+        p_fsm->color_lut[distance_cm] = COLOR_OFF;
     }
-    else if ((distance_cm > NO_PROBLEM_MIN_CM) && (distance_cm <= INFO_MIN_CM))
-    {
-        *p_color = _linear_interp(COLOR_GREEN, COLOR_TURQUOISE, NO_PROBLEM_MIN_CM, INFO_MIN_CM, distance_cm);
-    }
-    else if ((distance_cm > INFO_MIN_CM) && (distance_cm <= OK_MIN_CM))
+}
+
+/**
+ * @brief Show a color on a display, with a fade from the color being shown or with a pulse if requested.
+ *
+ * Nothing is written to the HW if neither the color nor the pulse change. In particular, a pulse is not restarted by every new distance in the danger zone.
+ *
+ * @param p_fsm Pointer to an `fsm_display_t` struct.
+ * @param color Color to show.
+ * @param pulse `true` to pulse the color, if the pulse is enabled.
+ */
+static void _show_color(fsm_display_t *p_fsm, rgb_color_t color, bool pulse)
+{
+    pulse = pulse && (p_fsm->pulse_frames > 0);
+    if ((color.r == p_fsm->color.r) && (color.g == p_fsm->color.g) && (color.b == p_fsm->color.b) && (pulse == p_fsm->pulsing))
     {
-        *p_color = _linear_interp(COLOR_TURQUOISE, COLOR_BLUE, INFO_MIN_CM, OK_MIN_CM, distance_cm);
+        return;
     }
-    else if ((distance_cm > OK_MIN_CM) && (distance_cm <= OK_MAX_CM))
+    if ((p_fsm->fade_frames == 0) && !pulse)
     {
-        *p_color = _linear_interp(COLOR_BLUE, COLOR_OFF, OK_MIN_CM, OK_MAX_CM, distance_cm);
+        port_display_set_rgb(p_fsm->display_id, color);
     }
     else
     {
-        *p_color = COLOR_OFF;
+        rgb_color_t frames[DISPLAY_FADE_MAX_FRAMES];
+        uint32_t num_frames;
+        if (pulse)
+        {
+            num_frames = display_fade_build_pulse(frames, color, p_fsm->pulse_frames);
+        }
+        else
+        {
+            num_frames = display_fade_build(frames, port_display_get_rgb(p_fsm->display_id), color, p_fsm->fade_frames);
+        }
+        port_display_play(p_fsm->display_id, frames, num_frames, pulse);
     }
+    p_fsm->color = color;
+    p_fsm->pulsing = pulse;
 }
 
 /* State machine input or transition functions */
@@ -174,19 +258,23 @@ static void do_set_on(fsm_t *p_this)
 {
     fsm_display_t *p_fsm = (fsm_display_t *)(p_this);
     port_display_set_rgb(p_fsm->display_id, COLOR_OFF);
+    p_fsm->color = COLOR_OFF;
+    p_fsm->pulsing = false;
 }
 
 /**
- * @brief Turn the display system ON for the first time.
+ * @brief Show the color of the distance, read from the lookup table of the display.
+ *
+ * Distances out of the table (including a negative distance, i.e. no distance set) are shown as `COLOR_OFF`. The color fades from the previous one and pulses in the danger zone if they are enabled (see `fsm_display_set_fade()`).
  *
  * @param p_this Pointer to an `fsm_t` struct than contains an `fsm_display_t`.
  */
 static void do_set_color(fsm_t *p_this)
 {
     fsm_display_t *p_fsm = (fsm_display_t *)(p_this);
-    rgb_color_t p_color = COLOR_OFF;
-    _compute_display_levels(&p_color, p_fsm->distance_cm);
-    port_display_set_rgb(p_fsm->display_id, p_color);
+    uint32_t distance_cm = (uint32_t)p_fsm->distance_cm;
+    rgb_color_t color = (distance_cm < FSM_DISPLAY_LUT_SIZE) ? p_fsm->color_lut[distance_cm] : COLOR_OFF;
+    _show_color(p_fsm, color, distance_cm <= p_fsm->danger_max_cm);
     p_fsm->new_color = false;
     p_fsm->idle = true;
 }
@@ -200,6 +288,10 @@ static void do_set_off(fsm_t *p_this)
 {
     fsm_display_t *p_fsm = (fsm_display_t *)(p_this);
     port_display_set_rgb(p_fsm->display_id, COLOR_OFF);
+    p_fsm->color = COLOR_OFF;
+    p_fsm->pulsing = false;
+    p_fsm->distance_cm = -1;
+    output_conditioner_reset(&p_fsm->conditioner);
     p_fsm->idle = false;
 }
 
@@ -239,6 +331,12 @@ static void fsm_display_init(fsm_display_t *p_fsm_display, uint32_t display_id)
     p_fsm_display->new_color = false;
     p_fsm_display->status = false;
     p_fsm_display->idle = false;
+    p_fsm_display->fade_frames = 0;
+    p_fsm_display->pulse_frames = 0;
+    p_fsm_display->color = COLOR_OFF;
+    p_fsm_display->pulsing = false;
+    output_conditioner_init(&p_fsm_display->conditioner, NULL, 0, 0, 0);
+    fsm_display_set_profile(p_fsm_display, NULL, 0);
     port_display_init(display_id);
 }
 
@@ -260,10 +358,48 @@ void fsm_display_fire(fsm_display_t *p_fsm)
     fsm_fire(&p_fsm->f); // Is it also possible to it in this way: fsm_fire((fsm_t *)p_fsm);
 }
 
+bool fsm_display_set_profile(fsm_display_t *p_fsm, const fsm_display_zone_t *p_zones, uint32_t num_zones)
+{
+    if (p_zones == NULL)
+    {
+        p_zones = default_zones_arr;
+        num_zones = sizeof(default_zones_arr) / sizeof(default_zones_arr[0]);
+    }
+    if ((num_zones == 0) || (p_zones[num_zones - 1].max_cm >= FSM_DISPLAY_LUT_SIZE))
+    {
+        return false;
+    }
+    for (uint32_t i = 1; i < num_zones; i++)
+    {
+        if (p_zones[i].max_cm <= p_zones[i - 1].max_cm)
+        {
+            return false;
+        }
+    }
+    _build_color_lut(p_fsm, p_zones, num_zones);
+    p_fsm->danger_max_cm = p_zones[0].max_cm;
+    return true;
+}
+
+void fsm_display_set_fade(fsm_display_t *p_fsm, uint32_t fade_ms, uint32_t pulse_period_ms)
+{
+    p_fsm->fade_frames = fade_ms / PORT_DISPLAY_FRAME_MS;
+    p_fsm->pulse_frames = pulse_period_ms / PORT_DISPLAY_FRAME_MS;
+}
+
+bool fsm_display_set_conditioning(fsm_display_t *p_fsm, const output_conditioner_boundary_t *p_boundaries, uint32_t num_boundaries, uint32_t deadband_cm, uint32_t hold_ms)
+{
+    return output_conditioner_init(&p_fsm->conditioner, p_boundaries, num_boundaries, deadband_cm, hold_ms);
+}
+
 void fsm_display_set_distance(fsm_display_t *p_fsm, uint32_t distance_cm)
 {
-    p_fsm->distance_cm = distance_cm;
-    p_fsm->new_color = true;
+    distance_cm = output_conditioner_update(&p_fsm->conditioner, distance_cm, port_system_get_millis());
+    if (distance_cm != (uint32_t)p_fsm->distance_cm)
+    {
+        p_fsm->distance_cm = distance_cm;
+        p_fsm->new_color = true;
+    }
 }
 
 bool fsm_display_get_status(fsm_display_t *p_fsm)
@@ -19,6 +19,8 @@
 /* Project includes */
 #include "fsm.h"
 #include "fsm_ultrasound.h"
+#include "median_filter.h"
+#include "measurement_bus.h"
 
 /* Typedefs --------------------------------------------------------------------*/
 /**
@@ -58,7 +60,13 @@ struct fsm_ultrasound_t
     uint32_t ultrasound_id;
 
     /**
-     * @brief Array to store the last distance measurements.
+     * @brief Distance in mm of the last object detected (median of the window), before truncating it to `distance_cm`.
+     *
+     */
+    uint32_t distance_mm;
+
+    /**
+     * @brief Array to store the last distance measurements in mm.
      *
      */
     uint32_t distance_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS];
@@ -69,25 +77,530 @@ struct fsm_ultrasound_t
      */
     uint32_t distance_idx;
 
+    /**
+     * @brief Number of measurements stored in the window since the last start.
+     *
+     */
+    uint32_t distance_count;
+
+    /**
+     * @brief Time in ms when the last measurement was started. It is used to detect lost echoes.
+     *
+     */
+    uint32_t measurement_start_ms;
+
+    /**
+     * @brief Tick of the echo timebase when the last measurement was started. It timestamps the measurements without echo.
+     *
+     */
+    uint32_t measurement_start_tick;
+
+    /**
+     * @brief Ticks of the echo timer per microsecond (see `port_ultrasound_get_echo_ticks_per_us()`).
+     *
+     */
+    uint32_t echo_ticks_per_us;
+
+    /**
+     * @brief Distance in mm travelled by the sound (there and back) during one tick of the echo timer, in Q0.32 fixed point. It is updated only when the temperature changes.
+     *
+     */
+    uint32_t mm_per_tick_q32;
+
+    /**
+     * @brief Temperature of the air in degrees Celsius used to compute `mm_per_tick_q32`.
+     *
+     */
+    int32_t temperature_c;
+
+    /**
+     * @brief Range of interest in cm. Longer echoes are abandoned.
+     *
+     */
+    uint32_t max_range_cm;
+
+    /**
+     * @brief Duration in ticks of the echo timer of an echo of an obstacle at `max_range_cm`. It is computed once when the range is set.
+     *
+     */
+    uint32_t max_range_ticks;
+
+    /**
+     * @brief Time in ms since the start of a measurement after which its echo signal is considered lost. It is computed with `max_range_ticks`, so that the echo of an obstacle in the range of interest never times out.
+     *
+     */
+    uint32_t echo_timeout_ms;
+
+    /**
+     * @brief Current period in ms between measurements.
+     *
+     */
+    uint32_t measurement_period_ms;
+
+    /**
+     * @brief Last distance in cm added to the window, used to check the stability of the measurements.
+     *
+     */
+    uint32_t last_distance_cm;
+
+    /**
+     * @brief Number of consecutive measurements that differ less than `FSM_ULTRASOUND_STABLE_CM` (saturated to `FSM_ULTRASOUND_STABLE_MEASUREMENTS`).
+     *
+     */
+    uint32_t stable_count;
+
+    /**
+     * @brief Flag to indicate that the tracker has a valid estimation of the distance and speed of the obstacle.
+     *
+     */
+    bool tracker_valid;
+
+    /**
+     * @brief Time in ms of the measurement of the last distance used by the tracker (time of its trigger signal).
+     *
+     */
+    uint32_t tracker_ms;
+
+    /**
+     * @brief Distance in cm estimated by the tracker, in Q24.8 fixed point.
+     *
+     */
+    int32_t tracker_distance_q8;
+
+    /**
+     * @brief Speed in cm/s estimated by the tracker, in Q24.8 fixed point. It is negative when the obstacle approaches.
+     *
+     */
+    int32_t tracker_speed_q8;
+
+    /**
+     * @brief Confidence in percentage of the last published distance, i.e. how full the window was when the median was computed.
+     *
+     */
+    uint8_t confidence;
+
+    /**
+     * @brief Circular buffer with the last `FSM_ULTRASOUND_HISTORY_SIZE` measurements.
+     *
+     */
+    fsm_ultrasound_sample_t history_arr[FSM_ULTRASOUND_HISTORY_SIZE];
+
+    /**
+     * @brief Index of the position of `history_arr` where the next measurement will be stored.
+     *
+     */
+    uint32_t history_idx;
+
+    /**
+     * @brief Number of valid measurements in `history_arr` (saturated to `FSM_ULTRASOUND_HISTORY_SIZE`).
+     *
+     */
+    uint32_t history_count;
+
+    /**
+     * @brief Flag to indicate that the measurements are triggered by a scheduler (see `fsm_ultrasound_set_scheduled()`) instead of the timer of new measurements.
+     *
+     */
+    bool scheduled;
+
+    /**
+     * @brief Flag to indicate that the scheduler has requested a measurement that has not started yet.
+     *
+     */
+    bool measurement_request;
+
+    /**
+     * @brief Plausibility score (0 to 100) of the last measurement added to the window. It scales the correction of the tracker.
+     *
+     */
+    uint8_t sample_score;
+
+    /**
+     * @brief Number of measurements rejected because they were not plausible.
+     *
+     */
+    uint32_t rejections;
+
+    /**
+     * @brief Number of consecutive measurements rejected for their deviation from the tracker.
+     *
+     */
+    uint32_t consecutive_rejections;
+
+    /**
+     * @brief Number of expiries of the timer of new measurements that did not start a measurement (see `fsm_ultrasound_get_missed_periods()`).
+     *
+     */
+    uint32_t missed_periods;
+
+    /**
+     * @brief Last record published in the measurement bus. The subscribers read it by reference.
+     *
+     */
+    measurement_record_t record;
+};
+
+/* Global variables ------------------------------------------------------------*/
+/**
+ * @brief Distance in mm travelled by the sound (there and back) in 1 us, in Q0.32 fixed point, for each temperature from `FSM_ULTRASOUND_MIN_TEMPERATURE_C` to `FSM_ULTRASOUND_MAX_TEMPERATURE_C`.
+ *
+ * Each entry is `ceil(c(T) / 2000 * 2^32)`, with the speed of sound in air `c(T) = 331.3 * sqrt(1 + T / 273.15)` m/s.
+ *
+ */
+static const uint32_t mm_per_us_q32_arr[FSM_ULTRASOUND_MAX_TEMPERATURE_C - FSM_ULTRASOUND_MIN_TEMPERATURE_C + 1] = {
+    684919712U, 686271173U, 687619977U, 688966141U, 690309680U, 691650610U, // -20 to -15 C
+    692988944U, 694324699U, 695657889U, 696988529U, 698316633U, 699642216U, // -14 to -9 C
+    700965293U, 702285877U, 703603982U, 704919623U, 706232812U, 707543565U, // -8 to -3 C
+    708851893U, 710157812U, 711461333U, 712762470U, 714061237U, 715357646U, // -2 to 3 C
+    716651709U, 717943440U, 719232851U, 720519954U, 721804763U, 723087288U, // 4 to 9 C
+    724367543U, 725645539U, 726921288U, 728194802U, 729466093U, 730735172U, // 10 to 15 C
+    732002051U, 733266741U, 734529253U, 735789599U, 737047790U, 738303837U, // 16 to 21 C
+    739557751U, 740809542U, 742059222U, 743306800U, 744552289U, 745795697U, // 22 to 27 C
+    747037035U, 748276315U, 749513545U, 750748736U, 751981898U, 753213042U, // 28 to 33 C
+    754442176U, 755669311U, 756894457U, 758117623U, 759338818U, 760558053U, // 34 to 39 C
+    761775336U, 762990677U, 764204085U, 765415570U, 766625140U, 767832805U, // 40 to 45 C
 };
 
 /* Private functions -----------------------------------------------------------*/
-// Comparison function for qsort
 /**
- * @brief Compare function to sort arrays.
+ * @brief Insert a new distance in the sliding window of measurements.
+ *
+ * The window is a circular array: the new measurement overwrites the oldest one.
+ *
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param distance Distance in mm of the last measurement.
+ */
+static void _window_insert(fsm_ultrasound_t *p_fsm, uint32_t distance)
+{
+    p_fsm->distance_arr[p_fsm->distance_idx] = distance;
+    p_fsm->distance_idx += 1;
+    if (p_fsm->distance_idx >= FSM_ULTRASOUND_NUM_MEASUREMENTS)
+        p_fsm->distance_idx = 0;
+    if (p_fsm->distance_count < FSM_ULTRASOUND_NUM_MEASUREMENTS)
+        p_fsm->distance_count += 1;
+}
+
+/**
+ * @brief Compute the median of the sliding window of measurements.
+ *
+ * The median kernel reorders the array it receives, so it works on a copy of the window in the stack. For the usual window sizes (3, 5, 7 or 9) this is a fixed sequence of branchless compare-exchanges.
+ *
+ * While the window is not full yet, the measurements since the last start are the first `distance_count` elements of the array, so only those are used.
+ *
+ * The median commutes with the truncation from mm to cm, so the median in cm is the median in mm divided by 10.
+ *
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return uint32_t Median distance in mm of the window.
+ */
+static uint32_t _window_median(fsm_ultrasound_t *p_fsm)
+{
+    uint32_t window[FSM_ULTRASOUND_NUM_MEASUREMENTS];
+    memcpy(window, p_fsm->distance_arr, p_fsm->distance_count * sizeof(uint32_t));
+    return median_filter_select(window, p_fsm->distance_count);
+}
+
+/**
+ * @brief Convert a duration of the echo signal to the distance to the obstacle in mm.
+ *
+ * The conversion is a single 32x32-bit multiplication by `mm_per_tick_q32`, with no division and no intermediate overflow whatever the resolution of the echo timer. The factor is rounded up when it is computed, so the result is never below the exact distance and it exceeds it by less than `ticks / 2^32` mm.
+ *
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param echo_ticks Duration of the echo signal in ticks of the echo timer.
+ * @return uint32_t Distance in mm, rounded down.
+ */
+static uint32_t _ticks_to_mm(fsm_ultrasound_t *p_fsm, uint32_t echo_ticks)
+{
+    return (uint32_t)(((uint64_t)echo_ticks * p_fsm->mm_per_tick_q32) >> 32);
+}
+
+/**
+ * @brief Predict the distance of the tracker a time after its last distance.
+ *
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param elapsed_ms Time in ms since the last distance of the tracker.
+ * @return int32_t Predicted distance in cm, in Q24.8 fixed point.
+ */
+static int32_t _tracker_predict_q8(fsm_ultrasound_t *p_fsm, uint32_t elapsed_ms)
+{
+    return p_fsm->tracker_distance_q8 + (int32_t)((int64_t)p_fsm->tracker_speed_q8 * elapsed_ms / 1000);
+}
+
+/**
+ * @brief Update the alpha-beta tracker with a new published distance.
+ *
+ * The tracker predicts the distance at the time of the new measurement with the estimated speed, and corrects the distance and speed with the residual of the prediction:
+ *
+ * - `predicted = distance + speed * dt`
+ * - `distance = predicted + alpha * residual`
+ * - `speed = speed + beta * residual / dt`
+ *
+ * The time of each measurement is the time of its trigger signal, so `dt` is the real time between measurements even if the period changes. All the operations are in fixed point, with 64-bit intermediate products.
+ *
+ * The gains are scaled by the plausibility score of the last measurement (see `_plausibility_score()`), so a doubtful measurement corrects the tracker less.
+ *
+ * Distances out of range (`FSM_ULTRASOUND_NO_ECHO_CM`) are not real positions of an obstacle, so they invalidate the tracker. The tracker is restarted with the next distance, or when the last one is older than `FSM_ULTRASOUND_TRACKER_RESET_MS`.
+ *
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param distance New published distance in cm.
+ */
+static void _tracker_update(fsm_ultrasound_t *p_fsm, uint32_t distance)
+{
+    uint32_t elapsed_ms = p_fsm->measurement_start_ms - p_fsm->tracker_ms;
+    int32_t distance_q8 = (int32_t)(distance << 8);
+
+    if (distance >= FSM_ULTRASOUND_NO_ECHO_CM)
+    {
+        p_fsm->tracker_valid = false;
+        return;
+    }
+
+    if (!p_fsm->tracker_valid || (elapsed_ms > FSM_ULTRASOUND_TRACKER_RESET_MS))
+    {
+        p_fsm->tracker_distance_q8 = distance_q8;
+        p_fsm->tracker_speed_q8 = 0;
+        p_fsm->tracker_valid = true;
+    }
+    else
+    {
+        int32_t predicted_q8 = _tracker_predict_q8(p_fsm, elapsed_ms);
+        int32_t residual_q8 = distance_q8 - predicted_q8;
+        p_fsm->tracker_distance_q8 = predicted_q8 + (int32_t)((int64_t)FSM_ULTRASOUND_TRACKER_ALPHA_Q8 * p_fsm->sample_score * residual_q8 / 256 / 100);
+        if (elapsed_ms > 0)
+        {
+            p_fsm->tracker_speed_q8 += (int32_t)((int64_t)FSM_ULTRASOUND_TRACKER_BETA_Q8 * p_fsm->sample_score * residual_q8 * 1000 / 256 / 100 / elapsed_ms);
+        }
+    }
+    p_fsm->tracker_ms = p_fsm->measurement_start_ms;
+}
+
+/**
+ * @brief Adapt the period between measurements to the last measurement.
+ *
+ * The policy is:
+ * - Below `FSM_ULTRASOUND_NEAR_CM` the period shrinks linearly with the distance from the default period (`PORT_PARKING_SENSOR_TIMEOUT_MS`) to `FSM_ULTRASOUND_MIN_PERIOD_MS`.
+ * - From `FSM_ULTRASOUND_FAR_CM`, after `FSM_ULTRASOUND_STABLE_MEASUREMENTS` stable measurements, the period is `FSM_ULTRASOUND_MAX_PERIOD_MS`.
+ * - If the obstacle approaches at `FSM_ULTRASOUND_FAST_CLOSING_CM_S` or faster, the period is `FSM_ULTRASOUND_MIN_PERIOD_MS`.
+ * - Otherwise, the period is the default one.
+ *
+ * The raw measurement is used instead of the median so that a near obstacle that appears after a long period is reacted upon in the next measurement. The `port` is only called when the period changes.
+ *
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param distance Distance in cm of the last measurement.
+ */
+static void _update_measurement_period(fsm_ultrasound_t *p_fsm, uint32_t distance)
+{
+    uint32_t difference = (distance > p_fsm->last_distance_cm) ? (distance - p_fsm->last_distance_cm) : (p_fsm->last_distance_cm - distance);
+    if (difference > FSM_ULTRASOUND_STABLE_CM)
+    {
+        p_fsm->stable_count = 0;
+    }
+    else if (p_fsm->stable_count < FSM_ULTRASOUND_STABLE_MEASUREMENTS)
+    {
+        p_fsm->stable_count++;
+    }
+    p_fsm->last_distance_cm = distance;
+
+    uint32_t period_ms = PORT_PARKING_SENSOR_TIMEOUT_MS;
+    if (fsm_ultrasound_get_closing_speed(p_fsm) >= FSM_ULTRASOUND_FAST_CLOSING_CM_S)
+    {
+        period_ms = FSM_ULTRASOUND_MIN_PERIOD_MS;
+    }
+    else if (distance < FSM_ULTRASOUND_NEAR_CM)
+    {
+        period_ms = FSM_ULTRASOUND_MIN_PERIOD_MS + (PORT_PARKING_SENSOR_TIMEOUT_MS - FSM_ULTRASOUND_MIN_PERIOD_MS) * distance / FSM_ULTRASOUND_NEAR_CM;
+    }
+    else if ((distance >= FSM_ULTRASOUND_FAR_CM) && (p_fsm->stable_count >= FSM_ULTRASOUND_STABLE_MEASUREMENTS))
+    {
+        period_ms = FSM_ULTRASOUND_MAX_PERIOD_MS;
+    }
+
+    if (period_ms != p_fsm->measurement_period_ms)
+    {
+        p_fsm->measurement_period_ms = period_ms;
+        port_ultrasound_set_measurement_period_ms(p_fsm->ultrasound_id, period_ms);
+    }
+}
+
+/**
+ * @brief Check if a received echo signal is made of spurious edges instead of the answer of the sensor to its trigger.
+ *
+ * The echo signal is spurious if it is shorter than `FSM_ULTRASOUND_MIN_ECHO_US`, or if it started earlier than `FSM_ULTRASOUND_MIN_ECHO_DELAY_US` or later than `FSM_ULTRASOUND_MAX_ECHO_DELAY_US` after the start of the measurement.
+ *
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param echo_init_tick Tick of the echo timebase of the start of the echo signal.
+ * @param echo_ticks Duration of the echo signal in ticks of the echo timer.
+ * @return true If the echo signal is spurious.
+ * @return false Otherwise.
+ */
+static bool _echo_is_spurious(fsm_ultrasound_t *p_fsm, uint32_t echo_init_tick, uint32_t echo_ticks)
+{
+    // Both ticks come from the free-running echo timebase
+    uint32_t delay = echo_init_tick - p_fsm->measurement_start_tick;
+    uint32_t ticks_per_us = p_fsm->echo_ticks_per_us;
+    return (echo_ticks < FSM_ULTRASOUND_MIN_ECHO_US * ticks_per_us) || (delay < FSM_ULTRASOUND_MIN_ECHO_DELAY_US * ticks_per_us) || (delay > FSM_ULTRASOUND_MAX_ECHO_DELAY_US * ticks_per_us);
+}
+
+/**
+ * @brief Compute the plausibility score of a distance from its deviation from the tracker.
+ *
+ * The deviation is measured from the distance predicted by the tracker at the time of the measurement. The plausible deviation grows with that time, since the obstacle may have moved up to `FSM_ULTRASOUND_MAX_SPEED_CM_S`. Without a valid tracker every distance is plausible.
+ *
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param distance Distance in cm of the measurement.
+ * @return uint8_t Score from 0 (not plausible) to 100 (fully plausible).
+ */
+static uint8_t _plausibility_score(fsm_ultrasound_t *p_fsm, uint32_t distance)
+{
+    uint32_t elapsed_ms = p_fsm->measurement_start_ms - p_fsm->tracker_ms;
+    if (!p_fsm->tracker_valid || (elapsed_ms > FSM_ULTRASOUND_TRACKER_RESET_MS))
+    {
+        return 100;
+    }
+    int32_t residual_q8 = (int32_t)(distance << 8) - _tracker_predict_q8(p_fsm, elapsed_ms);
+    uint32_t deviation = (uint32_t)((residual_q8 < 0) ? -residual_q8 : residual_q8) >> 8;
+    uint32_t tolerance = FSM_ULTRASOUND_PLAUSIBLE_DEVIATION_CM + FSM_ULTRASOUND_MAX_SPEED_CM_S * elapsed_ms / 1000;
+    if (deviation <= tolerance)
+    {
+        return 100;
+    }
+    if (deviation >= 2 * tolerance)
+    {
+        return 0;
+    }
+    return (uint8_t)(100 * (2 * tolerance - deviation) / tolerance);
+}
+
+/**
+ * @brief Store a measurement in the history of the ultrasound sensor, overwriting the oldest one if it is full.
+ *
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param echo_ticks Duration of the echo signal in ticks of the echo timer.
+ * @param status Result of the measurement. One of `FSM_ULTRASOUND_SAMPLE_STATUS`.
+ */
+static void _history_add(fsm_ultrasound_t *p_fsm, uint32_t echo_ticks, uint8_t status)
+{
+    fsm_ultrasound_sample_t *p_sample = &p_fsm->history_arr[p_fsm->history_idx];
+    p_sample->echo_ticks = echo_ticks;
+    p_sample->distance_cm = fsm_ultrasound_get_filtered_distance(p_fsm);
+    // The raw ticks are kept: dividing them would break the differences when the timebase wraps around. A tick of 0 may be a valid capture, so the status tells if there is an echo
+    p_sample->timestamp_tick = (status == FSM_ULTRASOUND_SAMPLE_NO_ECHO) ? p_fsm->measurement_start_tick : port_ultrasound_get_echo_init_tick(p_fsm->ultrasound_id);
+    p_sample->status = status;
+
+    p_fsm->history_idx = (p_fsm->history_idx + 1) % FSM_ULTRASOUND_HISTORY_SIZE;
+    if (p_fsm->history_count < FSM_ULTRASOUND_HISTORY_SIZE)
+    {
+        p_fsm->history_count++;
+    }
+}
+
+/**
+ * @brief Publish the last distance in the measurement bus (see `measurement_bus.h`).
+ *
+ * The record is stored in the FSM and passed by reference, so the subscribers read it without any copy.
+ *
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ */
+static void _publish(fsm_ultrasound_t *p_fsm)
+{
+    measurement_record_t *p_record = &p_fsm->record;
+    p_record->sensor_id = p_fsm->ultrasound_id;
+    p_record->timestamp_ms = port_system_get_millis();
+    p_record->distance_cm = p_fsm->distance_cm;
+    p_record->distance_mm = p_fsm->distance_mm;
+    p_record->ttc_ms = fsm_ultrasound_get_ttc_ms(p_fsm);
+    p_record->confidence = p_fsm->confidence;
+    measurement_bus_publish(p_record);
+}
+
+/**
+ * @brief Add a new distance to the sliding window and publish the median if applicable.
+ *
+ * Once the window is full, the median of the window is published after every measurement.
+ *
+ * During the warm-up after `fsm_ultrasound_start()` the window is not full yet. To show something to the driver as soon as possible, the median of the measurements received so far is published whenever there is an odd number of them (1, 3, ...), and the confidence is lowered accordingly.
+ *
+ * Every published median is also published in the measurement bus (see `_publish()`). After every measurement, the period between measurements is adapted (see `_update_measurement_period()`) and the measurement is stored in the history.
+ *
+ * The window works in mm; the tracker and the period policy work in cm.
+ *
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param distance Distance in mm of the last measurement.
+ * @param echo_ticks Duration of the echo signal in ticks of the echo timer.
+ * @param status Result of the measurement. One of `FSM_ULTRASOUND_SAMPLE_STATUS`.
+ */
+static void _add_distance(fsm_ultrasound_t *p_fsm, uint32_t distance, uint32_t echo_ticks, uint8_t status)
+{
+    _window_insert(p_fsm, distance);
+    if ((p_fsm->distance_count >= FSM_ULTRASOUND_NUM_MEASUREMENTS) || (p_fsm->distance_count % 2 == 1))
+    {
+        uint32_t median_mm = _window_median(p_fsm);
+        _tracker_update(p_fsm, median_mm / 10);
+        p_fsm->distance_mm = median_mm;
+        p_fsm->distance_cm = median_mm / 10;
+        p_fsm->confidence = (uint8_t)(100 * p_fsm->distance_count / FSM_ULTRASOUND_NUM_MEASUREMENTS);
+        p_fsm->new_measurement = true;
+        _publish(p_fsm);
+    }
+    _update_measurement_period(p_fsm, distance / 10);
+    _history_add(p_fsm, echo_ticks, status);
+}
+
+/**
+ * @brief Apply an event of the interrupts of the `port` to its flag.
  *
- * This function is used to compare two elements. It will be used for the `qsort()` function to sort the array of distances.
+ * The events are applied one by one, and the timestamp of each one tells if it belongs to the current measurement:
+ * - The end of the trigger signal happens at or after the start of the measurement. An older one belongs to an abandoned measurement and is ignored.
+ * - The timer of new measurements restarts with each measurement, so an expiry at or before its start, or an expiry while the previous one is still pending, is a measurement period that has been missed. It is counted instead of being merged with the other one.
  *
- * @param a Pointer to the first element to compare.
- * @param b Pointer to the second element to compare.
- * @return int Result of the comparison.
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @param p_event Pointer to the event.
  */
-int _compare(const void *a, const void *b)
+static void _apply_event(fsm_ultrasound_t *p_fsm, const port_event_t *p_event)
 {
-    return (*(uint32_t *)a - *(uint32_t *)b);
+    int32_t since_start_ms = (int32_t)(p_event->timestamp_ms - p_fsm->measurement_start_ms);
+    switch (p_event->type)
+    {
+    case PORT_ULTRASOUND_EVENT_TRIGGER_END:
+        if (since_start_ms >= 0)
+        {
+            port_ultrasound_set_trigger_end(p_fsm->ultrasound_id, true);
+        }
+        break;
+    case PORT_ULTRASOUND_EVENT_TRIGGER_READY:
+        if ((since_start_ms <= 0) || port_ultrasound_get_trigger_ready(p_fsm->ultrasound_id))
+        {
+            p_fsm->missed_periods++;
+        }
+        else
+        {
+            port_ultrasound_set_trigger_ready(p_fsm->ultrasound_id, true);
+        }
+        break;
+    default:
+        break;
+    }
 }
 
 /* State machine input or transition functions */
+/**
+ * @brief Check if a measurement can be triggered.
+ *
+ * The `port` must be ready (the timer of new measurements has expired or the last echo signal has ended). If the measurements are scheduled, a measurement must also have been requested.
+ *
+ * @param p_fsm Pointer to an `fsm_ultrasound_t` structure.
+ * @return true
+ * @return false
+ */
+static bool _trigger_allowed(fsm_ultrasound_t *p_fsm)
+{
+    bool ready = port_ultrasound_get_trigger_ready(p_fsm->ultrasound_id);
+    if (p_fsm->scheduled)
+    {
+        return ready && p_fsm->measurement_request;
+    }
+    return ready;
+}
+
 /**
  * @brief Check if the ultrasound sensor is active and ready to start a new measurement.
  *
@@ -99,7 +612,7 @@ int _compare(const void *a, const void *b)
 static bool check_on(fsm_t *p_this)
 {
     fsm_ultrasound_t *p_fsm = (fsm_ultrasound_t *)(p_this);
-    return port_ultrasound_get_trigger_ready(p_fsm->ultrasound_id) && (p_fsm->status);
+    return _trigger_allowed(p_fsm) && (p_fsm->status);
 }
 
 /**
@@ -131,6 +644,8 @@ static bool check_trigger_end(fsm_t *p_this)
 /**
  * @brief Check if the ultrasound sensor has received the init (rising edge in the input capture) of the echo signal.
  *
+ * The edges captured since the last check are consumed first (see `port_ultrasound_consume_echo_edges()`).
+ *
  * @param p_this Pointer to an `fsm_t` structure that contains an `fsm_ultrasound_t`.
  * @return true
  * @return false
@@ -138,6 +653,7 @@ static bool check_trigger_end(fsm_t *p_this)
 static bool check_echo_init(fsm_t *p_this)
 {
     fsm_ultrasound_t *p_fsm = (fsm_ultrasound_t *)(p_this);
+    port_ultrasound_consume_echo_edges(p_fsm->ultrasound_id);
     if (port_ultrasound_get_echo_init_tick(p_fsm->ultrasound_id) > 0)
     {
         return true;
@@ -151,6 +667,8 @@ static bool check_echo_init(fsm_t *p_this)
 /**
  * @brief Check if the ultrasound sensor has received the end (falling edge in the input capture) of the echo signal.
  *
+ * The edges of the echo signal are captured by DMA without interrupting the CPU, so they are paired here (see `port_ultrasound_consume_echo_edges()`).
+ *
  * @param p_this Pointer to an `fsm_t` structure that contains an `fsm_ultrasound_t`.
  * @return true
  * @return false
@@ -158,12 +676,44 @@ static bool check_echo_init(fsm_t *p_this)
 static bool check_echo_received(fsm_t *p_this)
 {
     fsm_ultrasound_t *p_fsm = (fsm_ultrasound_t *)(p_this);
-    return port_ultrasound_get_echo_received(p_fsm->ultrasound_id);
+    return port_ultrasound_consume_echo_edges(p_fsm->ultrasound_id);
+}
+
+/**
+ * @brief Check if the echo signal (or any of its edges) has been lost.
+ *
+ * The echo of an obstacle in the range of interest always ends before the echo timeout since the trigger signal (see `fsm_ultrasound_get_echo_timeout_ms()`). If it has not been completely received by then, one of its edges has been lost.
+ *
+ * @param p_this Pointer to an `fsm_t` structure that contains an `fsm_ultrasound_t`.
+ * @return true
+ * @return false
+ */
+static bool check_echo_timeout(fsm_t *p_this)
+{
+    fsm_ultrasound_t *p_fsm = (fsm_ultrasound_t *)(p_this);
+    return (port_system_get_millis() - p_fsm->measurement_start_ms) > p_fsm->echo_timeout_ms;
+}
+
+/**
+ * @brief Check if the echo signal has lasted longer than the range of interest.
+ *
+ * @param p_this Pointer to an `fsm_t` structure that contains an `fsm_ultrasound_t`.
+ * @return true
+ * @return false
+ */
+static bool check_echo_out_of_range(fsm_t *p_this)
+{
+    fsm_ultrasound_t *p_fsm = (fsm_ultrasound_t *)(p_this);
+    uint32_t echo_init_tick = port_ultrasound_get_echo_init_tick(p_fsm->ultrasound_id);
+    uint32_t current_tick = port_ultrasound_get_echo_current_tick(p_fsm->ultrasound_id);
+    return (current_tick - echo_init_tick) > p_fsm->max_range_ticks;
 }
 
 /**
  * @brief Check if a new measurement is ready.
  *
+ * The pending edges are consumed first: the end of an abandoned echo signal makes the sensor ready right away.
+ *
  * @param p_this Pointer to an `fsm_t` structure that contains an `fsm_ultrasound_t`.
  * @return true
  * @return false
@@ -171,19 +721,29 @@ static bool check_echo_received(fsm_t *p_this)
 static bool check_new_measurement(fsm_t *p_this)
 {
     fsm_ultrasound_t *p_fsm = (fsm_ultrasound_t *)(p_this);
-    return port_ultrasound_get_trigger_ready(p_fsm->ultrasound_id);
+    port_ultrasound_consume_echo_edges(p_fsm->ultrasound_id);
+    return _trigger_allowed(p_fsm);
 }
 
 
 /**
  * @brief Start a measurement of the ultrasound transceiver for the first time after the FSM is started.
  *
+ * If the measurements are scheduled, the timer of new measurements is stopped: the scheduler decides when the next measurement starts.
+ *
  * @param p_this Pointer to an `fsm_t` structure that contains an `fsm_ultrasound_t`.
  */
 static void do_start_measurement(fsm_t *p_this)
 {
     fsm_ultrasound_t *p_fsm = (fsm_ultrasound_t *)(p_this);
+    p_fsm->measurement_start_ms = port_system_get_millis();
+    p_fsm->measurement_start_tick = port_ultrasound_get_echo_current_tick(p_fsm->ultrasound_id);
+    p_fsm->measurement_request = false;
     port_ultrasound_start_measurement(p_fsm->ultrasound_id);
+    if (p_fsm->scheduled)
+    {
+        port_ultrasound_stop_new_measurement_timer(p_fsm->ultrasound_id);
+    }
 }
 
 /**
@@ -203,30 +763,97 @@ static void do_stop_trigger(fsm_t *p_this)
 /**
  * @brief Set the distance measured by the ultrasound sensor.
  *
- * This function is called when the ultrasound sensor has received the echo signal. It calculates the distance in cm and stores it in the array of distances.
+ * This function is called when the ultrasound sensor has received the echo signal. It calculates the distance in mm (see `_ticks_to_mm()`) and adds it to the sliding window of distances (see `_add_distance()`).
+ *
+ * Measurements that are not plausible (see `_echo_is_spurious()` and `_plausibility_score()`) are only stored in the history and counted as rejected. After `FSM_ULTRASOUND_MAX_REJECTIONS` consecutive rejections for the deviation from the tracker, the obstacle is assumed to have changed: the window and the tracker restart from the measurement, as after `fsm_ultrasound_start()`.
  *
  * @param p_this Pointer to an `fsm_t` structure that contains an `fsm_ultrasound_t`.
  */
 static void do_set_distance(fsm_t *p_this)
 {
     fsm_ultrasound_t *p_fsm = (fsm_ultrasound_t *)(p_this);
-    uint32_t echo_overflows = port_ultrasound_get_echo_overflows(p_fsm->ultrasound_id);
-    uint32_t echo_init_tick = port_ultrasound_get_echo_init_tick(p_fsm->ultrasound_id);
-    uint32_t echo_end_tick = port_ultrasound_get_echo_end_tick(p_fsm->ultrasound_id);
-    uint32_t time = (echo_end_tick + echo_overflows * 65536 - echo_init_tick);
-    uint32_t distance = time * SPEED_OF_SOUND_MS / 20000;
-    p_fsm->distance_arr[p_fsm->distance_idx] = distance;
-    if (p_fsm->distance_idx >= FSM_ULTRASOUND_NUM_MEASUREMENTS - 1)
+    // Both ticks must belong to the same echo signal
+    port_ultrasound_echo_t echo;
+    port_ultrasound_read_echo(p_fsm->ultrasound_id, &echo);
+    uint32_t echo_init_tick = echo.echo_init_tick;
+    // Both ticks come from the free-running 32-bit timebase: the unsigned difference is correct even if it wraps around
+    uint32_t time = echo.echo_end_tick - echo_init_tick;
+    uint32_t distance_mm = _ticks_to_mm(p_fsm, time);
+    bool spurious = _echo_is_spurious(p_fsm, echo_init_tick, time);
+    uint8_t score = spurious ? 0 : _plausibility_score(p_fsm, distance_mm / 10);
+    if (!spurious && (score < FSM_ULTRASOUND_MIN_SCORE) && (++p_fsm->consecutive_rejections > FSM_ULTRASOUND_MAX_REJECTIONS))
     {
-        qsort(p_fsm->distance_arr, FSM_ULTRASOUND_NUM_MEASUREMENTS, sizeof(uint32_t), _compare);
-        p_fsm->distance_cm = p_fsm->distance_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS / 2]; // Esta es la mediana porque hay un numero IMPAR de elementos
-        p_fsm->new_measurement = true;
-    }
-    p_fsm->distance_idx += 1;
-    if (p_fsm->distance_idx >= FSM_ULTRASOUND_NUM_MEASUREMENTS)
+        // The obstacle has really changed: restart the window and the tracker with this measurement
         p_fsm->distance_idx = 0;
+        p_fsm->distance_count = 0;
+        p_fsm->tracker_valid = false;
+        score = 100;
+    }
+    if (score < FSM_ULTRASOUND_MIN_SCORE)
+    {
+        p_fsm->rejections++;
+        _history_add(p_fsm, time, FSM_ULTRASOUND_SAMPLE_REJECTED);
+    }
+    else
+    {
+        p_fsm->consecutive_rejections = 0;
+        p_fsm->sample_score = score;
+        _add_distance(p_fsm, distance_mm, time, FSM_ULTRASOUND_SAMPLE_OK);
+    }
+    port_ultrasound_stop_echo_timer(p_fsm->ultrasound_id);
+    port_ultrasound_reset_echo_ticks(p_fsm->ultrasound_id);
+    if (p_fsm->scheduled)
+    {
+        // There is no timer of new measurements: the sensor is free as soon as its echo signal ends
+        port_ultrasound_set_trigger_ready(p_fsm->ultrasound_id, true);
+    }
+}
+
+/**
+ * @brief Abandon a measurement whose echo signal has not started.
+ *
+ * This function is called when the start of the echo signal has not been received before the echo timeout. It stores a `FSM_ULTRASOUND_NO_ECHO_CM` distance in the sliding window (so that a single lost echo is filtered out by the median), resets the echo ticks and, if the sensor is still active, indicates that the next measurement can be triggered right away without waiting for the timer of new measurements.
+ *
+ * @param p_this Pointer to an `fsm_t` structure that contains an `fsm_ultrasound_t`.
+ */
+static void do_echo_timeout(fsm_t *p_this)
+{
+    fsm_ultrasound_t *p_fsm = (fsm_ultrasound_t *)(p_this);
+    uint32_t waited_ticks = (port_system_get_millis() - p_fsm->measurement_start_ms) * 1000 * p_fsm->echo_ticks_per_us;
+    _add_distance(p_fsm, FSM_ULTRASOUND_NO_ECHO_CM * 10, waited_ticks, FSM_ULTRASOUND_SAMPLE_NO_ECHO);
     port_ultrasound_stop_echo_timer(p_fsm->ultrasound_id);
     port_ultrasound_reset_echo_ticks(p_fsm->ultrasound_id);
+    port_ultrasound_set_trigger_ready(p_fsm->ultrasound_id, p_fsm->status);
+}
+
+/**
+ * @brief Abandon a measurement whose echo signal started but has not ended before the echo timeout.
+ *
+ * This function stores a `FSM_ULTRASOUND_NO_ECHO_CM` distance in the sliding window like `do_echo_timeout()`, but the echo line may still be high: the sensor would ignore a trigger now. As in `do_echo_out_of_range()`, the `port` abandons the echo signal and sets the trigger ready flag when it ends, or the timer of new measurements does it if its end has been lost.
+ *
+ * @param p_this Pointer to an `fsm_t` structure that contains an `fsm_ultrasound_t`.
+ */
+static void do_echo_end_timeout(fsm_t *p_this)
+{
+    fsm_ultrasound_t *p_fsm = (fsm_ultrasound_t *)(p_this);
+    uint32_t waited_ticks = (port_system_get_millis() - p_fsm->measurement_start_ms) * 1000 * p_fsm->echo_ticks_per_us;
+    _add_distance(p_fsm, FSM_ULTRASOUND_NO_ECHO_CM * 10, waited_ticks, FSM_ULTRASOUND_SAMPLE_NO_ECHO);
+    port_ultrasound_abort_echo(p_fsm->ultrasound_id);
+}
+
+/**
+ * @brief Abandon a measurement whose echo signal is longer than the range of interest.
+ *
+ * This function stores a `FSM_ULTRASOUND_NO_ECHO_CM` distance in the sliding window and indicates to the `port` to abandon the echo signal. The `port` sets the trigger ready flag as soon as the echo signal ends, so the next measurement does not wait for the timer of new measurements.
+ *
+ * @param p_this Pointer to an `fsm_t` structure that contains an `fsm_ultrasound_t`.
+ */
+static void do_echo_out_of_range(fsm_t *p_this)
+{
+    fsm_ultrasound_t *p_fsm = (fsm_ultrasound_t *)(p_this);
+    uint32_t echo_ticks = port_ultrasound_get_echo_current_tick(p_fsm->ultrasound_id) - port_ultrasound_get_echo_init_tick(p_fsm->ultrasound_id);
+    _add_distance(p_fsm, FSM_ULTRASOUND_NO_ECHO_CM * 10, echo_ticks, FSM_ULTRASOUND_SAMPLE_OUT_OF_RANGE);
+    port_ultrasound_abort_echo(p_fsm->ultrasound_id);
 }
 
 /**
@@ -256,7 +883,7 @@ static void do_start_new_measurement(fsm_t *p_this)
 /**
  * @brief Array representing the transitions table of the FSM ultrasound.
  *
- * @attention The order of the transitions is important. The FSM will check the transitions in the order they are defined in this array. In state `SET_DISTANCE`, the FSM will first check if a new measurement is ready (`check_new_measurement()`), then if the ultrasound sensor is off (`check_off()`). If the order is changed, the FSM may not work as expected and may finish measurements before time.
+ * @attention The order of the transitions is important. The FSM will check the transitions in the order they are defined in this array. In state `SET_DISTANCE`, the FSM will first check if a new measurement is ready (`check_new_measurement()`), then if the ultrasound sensor is off (`check_off()`). If the order is changed, the FSM may not work as expected and may finish measurements before time. In states `WAIT_ECHO_START` and `WAIT_ECHO_END`, the echo signal is checked before the range of interest and the timeout, so that an echo received just in time is not discarded.
  *
  * @image html fsm_v2.png
  *
@@ -266,8 +893,11 @@ static fsm_trans_t fsm_trans_ultrasound[] = {
     {TRIGGER_START, check_trigger_end, WAIT_ECHO_START, do_stop_trigger},
 
     {WAIT_ECHO_START, check_echo_init, WAIT_ECHO_END, NULL},
+    {WAIT_ECHO_START, check_echo_timeout, SET_DISTANCE, do_echo_timeout},
 
     {WAIT_ECHO_END, check_echo_received, SET_DISTANCE, do_set_distance},
+    {WAIT_ECHO_END, check_echo_out_of_range, SET_DISTANCE, do_echo_out_of_range},
+    {WAIT_ECHO_END, check_echo_timeout, SET_DISTANCE, do_echo_end_timeout},
 
     {SET_DISTANCE, check_new_measurement, TRIGGER_START, do_start_new_measurement},
     {SET_DISTANCE, check_off, WAIT_START, do_stop_measurement},
@@ -297,11 +927,34 @@ void fsm_ultrasound_init(fsm_ultrasound_t *p_fsm_ultrasound, uint32_t ultrasound
     fsm_init(&p_fsm_ultrasound->f, fsm_trans_ultrasound);
 
     p_fsm_ultrasound->distance_cm = 0;
+    p_fsm_ultrasound->distance_mm = 0;
     p_fsm_ultrasound->distance_idx = 0;
+    p_fsm_ultrasound->distance_count = 0;
+    p_fsm_ultrasound->confidence = 0;
+    p_fsm_ultrasound->measurement_start_ms = port_system_get_millis();
+    p_fsm_ultrasound->measurement_start_tick = port_ultrasound_get_echo_current_tick(ultrasound_id);
     memset(p_fsm_ultrasound->distance_arr, 0, sizeof(p_fsm_ultrasound->distance_arr));
     p_fsm_ultrasound->new_measurement = false;
     p_fsm_ultrasound->status = false;
     p_fsm_ultrasound->ultrasound_id = ultrasound_id;
+    p_fsm_ultrasound->echo_ticks_per_us = port_ultrasound_get_echo_ticks_per_us(ultrasound_id);
+    p_fsm_ultrasound->max_range_cm = FSM_ULTRASOUND_MAX_RANGE_CM;
+    fsm_ultrasound_set_temperature(p_fsm_ultrasound, FSM_ULTRASOUND_DEFAULT_TEMPERATURE_C); // It also converts the range of interest
+    p_fsm_ultrasound->measurement_period_ms = PORT_PARKING_SENSOR_TIMEOUT_MS;
+    p_fsm_ultrasound->last_distance_cm = 0;
+    p_fsm_ultrasound->stable_count = 0;
+    p_fsm_ultrasound->tracker_valid = false;
+    p_fsm_ultrasound->tracker_ms = 0;
+    p_fsm_ultrasound->tracker_distance_q8 = 0;
+    p_fsm_ultrasound->tracker_speed_q8 = 0;
+    p_fsm_ultrasound->history_idx = 0;
+    p_fsm_ultrasound->history_count = 0;
+    p_fsm_ultrasound->scheduled = false;
+    p_fsm_ultrasound->measurement_request = false;
+    p_fsm_ultrasound->sample_score = 100;
+    p_fsm_ultrasound->rejections = 0;
+    p_fsm_ultrasound->consecutive_rejections = 0;
+    p_fsm_ultrasound->missed_periods = 0;
 
     port_ultrasound_init(ultrasound_id);
 }
@@ -326,6 +979,13 @@ void fsm_ultrasound_set_state(fsm_ultrasound_t *p_fsm, int8_t state)
 
 void fsm_ultrasound_fire(fsm_ultrasound_t *p_fsm)
 {
+    // The interrupts only queue their events: each one is applied and checked on its own, in order
+    port_event_t event;
+    while (port_ultrasound_pop_event(p_fsm->ultrasound_id, &event))
+    {
+        _apply_event(p_fsm, &event);
+        fsm_fire(&p_fsm->f);
+    }
     fsm_fire(&p_fsm->f); // It is also possible to it in this way: fsm_fire((fsm_t *)p_fsm);
 }
 
@@ -350,9 +1010,16 @@ uint32_t fsm_ultrasound_get_distance(fsm_ultrasound_t *p_fsm)
     return p_fsm->distance_cm;
 }
 
+uint32_t fsm_ultrasound_get_distance_mm(fsm_ultrasound_t *p_fsm)
+{
+    p_fsm->new_measurement = false;
+    return p_fsm->distance_mm;
+}
+
 void fsm_ultrasound_stop(fsm_ultrasound_t *p_fsm)
 {
     p_fsm->status = false;
+    p_fsm->measurement_request = false;
     port_ultrasound_stop_ultrasound(p_fsm->ultrasound_id);
 }
 
@@ -360,10 +1027,176 @@ void fsm_ultrasound_start(fsm_ultrasound_t *p_fsm)
 {
     p_fsm->status = true;
     p_fsm->distance_idx = 0;
+    p_fsm->distance_count = 0;
+    p_fsm->confidence = 0;
     p_fsm->distance_cm = 0;
+    p_fsm->distance_mm = 0;
+    p_fsm->stable_count = 0;
+    p_fsm->tracker_valid = false;
+    p_fsm->consecutive_rejections = 0;
     port_ultrasound_reset_echo_ticks(p_fsm->ultrasound_id);
     port_ultrasound_set_trigger_ready(p_fsm->ultrasound_id, true);
-    port_ultrasound_start_new_measurement_timer(p_fsm->ultrasound_id);
+    if (!p_fsm->scheduled)
+    {
+        port_ultrasound_start_new_measurement_timer(p_fsm->ultrasound_id);
+    }
+}
+
+void fsm_ultrasound_set_scheduled(fsm_ultrasound_t *p_fsm, bool scheduled)
+{
+    p_fsm->scheduled = scheduled;
+    p_fsm->measurement_request = false;
+    if (scheduled)
+    {
+        port_ultrasound_stop_new_measurement_timer(p_fsm->ultrasound_id);
+    }
+    else if (p_fsm->status)
+    {
+        port_ultrasound_start_new_measurement_timer(p_fsm->ultrasound_id);
+    }
+}
+
+void fsm_ultrasound_request_measurement(fsm_ultrasound_t *p_fsm)
+{
+    p_fsm->measurement_request = true;
+}
+
+bool fsm_ultrasound_is_measuring(fsm_ultrasound_t *p_fsm)
+{
+    switch (p_fsm->f.current_state)
+    {
+    case TRIGGER_START:
+    case WAIT_ECHO_START:
+    case WAIT_ECHO_END:
+        return true;
+    case SET_DISTANCE:
+        // The echo signal of an abandoned measurement may not have ended yet
+        return p_fsm->measurement_request || !port_ultrasound_get_trigger_ready(p_fsm->ultrasound_id);
+    default:
+        return p_fsm->measurement_request;
+    }
+}
+
+uint8_t fsm_ultrasound_get_confidence(fsm_ultrasound_t *p_fsm)
+{
+    return p_fsm->confidence;
+}
+
+void fsm_ultrasound_set_max_range(fsm_ultrasound_t *p_fsm, uint32_t max_range_cm)
+{
+    p_fsm->max_range_cm = max_range_cm;
+    // Inverse of _ticks_to_mm(), rounded up so that an echo of exactly max_range_cm is not abandoned
+    p_fsm->max_range_ticks = (uint32_t)((((uint64_t)max_range_cm * 10 << 32) + p_fsm->mm_per_tick_q32 - 1) / p_fsm->mm_per_tick_q32);
+    // The echo of the farthest obstacle of interest may start up to FSM_ULTRASOUND_MAX_ECHO_DELAY_US after the trigger: it must reach the range gate before the timeout
+    uint32_t max_echo_end_ms = (p_fsm->max_range_ticks / p_fsm->echo_ticks_per_us + FSM_ULTRASOUND_MAX_ECHO_DELAY_US + 999) / 1000;
+    p_fsm->echo_timeout_ms = (max_echo_end_ms > FSM_ULTRASOUND_ECHO_TIMEOUT_MS) ? max_echo_end_ms : FSM_ULTRASOUND_ECHO_TIMEOUT_MS;
+}
+
+uint32_t fsm_ultrasound_get_echo_timeout_ms(fsm_ultrasound_t *p_fsm)
+{
+    return p_fsm->echo_timeout_ms;
+}
+
+uint32_t fsm_ultrasound_get_max_range(fsm_ultrasound_t *p_fsm)
+{
+    return p_fsm->max_range_cm;
+}
+
+void fsm_ultrasound_set_temperature(fsm_ultrasound_t *p_fsm, int32_t temperature_c)
+{
+    if (temperature_c < FSM_ULTRASOUND_MIN_TEMPERATURE_C)
+    {
+        temperature_c = FSM_ULTRASOUND_MIN_TEMPERATURE_C;
+    }
+    else if (temperature_c > FSM_ULTRASOUND_MAX_TEMPERATURE_C)
+    {
+        temperature_c = FSM_ULTRASOUND_MAX_TEMPERATURE_C;
+    }
+    p_fsm->temperature_c = temperature_c;
+    // The division by the resolution of the echo timer is done here, out of the conversion of every echo. Rounded up like the table (see _ticks_to_mm())
+    uint32_t mm_per_us_q32 = mm_per_us_q32_arr[temperature_c - FSM_ULTRASOUND_MIN_TEMPERATURE_C];
+    p_fsm->mm_per_tick_q32 = (mm_per_us_q32 + p_fsm->echo_ticks_per_us - 1) / p_fsm->echo_ticks_per_us;
+    fsm_ultrasound_set_max_range(p_fsm, p_fsm->max_range_cm);
+}
+
+int32_t fsm_ultrasound_get_temperature(fsm_ultrasound_t *p_fsm)
+{
+    return p_fsm->temperature_c;
+}
+
+uint32_t fsm_ultrasound_get_measurement_period_ms(fsm_ultrasound_t *p_fsm)
+{
+    return p_fsm->measurement_period_ms;
+}
+
+uint32_t fsm_ultrasound_get_rejections(fsm_ultrasound_t *p_fsm)
+{
+    return p_fsm->rejections;
+}
+
+uint32_t fsm_ultrasound_get_missed_periods(fsm_ultrasound_t *p_fsm)
+{
+    return p_fsm->missed_periods;
+}
+
+uint32_t fsm_ultrasound_get_filtered_distance(fsm_ultrasound_t *p_fsm)
+{
+    if (!p_fsm->tracker_valid)
+    {
+        return p_fsm->distance_cm;
+    }
+    if (p_fsm->tracker_distance_q8 < 0)
+    {
+        return 0;
+    }
+    return ((uint32_t)p_fsm->tracker_distance_q8 + 128) >> 8;
+}
+
+int32_t fsm_ultrasound_get_closing_speed(fsm_ultrasound_t *p_fsm)
+{
+    if (!p_fsm->tracker_valid)
+    {
+        return 0;
+    }
+    return -p_fsm->tracker_speed_q8 / 256;
+}
+
+const fsm_ultrasound_sample_t *fsm_ultrasound_history_begin(const fsm_ultrasound_t *p_fsm, fsm_ultrasound_history_it_t *p_it)
+{
+    p_it->p_fsm = p_fsm;
+    // Start one position after the newest sample, fsm_ultrasound_history_next() moves backwards
+    p_it->index = p_fsm->history_idx;
+    p_it->remaining = p_fsm->history_count;
+    return fsm_ultrasound_history_next(p_it);
+}
+
+const fsm_ultrasound_sample_t *fsm_ultrasound_history_next(fsm_ultrasound_history_it_t *p_it)
+{
+    if (p_it->remaining == 0)
+    {
+        return NULL;
+    }
+    p_it->remaining--;
+    p_it->index = (p_it->index + FSM_ULTRASOUND_HISTORY_SIZE - 1) % FSM_ULTRASOUND_HISTORY_SIZE;
+    return &p_it->p_fsm->history_arr[p_it->index];
+}
+
+uint32_t fsm_ultrasound_get_ttc_ms(fsm_ultrasound_t *p_fsm)
+{
+    if (!p_fsm->tracker_valid || (p_fsm->tracker_speed_q8 >= 0))
+    {
+        return FSM_ULTRASOUND_TTC_INFINITE;
+    }
+    if (p_fsm->tracker_distance_q8 <= 0)
+    {
+        return 0;
+    }
+    return (uint32_t)((int64_t)p_fsm->tracker_distance_q8 * 1000 / -p_fsm->tracker_speed_q8);
+}
+
+uint32_t fsm_ultrasound_get_id(fsm_ultrasound_t *p_fsm)
+{
+    return p_fsm->ultrasound_id;
 }
 
 bool fsm_ultrasound_get_status(fsm_ultrasound_t *p_fsm)
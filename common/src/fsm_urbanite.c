@@ -17,8 +17,26 @@
 /* Project includes */
 #include "fsm.h"
 #include "fsm_urbanite.h"
+#include "measurement_bus.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define URBANITE_FRONT 0     /*!< Index of the front side in `sides` */
+#define URBANITE_REAR 1      /*!< Index of the rear side in `sides` */
+#define URBANITE_NUM_SIDES 2 /*!< Number of sides of the car */
 
 /* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Measurements of one side of the car, received from the measurement bus.
+ *
+ */
+typedef struct
+{
+    const measurement_record_t *p_record;   /*!< Last record received. It belongs to the ultrasound FSM, so it is read by reference */
+    bool new_record;                        /*!< Flag to indicate that `p_record` has not been shown yet */
+    uint32_t distance_cm;                   /*!< Last distance in cm shown */
+    int32_t subscriber_id;                  /*!< ID of the subscription to the records of the ultrasound of the side */
+} urbanite_side_t;
+
 /**
  * @brief Structure to define the Urbanite FSM.
  *
@@ -67,6 +85,18 @@ struct fsm_urbanite_t
      */
     bool is_rear;
 
+    /**
+     * @brief Flag to indicate that the front and rear ultrasounds measure at the same time. The current side (`is_rear`) is then only the gear selected by the driver.
+     *
+     */
+    bool measure_both;
+
+    /**
+     * @brief Measurements of the front (`URBANITE_FRONT`) and rear (`URBANITE_REAR`) sides. The current side is `sides[is_rear]`.
+     *
+     */
+    urbanite_side_t sides[URBANITE_NUM_SIDES];
+
      /**
      * @brief Pointer to the front ultrasound FSM.
      *
@@ -99,6 +129,49 @@ struct fsm_urbanite_t
 };
 
 /* Private functions -----------------------------------------------------------*/
+/**
+ * @brief Compute the distance to show to the driver from a measurement of an ultrasound sensor.
+ *
+ * When reversing quickly the obstacle can be reached before it crosses the distance thresholds of the display and the buzzer. If the time to collision is below `URBANITE_TTC_WARNING_MS`, the distance is limited to `URBANITE_TTC_WARNING_CM` so that the warning arrives earlier.
+ *
+ * @param p_record Pointer to the measurement.
+ * @return uint32_t Distance in cm to show to the driver.
+ */
+static uint32_t _warning_distance(const measurement_record_t *p_record)
+{
+    if ((p_record->ttc_ms < URBANITE_TTC_WARNING_MS) && (p_record->distance_cm > URBANITE_TTC_WARNING_CM))
+    {
+        return URBANITE_TTC_WARNING_CM;
+    }
+    return p_record->distance_cm;
+}
+
+/**
+ * @brief Receive a measurement of an ultrasound sensor from the measurement bus.
+ *
+ * It is called in the context of the ultrasound FSM, so it only keeps a reference to the record: the distance is shown in the next `fire` of the Urbanite FSM (see `do_distance()`).
+ *
+ * @param p_record Pointer to the measurement.
+ * @param p_context Pointer to the `urbanite_side_t` of the sensor.
+ */
+static void _receive_measurement(const measurement_record_t *p_record, void *p_context)
+{
+    urbanite_side_t *p_side = (urbanite_side_t *)p_context;
+    p_side->p_record = p_record;
+    p_side->new_record = true;
+}
+
+/**
+ * @brief Forget the measurements of a side, e.g. when its ultrasound is started again.
+ *
+ * @param p_side Pointer to the side.
+ */
+static void _reset_side(urbanite_side_t *p_side)
+{
+    p_side->new_record = false;
+    p_side->distance_cm = FSM_ULTRASOUND_NO_ECHO_CM;
+}
+
 /**
  * @brief Check if the button has been pressed for the required time to turn ON the Urbanite system.
  *
@@ -135,11 +208,10 @@ static bool check_off(fsm_t *p_this)
 static bool check_new_measure(fsm_t *p_this)
 {
     fsm_urbanite_t *p_fsm = (fsm_urbanite_t *)(p_this);
-    if(p_fsm->is_rear) {
-        return fsm_ultrasound_get_new_measurement_ready(p_fsm->p_fsm_ultrasound_rear);
-    } else {
-        return fsm_ultrasound_get_new_measurement_ready(p_fsm->p_fsm_ultrasound_front);
+    if (p_fsm->measure_both) {
+        return p_fsm->sides[URBANITE_FRONT].new_record || p_fsm->sides[URBANITE_REAR].new_record;
     }
+    return p_fsm->sides[p_fsm->is_rear].new_record;
 }
 
 /**
@@ -238,84 +310,96 @@ static void do_start_up_measure(fsm_t *p_this)
 
     fsm_ultrasound_start(p_fsm->p_fsm_ultrasound_front);
     fsm_display_set_status(p_fsm->p_fsm_display_front, false);
+    _reset_side(&p_fsm->sides[URBANITE_FRONT]);
+    if (p_fsm->measure_both)
+    {
+        fsm_ultrasound_start(p_fsm->p_fsm_ultrasound_rear);
+        fsm_display_set_status(p_fsm->p_fsm_display_rear, false);
+        _reset_side(&p_fsm->sides[URBANITE_REAR]);
+    }
     fsm_buzzer_set_status(p_fsm->p_fsm_buzzer, false);
 
     printf("[URBANITE][%ld] Urbanite system ON\n", port_system_get_millis());
 }
 
+/**
+ * @brief Show a distance on a display and turn it ON or OFF depending on the pause.
+ *
+ * While the display system is paused only the obstacles closer than `WARNING_MIN_CM / 2` are shown.
+ *
+ * @param p_fsm Pointer to the Urbanite FSM.
+ * @param p_fsm_display Pointer to the display FSM.
+ * @param distance Distance in cm to show.
+ */
+static void _show_display(fsm_urbanite_t *p_fsm, fsm_display_t *p_fsm_display, uint32_t distance)
+{
+    if (p_fsm->is_paused && (distance >= WARNING_MIN_CM / 2))
+    {
+        fsm_display_set_status(p_fsm_display, false);
+        return;
+    }
+    fsm_display_set_distance(p_fsm_display, distance);
+    fsm_display_set_status(p_fsm_display, true);
+}
+
+/**
+ * @brief Sound a distance on the buzzer and turn it ON or OFF depending on the pause.
+ *
+ * The buzzer follows the same rule as the displays (see `_show_display()`).
+ *
+ * @param p_fsm Pointer to the Urbanite FSM.
+ * @param distance Distance in cm to sound.
+ */
+static void _show_buzzer(fsm_urbanite_t *p_fsm, uint32_t distance)
+{
+    if (p_fsm->is_paused && (distance >= WARNING_MIN_CM / 2))
+    {
+        fsm_buzzer_set_status(p_fsm->p_fsm_buzzer, false);
+        return;
+    }
+    fsm_buzzer_set_distance(p_fsm->p_fsm_buzzer, distance);
+    fsm_buzzer_set_status(p_fsm->p_fsm_buzzer, true);
+}
+
 /**
  * @brief Display the distance measured by the ultrasound sensor.
  *
+ * The distances arrive from the measurement bus (see `_receive_measurement()`). The distance is limited to `URBANITE_TTC_WARNING_CM` if the obstacle approaches fast (see `_warning_distance()`).
+ *
+ * If both sides are measured (see `fsm_urbanite_set_measure_both()`), each display shows the last distance of its own side as soon as it is measured, and the buzzer sounds the closer of the two sides. Otherwise only the current side is shown and the other display is OFF.
+ *
  * @param p_this Pointer to an `fsm_t` struct that contains an `fsm_urbanite_t`.
  */
 static void do_distance(fsm_t *p_this)
 {
     fsm_urbanite_t *p_fsm = (fsm_urbanite_t *)(p_this);
-        
-    if (!(p_fsm->is_rear)) {
-        fsm_display_set_status(p_fsm->p_fsm_display_rear, false);
-        
-        uint32_t distance = fsm_ultrasound_get_distance(p_fsm->p_fsm_ultrasound_front);
 
-        if (p_fsm->is_paused)
+    for (uint32_t i = 0; i < URBANITE_NUM_SIDES; i++)
+    {
+        urbanite_side_t *p_side = &p_fsm->sides[i];
+        fsm_display_t *p_fsm_display = (i == URBANITE_REAR) ? p_fsm->p_fsm_display_rear : p_fsm->p_fsm_display_front;
+        if (!p_fsm->measure_both && (i != (uint32_t)p_fsm->is_rear))
         {
-            if (distance < WARNING_MIN_CM / 2)
-            {
-                fsm_display_set_distance(p_fsm->p_fsm_display_front, distance);
-                fsm_buzzer_set_distance(p_fsm->p_fsm_buzzer, distance);
-
-                fsm_display_set_status(p_fsm->p_fsm_display_front, true);
-                fsm_buzzer_set_status(p_fsm->p_fsm_buzzer, true);
-            }
-            else
-            {
-                fsm_display_set_status(p_fsm->p_fsm_display_front, false);
-                fsm_buzzer_set_status(p_fsm->p_fsm_buzzer, false);
-            }
+            fsm_display_set_status(p_fsm_display, false);
+            continue;
         }
-        else
-        {   
-            fsm_display_set_distance(p_fsm->p_fsm_display_front, distance);
-            fsm_buzzer_set_distance(p_fsm->p_fsm_buzzer, distance);
-
-            fsm_display_set_status(p_fsm->p_fsm_display_front, true);
-            fsm_buzzer_set_status(p_fsm->p_fsm_buzzer, true);
-        }
-
-        printf("[URBANITE][%ld] Distance FRONT: %ld cm\n", port_system_get_millis(), distance);
-
-    } else {
-        fsm_display_set_status(p_fsm->p_fsm_display_front, false);
-        
-        uint32_t distance = fsm_ultrasound_get_distance(p_fsm->p_fsm_ultrasound_rear);
-
-        if (p_fsm->is_paused)
+        if (!p_side->new_record)
         {
-            if (distance < WARNING_MIN_CM / 2)
-            {
-                fsm_display_set_distance(p_fsm->p_fsm_display_rear, distance);
-                fsm_buzzer_set_distance(p_fsm->p_fsm_buzzer, distance);
-
-                fsm_display_set_status(p_fsm->p_fsm_display_rear, true);
-                fsm_buzzer_set_status(p_fsm->p_fsm_buzzer, true);
-            }
-            else
-            {
-                fsm_display_set_status(p_fsm->p_fsm_display_rear, false);
-                fsm_buzzer_set_status(p_fsm->p_fsm_buzzer, false);
-            }
+            continue;
         }
-        else
-        {   
-            fsm_display_set_distance(p_fsm->p_fsm_display_rear, distance);
-            fsm_buzzer_set_distance(p_fsm->p_fsm_buzzer, distance);
+        p_side->new_record = false;
+        p_side->distance_cm = _warning_distance(p_side->p_record);
+        _show_display(p_fsm, p_fsm_display, p_side->distance_cm);
 
-            fsm_display_set_status(p_fsm->p_fsm_display_rear, true);
-            fsm_buzzer_set_status(p_fsm->p_fsm_buzzer, true);
-        }
+        printf("[URBANITE][%ld] Distance %s: %ld cm\n", port_system_get_millis(), (i == URBANITE_REAR) ? "REAR" : "FRONT", p_side->distance_cm);
+    }
 
-        printf("[URBANITE][%ld] Distance REAR: %ld cm\n", port_system_get_millis(), distance);
+    uint32_t distance = p_fsm->sides[p_fsm->is_rear].distance_cm;
+    if (p_fsm->measure_both && (p_fsm->sides[!p_fsm->is_rear].distance_cm < distance))
+    {
+        distance = p_fsm->sides[!p_fsm->is_rear].distance_cm;
     }
+    _show_buzzer(p_fsm, distance);
 }
 
 /**
@@ -330,7 +414,10 @@ static void do_pause(fsm_t *p_this)
 
     p_fsm->is_paused = !p_fsm->is_paused;
 
-    if(p_fsm->is_rear) {
+    if (p_fsm->measure_both) {
+        fsm_display_set_status(p_fsm->p_fsm_display_front, p_fsm->is_paused);
+        fsm_display_set_status(p_fsm->p_fsm_display_rear, p_fsm->is_paused);
+    } else if(p_fsm->is_rear) {
         fsm_display_set_status(p_fsm->p_fsm_display_rear, p_fsm->is_paused);
     } else {
         fsm_display_set_status(p_fsm->p_fsm_display_front, p_fsm->is_paused);
@@ -408,6 +495,8 @@ static void do_sleep_off(fsm_t *p_this)
 /**
  * @brief Change the current ultrasound and display to the REAR ones.
  * 
+ * If both sides are measured, the change is instant: no ultrasound is stopped, so no measurement is restarted.
+ * 
  * @param p_this Pointer to an `fsm_t` struct that contains an `fsm_urbanite_t`.
  */
 static void do_change_rear(fsm_t *p_this)
@@ -416,11 +505,19 @@ static void do_change_rear(fsm_t *p_this)
 
     fsm_button_reset_duration(p_fsm->p_fsm_button);
 
+    if (p_fsm->measure_both)
+    {
+        p_fsm->is_rear = true;
+        printf("[URBANITE][%ld] Urbanite change REAR\n", port_system_get_millis());
+        return;
+    }
+
     fsm_ultrasound_stop(p_fsm->p_fsm_ultrasound_front);
     fsm_display_set_status(p_fsm->p_fsm_display_front, false);
 
     p_fsm->is_rear = true;
     fsm_ultrasound_start(p_fsm->p_fsm_ultrasound_rear);
+    _reset_side(&p_fsm->sides[URBANITE_REAR]);
     fsm_display_set_status(p_fsm->p_fsm_display_rear, false);
 
     printf("[URBANITE][%ld] Urbanite change REAR\n", port_system_get_millis());
@@ -429,6 +526,8 @@ static void do_change_rear(fsm_t *p_this)
 /**
  * @brief Change the current ultrasound and display to the FRONT ones.
  * 
+ * If both sides are measured, the change is instant: no ultrasound is stopped, so no measurement is restarted.
+ * 
  * @param p_this Pointer to an `fsm_t` struct that contains an `fsm_urbanite_t`.
  */
 static void do_change_front(fsm_t *p_this)
@@ -436,12 +535,20 @@ static void do_change_front(fsm_t *p_this)
     fsm_urbanite_t *p_fsm = (fsm_urbanite_t *)(p_this);
 
     fsm_button_reset_duration(p_fsm->p_fsm_button);
+
+    if (p_fsm->measure_both)
+    {
+        p_fsm->is_rear = false;
+        printf("[URBANITE][%ld] Urbanite change FRONT\n", port_system_get_millis());
+        return;
+    }
     
     fsm_ultrasound_stop(p_fsm->p_fsm_ultrasound_rear);
     fsm_display_set_status(p_fsm->p_fsm_display_rear, false);
 
     p_fsm->is_rear = false;
     fsm_ultrasound_start(p_fsm->p_fsm_ultrasound_front);
+    _reset_side(&p_fsm->sides[URBANITE_FRONT]);
     fsm_display_set_status(p_fsm->p_fsm_display_front, false);
 
     printf("[URBANITE][%ld] Urbanite change FRONT\n", port_system_get_millis());
@@ -523,6 +630,17 @@ static void fsm_urbanite_init(fsm_urbanite_t *p_fsm_urbanite, fsm_button_t *p_fs
     p_fsm_urbanite->p_fsm_buzzer = p_fsm_buzzer;
     p_fsm_urbanite->is_paused = false;
     p_fsm_urbanite->is_rear = false;
+    p_fsm_urbanite->measure_both = false;
+
+    // The Urbanite is one more consumer of the measurement bus: other consumers (loggers, more displays, etc.) subscribe in the same way
+    fsm_ultrasound_t *p_fsm_ultrasound_arr[URBANITE_NUM_SIDES] = {[URBANITE_FRONT] = p_fsm_ultrasound_front, [URBANITE_REAR] = p_fsm_ultrasound_rear};
+    for (uint32_t i = 0; i < URBANITE_NUM_SIDES; i++)
+    {
+        measurement_bus_filter_t filter = {.sensor_mask = 1U << fsm_ultrasound_get_id(p_fsm_ultrasound_arr[i]), .min_change_cm = 0, .min_period_ms = 0};
+        _reset_side(&p_fsm_urbanite->sides[i]);
+        p_fsm_urbanite->sides[i].p_record = NULL;
+        p_fsm_urbanite->sides[i].subscriber_id = measurement_bus_subscribe(&filter, _receive_measurement, &p_fsm_urbanite->sides[i]);
+    }
 }
 
 /* Public functions ------------------------------------------------------------*/
@@ -540,5 +658,42 @@ void fsm_urbanite_fire(fsm_urbanite_t *p_fsm)
 
 void fsm_urbanite_destroy(fsm_urbanite_t *p_fsm)
 {
+    for (uint32_t i = 0; i < URBANITE_NUM_SIDES; i++)
+    {
+        measurement_bus_unsubscribe(p_fsm->sides[i].subscriber_id);
+    }
     free(&p_fsm->f);
 }
+
+void fsm_urbanite_set_measure_both(fsm_urbanite_t *p_fsm, bool measure_both)
+{
+    if (p_fsm->measure_both == measure_both)
+    {
+        return;
+    }
+    p_fsm->measure_both = measure_both;
+
+    uint32_t state = fsm_get_state(&p_fsm->f);
+    if ((state == OFF) || (state == SLEEP_WHILE_OFF))
+    {
+        return;
+    }
+    // The system is ON: start or stop the side that is not the current one
+    fsm_ultrasound_t *p_fsm_ultrasound_other = p_fsm->is_rear ? p_fsm->p_fsm_ultrasound_front : p_fsm->p_fsm_ultrasound_rear;
+    fsm_display_t *p_fsm_display_other = p_fsm->is_rear ? p_fsm->p_fsm_display_front : p_fsm->p_fsm_display_rear;
+    if (measure_both)
+    {
+        fsm_ultrasound_start(p_fsm_ultrasound_other);
+        _reset_side(&p_fsm->sides[!p_fsm->is_rear]);
+    }
+    else
+    {
+        fsm_ultrasound_stop(p_fsm_ultrasound_other);
+    }
+    fsm_display_set_status(p_fsm_display_other, false);
+}
+
+bool fsm_urbanite_get_measure_both(fsm_urbanite_t *p_fsm)
+{
+    return p_fsm->measure_both;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file measurement_bus.c
+ * @brief Publish/subscribe bus of the measurements of the sensors.
+ *
+ * The sensors publish their measurements without knowing who consumes them, and the consumers (displays, buzzer, loggers, etc.) subscribe with a filter. Adding a consumer does not require to modify the sensors nor the other consumers. The bus has static storage and the records are passed by reference, so publishing neither allocates nor copies memory.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* Project includes */
+#include "measurement_bus.h"
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Subscriber of the bus.
+ *
+ */
+typedef struct
+{
+    measurement_bus_callback_t callback;                        /*!< Function called with the records. NULL if the slot is free */
+    void *p_context;                                            /*!< Pointer passed to `callback` */
+    measurement_bus_filter_t filter;                            /*!< Filter of the records */
+    uint32_t delivered_mask;                                    /*!< Sensors with at least one record delivered */
+    uint32_t last_distance_cm[MEASUREMENT_BUS_MAX_SENSORS];     /*!< Last distance in cm delivered of each sensor */
+    uint32_t last_ms[MEASUREMENT_BUS_MAX_SENSORS];              /*!< Timestamp in ms of the last record delivered of each sensor */
+} measurement_bus_subscriber_t;
+
+/* Global variables ------------------------------------------------------------*/
+/**
+ * @brief Subscribers of the bus.
+ *
+ */
+static measurement_bus_subscriber_t subscribers_arr[MEASUREMENT_BUS_MAX_SUBSCRIBERS];
+
+/* Private functions -----------------------------------------------------------*/
+/**
+ * @brief Check if a record passes the filter of a subscriber.
+ *
+ * @param p_sub Pointer to the subscriber.
+ * @param p_record Pointer to the record.
+ * @return true If the record must be delivered.
+ * @return false Otherwise.
+ */
+static bool _filter_accepts(const measurement_bus_subscriber_t *p_sub, const measurement_record_t *p_record)
+{
+    uint32_t id = p_record->sensor_id;
+    if ((id >= MEASUREMENT_BUS_MAX_SENSORS) || !(p_sub->filter.sensor_mask & (1U << id)))
+    {
+        return false;
+    }
+    if (!(p_sub->delivered_mask & (1U << id)))
+    {
+        return true;
+    }
+    uint32_t last_cm = p_sub->last_distance_cm[id];
+    uint32_t change_cm = (p_record->distance_cm > last_cm) ? (p_record->distance_cm - last_cm) : (last_cm - p_record->distance_cm);
+    if (change_cm < p_sub->filter.min_change_cm)
+    {
+        return false;
+    }
+    return (p_record->timestamp_ms - p_sub->last_ms[id]) >= p_sub->filter.min_period_ms;
+}
+
+/* Public functions -----------------------------------------------------------*/
+void measurement_bus_init(void)
+{
+    memset(subscribers_arr, 0, sizeof(subscribers_arr));
+}
+
+int32_t measurement_bus_subscribe(const measurement_bus_filter_t *p_filter, measurement_bus_callback_t callback, void *p_context)
+{
+    for (int32_t i = 0; i < MEASUREMENT_BUS_MAX_SUBSCRIBERS; i++)
+    {
+        measurement_bus_subscriber_t *p_sub = &subscribers_arr[i];
+        if (p_sub->callback == NULL)
+        {
+            memset(p_sub, 0, sizeof(*p_sub));
+            p_sub->filter = *p_filter;
+            p_sub->p_context = p_context;
+            p_sub->callback = callback;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void measurement_bus_unsubscribe(int32_t subscriber_id)
+{
+    if ((subscriber_id >= 0) && (subscriber_id < MEASUREMENT_BUS_MAX_SUBSCRIBERS))
+    {
+        subscribers_arr[subscriber_id].callback = NULL;
+    }
+}
+
+uint32_t measurement_bus_publish(const measurement_record_t *p_record)
+{
+    uint32_t delivered = 0;
+    for (uint32_t i = 0; i < MEASUREMENT_BUS_MAX_SUBSCRIBERS; i++)
+    {
+        measurement_bus_subscriber_t *p_sub = &subscribers_arr[i];
+        if ((p_sub->callback == NULL) || !_filter_accepts(p_sub, p_record))
+        {
+            continue;
+        }
+        p_sub->delivered_mask |= 1U << p_record->sensor_id;
+        p_sub->last_distance_cm[p_record->sensor_id] = p_record->distance_cm;
+        p_sub->last_ms[p_record->sensor_id] = p_record->timestamp_ms;
+        p_sub->callback(p_record, p_sub->p_context);
+        delivered++;
+    }
+    return delivered;
+}
@@ -0,0 +1,181 @@
+/**
+ * @file median_filter.c
+ * @brief Median selection kernels used to filter the distance measurements.
+ *
+ * The fixed sizes use the minimum comparator networks of N. Devillard, "Fast median search: an ANSI C implementation" (1998). Each comparator is a branchless compare-exchange, so the execution time does not depend on the data and there are no indirect calls as with `qsort()`.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Project includes */
+#include "median_filter.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/**
+ * @brief Branchless compare-exchange. After the macro, `a <= b`.
+ *
+ * The mask is all ones when the elements have to be swapped and all zeros otherwise.
+ *
+ */
+#define MEDIAN_FILTER_SORT(a, b)                     \
+    do                                               \
+    {                                                \
+        uint32_t _mask = -(uint32_t)((a) > (b));     \
+        uint32_t _diff = ((a) ^ (b)) & _mask;        \
+        (a) ^= _diff;                                \
+        (b) ^= _diff;                                \
+    } while (0)
+
+/**
+ * @brief Swap two elements of an array.
+ *
+ */
+#define MEDIAN_FILTER_SWAP(a, b) \
+    do                           \
+    {                            \
+        uint32_t _tmp = (a);     \
+        (a) = (b);               \
+        (b) = _tmp;              \
+    } while (0)
+
+/* Public functions -----------------------------------------------------------*/
+uint32_t median_filter_3(uint32_t *p)
+{
+    MEDIAN_FILTER_SORT(p[0], p[1]);
+    MEDIAN_FILTER_SORT(p[1], p[2]);
+    MEDIAN_FILTER_SORT(p[0], p[1]);
+    return p[1];
+}
+
+uint32_t median_filter_5(uint32_t *p)
+{
+    MEDIAN_FILTER_SORT(p[0], p[1]);
+    MEDIAN_FILTER_SORT(p[3], p[4]);
+    MEDIAN_FILTER_SORT(p[0], p[3]);
+    MEDIAN_FILTER_SORT(p[1], p[4]);
+    MEDIAN_FILTER_SORT(p[1], p[2]);
+    MEDIAN_FILTER_SORT(p[2], p[3]);
+    MEDIAN_FILTER_SORT(p[1], p[2]);
+    return p[2];
+}
+
+uint32_t median_filter_7(uint32_t *p)
+{
+    MEDIAN_FILTER_SORT(p[0], p[5]);
+    MEDIAN_FILTER_SORT(p[0], p[3]);
+    MEDIAN_FILTER_SORT(p[1], p[6]);
+    MEDIAN_FILTER_SORT(p[2], p[4]);
+    MEDIAN_FILTER_SORT(p[0], p[1]);
+    MEDIAN_FILTER_SORT(p[3], p[5]);
+    MEDIAN_FILTER_SORT(p[2], p[6]);
+    MEDIAN_FILTER_SORT(p[2], p[3]);
+    MEDIAN_FILTER_SORT(p[3], p[6]);
+    MEDIAN_FILTER_SORT(p[4], p[5]);
+    MEDIAN_FILTER_SORT(p[1], p[4]);
+    MEDIAN_FILTER_SORT(p[1], p[3]);
+    MEDIAN_FILTER_SORT(p[3], p[4]);
+    return p[3];
+}
+
+uint32_t median_filter_9(uint32_t *p)
+{
+    MEDIAN_FILTER_SORT(p[1], p[2]);
+    MEDIAN_FILTER_SORT(p[4], p[5]);
+    MEDIAN_FILTER_SORT(p[7], p[8]);
+    MEDIAN_FILTER_SORT(p[0], p[1]);
+    MEDIAN_FILTER_SORT(p[3], p[4]);
+    MEDIAN_FILTER_SORT(p[6], p[7]);
+    MEDIAN_FILTER_SORT(p[1], p[2]);
+    MEDIAN_FILTER_SORT(p[4], p[5]);
+    MEDIAN_FILTER_SORT(p[7], p[8]);
+    MEDIAN_FILTER_SORT(p[0], p[3]);
+    MEDIAN_FILTER_SORT(p[5], p[8]);
+    MEDIAN_FILTER_SORT(p[4], p[7]);
+    MEDIAN_FILTER_SORT(p[3], p[6]);
+    MEDIAN_FILTER_SORT(p[1], p[4]);
+    MEDIAN_FILTER_SORT(p[2], p[5]);
+    MEDIAN_FILTER_SORT(p[4], p[7]);
+    MEDIAN_FILTER_SORT(p[4], p[2]);
+    MEDIAN_FILTER_SORT(p[6], p[4]);
+    MEDIAN_FILTER_SORT(p[4], p[2]);
+    return p[4];
+}
+
+uint32_t median_filter_quickselect(uint32_t *p_values, uint32_t n, uint32_t k)
+{
+    uint32_t low = 0;
+    uint32_t high = n - 1;
+
+    while (low < high)
+    {
+        /* Median of three as pivot, placed in p_values[low] */
+        uint32_t middle = low + (high - low) / 2;
+        MEDIAN_FILTER_SORT(p_values[middle], p_values[high]);
+        MEDIAN_FILTER_SORT(p_values[low], p_values[high]);
+        MEDIAN_FILTER_SORT(p_values[middle], p_values[low]);
+        uint32_t pivot = p_values[low];
+
+        /* Partition: elements lower than the pivot to the left, greater to the right */
+        uint32_t i = low;
+        uint32_t j = high + 1;
+        while (1)
+        {
+            do
+            {
+                i++;
+            } while ((i <= high) && (p_values[i] < pivot));
+            do
+            {
+                j--;
+            } while (p_values[j] > pivot);
+            if (i >= j)
+            {
+                break;
+            }
+            MEDIAN_FILTER_SWAP(p_values[i], p_values[j]);
+        }
+        MEDIAN_FILTER_SWAP(p_values[low], p_values[j]);
+
+        /* Keep looking only in the side that contains the rank k */
+        if (j == k)
+        {
+            break;
+        }
+        else if (j > k)
+        {
+            high = j - 1;
+        }
+        else
+        {
+            low = j + 1;
+        }
+    }
+    return p_values[k];
+}
+
+uint32_t median_filter_select(uint32_t *p_values, uint32_t n)
+{
+    switch (n)
+    {
+    case 0:
+        return 0;
+    case 1:
+        return p_values[0];
+    case 3:
+        return median_filter_3(p_values);
+    case 5:
+        return median_filter_5(p_values);
+    case 7:
+        return median_filter_7(p_values);
+    case 9:
+        return median_filter_9(p_values);
+    default:
+        return median_filter_quickselect(p_values, n, n / 2);
+    }
+}
@@ -0,0 +1,137 @@
+/**
+ * @file output_conditioner.c
+ * @brief Conditioning of the distances shown by the outputs: hysteresis at the zone boundaries, minimum hold time and deadband.
+ *
+ * A distance that dithers around a zone boundary would change the color of a display or the tone of a buzzer in every measurement. The conditioner keeps the zone until the distance clearly leaves it, so the outputs are not updated (and the timers not reprogrammed) for changes that are only noise.
+ *
+ * Zones are sorted from the closest to the farthest. Only the changes to a farther (less severe) zone are delayed: an obstacle that gets closer is always shown at once.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* Project includes */
+#include "output_conditioner.h"
+
+/* Private functions -----------------------------------------------------------*/
+/**
+ * @brief Zone of a distance, taking into account the hysteresis of the boundaries above the current zone.
+ *
+ * The hysteresis only applies to the way to a farther zone. The way back to a closer zone only needs the distance to be inside it.
+ *
+ * @param p_cond Pointer to the conditioner.
+ * @param distance_cm Distance in cm.
+ * @param zone Zone to start from.
+ * @param use_hysteresis `false` to ignore the hysteresis (first distance after a reset).
+ * @return uint32_t Zone of the distance.
+ */
+static uint32_t _find_zone(const output_conditioner_t *p_cond, uint32_t distance_cm, uint32_t zone, bool use_hysteresis)
+{
+    const output_conditioner_boundary_t *p_bounds = p_cond->boundaries;
+    while ((zone < p_cond->num_boundaries) && ((uint64_t)distance_cm > (uint64_t)p_bounds[zone].max_cm + (use_hysteresis ? p_bounds[zone].hysteresis_cm : 0)))
+    {
+        zone++;
+    }
+    while ((zone > 0) && (distance_cm <= p_bounds[zone - 1].max_cm))
+    {
+        zone--;
+    }
+    return zone;
+}
+
+/**
+ * @brief Limit a distance to the range of a zone.
+ *
+ * @param p_cond Pointer to the conditioner.
+ * @param distance_cm Distance in cm.
+ * @param zone Zone.
+ * @return uint32_t Closest distance of the zone.
+ */
+static uint32_t _clamp_to_zone(const output_conditioner_t *p_cond, uint32_t distance_cm, uint32_t zone)
+{
+    if ((zone > 0) && (distance_cm <= p_cond->boundaries[zone - 1].max_cm))
+    {
+        return p_cond->boundaries[zone - 1].max_cm + 1;
+    }
+    if ((zone < p_cond->num_boundaries) && (distance_cm > p_cond->boundaries[zone].max_cm))
+    {
+        return p_cond->boundaries[zone].max_cm;
+    }
+    return distance_cm;
+}
+
+/* Public functions -----------------------------------------------------------*/
+bool output_conditioner_init(output_conditioner_t *p_cond, const output_conditioner_boundary_t *p_boundaries, uint32_t num_boundaries, uint32_t deadband_cm, uint32_t hold_ms)
+{
+    if (num_boundaries > OUTPUT_CONDITIONER_MAX_BOUNDARIES)
+    {
+        return false;
+    }
+    for (uint32_t i = 1; i < num_boundaries; i++)
+    {
+        if (p_boundaries[i].max_cm <= p_boundaries[i - 1].max_cm)
+        {
+            return false;
+        }
+    }
+    if (num_boundaries > 0)
+    {
+        memcpy(p_cond->boundaries, p_boundaries, num_boundaries * sizeof(output_conditioner_boundary_t));
+    }
+    p_cond->num_boundaries = num_boundaries;
+    p_cond->deadband_cm = deadband_cm;
+    p_cond->hold_ms = hold_ms;
+    output_conditioner_reset(p_cond);
+    return true;
+}
+
+void output_conditioner_reset(output_conditioner_t *p_cond)
+{
+    p_cond->zone = 0;
+    p_cond->distance_cm = 0;
+    p_cond->zone_start_ms = 0;
+    p_cond->valid = false;
+}
+
+uint32_t output_conditioner_update(output_conditioner_t *p_cond, uint32_t distance_cm, uint32_t now_ms)
+{
+    if (!p_cond->valid)
+    {
+        p_cond->zone = _find_zone(p_cond, distance_cm, 0, false);
+        p_cond->zone_start_ms = now_ms;
+        p_cond->distance_cm = distance_cm;
+        p_cond->valid = true;
+        return distance_cm;
+    }
+
+    uint32_t zone = _find_zone(p_cond, distance_cm, p_cond->zone, true);
+    // A closer zone is a warning and is shown at once. A farther zone waits for the hold time
+    if ((zone < p_cond->zone) || ((zone > p_cond->zone) && ((now_ms - p_cond->zone_start_ms) >= p_cond->hold_ms)))
+    {
+        // A new zone is always shown: the deadband only applies inside a zone
+        p_cond->zone = zone;
+        p_cond->zone_start_ms = now_ms;
+        p_cond->distance_cm = _clamp_to_zone(p_cond, distance_cm, zone);
+        return p_cond->distance_cm;
+    }
+
+    uint32_t clamped_cm = _clamp_to_zone(p_cond, distance_cm, p_cond->zone);
+    uint32_t change_cm = (clamped_cm > p_cond->distance_cm) ? clamped_cm - p_cond->distance_cm : p_cond->distance_cm - clamped_cm;
+    if (change_cm > p_cond->deadband_cm)
+    {
+        p_cond->distance_cm = clamped_cm;
+    }
+    return p_cond->distance_cm;
+}
+
+uint32_t output_conditioner_get_zone(const output_conditioner_t *p_cond)
+{
+    return p_cond->zone;
+}
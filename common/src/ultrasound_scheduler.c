@@ -0,0 +1,208 @@
+/**
+ * @file ultrasound_scheduler.c
+ * @brief Time-division scheduler of the triggers of several ultrasound sensors.
+ *
+ * Neighbouring HC-SR04 sensors on the same bumper hear each other's pings. The scheduler owns the trigger timeline: the sensors are split in groups without neighbours, only one group measures at a time, and a guard interval separates the end of a group from the trigger of the next one. The scheduler does not know anything about the sensors: it only receives which sensors are busy and returns which sensors must be triggered.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* Project includes */
+#include "ultrasound_scheduler.h"
+
+/* Private functions -----------------------------------------------------------*/
+/**
+ * @brief Check if a group of sensors contains two neighbouring sensors.
+ *
+ * @param mask Mask of the sensors of the group.
+ * @return true If sensors `i` and `i + 1` are both in the group for some `i`.
+ * @return false Otherwise.
+ */
+static bool _has_neighbours(uint32_t mask)
+{
+    return (mask & (mask >> 1)) != 0;
+}
+
+/**
+ * @brief Trigger the first group, starting at the current one, with enabled sensors.
+ *
+ * @param p_sched Pointer to the scheduler.
+ * @param now_ms Current time in ms.
+ * @return uint32_t Mask of the sensors that must be triggered. 0 if no sensor is enabled.
+ */
+static uint32_t _fire_group(ultrasound_scheduler_t *p_sched, uint32_t now_ms)
+{
+    for (uint32_t i = 0; i < p_sched->num_groups; i++)
+    {
+        uint32_t fired = p_sched->group_mask[p_sched->group] & p_sched->enabled_mask;
+        if (fired != 0)
+        {
+            for (uint32_t s = 0; s < p_sched->num_sensors; s++)
+            {
+                if (fired & (1U << s))
+                {
+                    uint32_t interval = now_ms - p_sched->last_fire_ms[s];
+                    if ((p_sched->fire_count[s] > 0) && (interval > p_sched->max_interval_ms[s]))
+                    {
+                        p_sched->max_interval_ms[s] = interval;
+                    }
+                    p_sched->last_fire_ms[s] = now_ms;
+                    p_sched->fire_count[s]++;
+                }
+            }
+            p_sched->fired_mask = fired;
+            p_sched->phase = ULTRASOUND_SCHEDULER_MEASURING;
+            return fired;
+        }
+        // Empty group: it takes no time
+        p_sched->group = (p_sched->group + 1) % p_sched->num_groups;
+    }
+    p_sched->phase = ULTRASOUND_SCHEDULER_IDLE;
+    return 0;
+}
+
+/**
+ * @brief Convert a number of measurements in a time to a rate in mHz.
+ *
+ * @param measurements Number of measurements.
+ * @param elapsed_ms Time in ms.
+ * @return uint32_t Rate in mHz.
+ */
+static uint32_t _rate_mhz(uint32_t measurements, uint32_t elapsed_ms)
+{
+    if (elapsed_ms == 0)
+    {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)measurements * 1000000U) / elapsed_ms);
+}
+
+/* Public functions -----------------------------------------------------------*/
+bool ultrasound_scheduler_init(ultrasound_scheduler_t *p_sched, uint32_t num_sensors, uint32_t num_groups, uint32_t guard_ms, uint32_t now_ms)
+{
+    if ((num_sensors == 0) || (num_sensors > ULTRASOUND_SCHEDULER_MAX_SENSORS) || (num_groups == 0) || (num_groups > num_sensors))
+    {
+        return false;
+    }
+    memset(p_sched, 0, sizeof(*p_sched));
+    p_sched->num_sensors = num_sensors;
+    p_sched->guard_ms = guard_ms;
+    p_sched->enabled_mask = (1U << num_sensors) - 1;
+
+    uint32_t group_mask[ULTRASOUND_SCHEDULER_MAX_SENSORS] = {0};
+    for (uint32_t s = 0; s < num_sensors; s++)
+    {
+        group_mask[s % num_groups] |= 1U << s;
+    }
+    if (!ultrasound_scheduler_set_groups(p_sched, group_mask, num_groups))
+    {
+        return false;
+    }
+    ultrasound_scheduler_reset_stats(p_sched, now_ms);
+    return true;
+}
+
+bool ultrasound_scheduler_set_groups(ultrasound_scheduler_t *p_sched, const uint32_t *p_group_mask, uint32_t num_groups)
+{
+    if ((num_groups == 0) || (num_groups > p_sched->num_sensors))
+    {
+        return false;
+    }
+    uint32_t all_mask = (1U << p_sched->num_sensors) - 1;
+    uint32_t seen_mask = 0;
+    for (uint32_t g = 0; g < num_groups; g++)
+    {
+        uint32_t mask = p_group_mask[g];
+        if ((mask & ~all_mask) || (mask & seen_mask) || _has_neighbours(mask))
+        {
+            return false;
+        }
+        seen_mask |= mask;
+    }
+    if (seen_mask != all_mask)
+    {
+        return false;
+    }
+
+    memcpy(p_sched->group_mask, p_group_mask, num_groups * sizeof(uint32_t));
+    p_sched->num_groups = num_groups;
+    p_sched->group = 0;
+    p_sched->fired_mask = 0;
+    p_sched->phase = ULTRASOUND_SCHEDULER_IDLE;
+    return true;
+}
+
+void ultrasound_scheduler_set_enabled(ultrasound_scheduler_t *p_sched, uint32_t enabled_mask)
+{
+    p_sched->enabled_mask = enabled_mask & ((1U << p_sched->num_sensors) - 1);
+}
+
+uint32_t ultrasound_scheduler_update(ultrasound_scheduler_t *p_sched, uint32_t now_ms, uint32_t busy_mask)
+{
+    if (p_sched->phase == ULTRASOUND_SCHEDULER_MEASURING)
+    {
+        if (busy_mask & p_sched->fired_mask)
+        {
+            return 0;
+        }
+        // The whole group has finished: its measurements count and the guard interval starts
+        for (uint32_t s = 0; s < p_sched->num_sensors; s++)
+        {
+            if (p_sched->fired_mask & (1U << s))
+            {
+                p_sched->measurements[s]++;
+            }
+        }
+        p_sched->fired_mask = 0;
+        p_sched->guard_start_ms = now_ms;
+        p_sched->phase = ULTRASOUND_SCHEDULER_GUARD;
+    }
+    if (p_sched->phase == ULTRASOUND_SCHEDULER_GUARD)
+    {
+        if ((now_ms - p_sched->guard_start_ms) < p_sched->guard_ms)
+        {
+            return 0;
+        }
+        p_sched->group = (p_sched->group + 1) % p_sched->num_groups;
+    }
+    // Never trigger a sensor that is still measuring (e.g. stopped and restarted by the user)
+    if (busy_mask & p_sched->enabled_mask)
+    {
+        p_sched->phase = ULTRASOUND_SCHEDULER_IDLE;
+        return 0;
+    }
+    return _fire_group(p_sched, now_ms);
+}
+
+void ultrasound_scheduler_get_stats(const ultrasound_scheduler_t *p_sched, uint32_t sensor, uint32_t now_ms, ultrasound_scheduler_stats_t *p_stats)
+{
+    p_stats->measurements = p_sched->measurements[sensor];
+    p_stats->rate_mhz = _rate_mhz(p_sched->measurements[sensor], now_ms - p_sched->stats_start_ms);
+    p_stats->max_interval_ms = p_sched->max_interval_ms[sensor];
+}
+
+uint32_t ultrasound_scheduler_get_total_rate_mhz(const ultrasound_scheduler_t *p_sched, uint32_t now_ms)
+{
+    uint32_t total = 0;
+    for (uint32_t s = 0; s < p_sched->num_sensors; s++)
+    {
+        total += p_sched->measurements[s];
+    }
+    return _rate_mhz(total, now_ms - p_sched->stats_start_ms);
+}
+
+void ultrasound_scheduler_reset_stats(ultrasound_scheduler_t *p_sched, uint32_t now_ms)
+{
+    p_sched->stats_start_ms = now_ms;
+    memset(p_sched->measurements, 0, sizeof(p_sched->measurements));
+    memset(p_sched->max_interval_ms, 0, sizeof(p_sched->max_interval_ms));
+    memset(p_sched->fire_count, 0, sizeof(p_sched->fire_count));
+}
@@ -18,6 +18,7 @@
 #include "port_ultrasound.h"
 #include "port_display.h"
 #include "port_buzzer.h"
+#include "port_temperature.h"
 
 /* Project includes */
 #include "fsm.h"
@@ -46,6 +47,56 @@
  */
 #define URBANITE_PAUSE_DISPLAY_TIME_MS 500
 
+/**
+ * @brief Range of interest in cm of the parking sensors. Farther obstacles are not shown by the displays nor the buzzer, so their echoes are abandoned to measure faster.
+ *
+ */
+#define URBANITE_RANGE_OF_INTEREST_CM OK_MAX_CM
+
+/**
+ * @brief Measure the front and rear sides at the same time, so that changing between front and rear maneuver is instant.
+ *
+ */
+#define URBANITE_MEASURE_BOTH_SIDES true
+
+/**
+ * @brief Duration in ms of the fade of the displays from a color to the next one.
+ *
+ */
+#define URBANITE_DISPLAY_FADE_MS 160
+
+/**
+ * @brief Period in ms of the pulse of the displays when the obstacle is in the danger zone.
+ *
+ */
+#define URBANITE_DISPLAY_PULSE_PERIOD_MS 480
+
+/**
+ * @brief Minimum time in ms that the displays and the buzzer show a zone before changing to another one.
+ *
+ */
+#define URBANITE_OUTPUT_HOLD_MS 150
+
+/**
+ * @brief Change in cm of the distance inside a zone that the buzzer ignores, so that its tone does not chatter.
+ *
+ */
+#define URBANITE_BUZZER_DEADBAND_CM 2
+
+/* Global variables ------------------------------------------------------------*/
+/**
+ * @brief Boundaries of the zones of the displays and the buzzer, with a hysteresis that grows with the distance as the noise of the measurements does.
+ *
+ */
+static const output_conditioner_boundary_t urbanite_boundaries_arr[] = {
+    {.max_cm = DANGER_MIN_CM, .hysteresis_cm = 1},
+    {.max_cm = WARNING_MIN_CM, .hysteresis_cm = 2},
+    {.max_cm = NO_PROBLEM_MIN_CM, .hysteresis_cm = 3},
+    {.max_cm = INFO_MIN_CM, .hysteresis_cm = 5},
+    {.max_cm = OK_MIN_CM, .hysteresis_cm = 5},
+    {.max_cm = OK_MAX_CM, .hysteresis_cm = 5},
+};
+
 
 /**
  * @brief  Main function. Entry point of the program.
@@ -55,17 +106,37 @@ int main(void)
 {
     /* Init board */
     port_system_init();
+    port_temperature_init();
     fsm_button_t *p_fsm_button = fsm_button_new(PORT_PARKING_BUTTON_DEBOUNCE_TIME_MS, PORT_PARKING_BUTTON_ID);
     fsm_ultrasound_t *p_fsm_ultrasound_front = fsm_ultrasound_new(PORT_FRONT_PARKING_SENSOR_ID);
     fsm_display_t *p_fsm_display_front = fsm_display_new(PORT_FRONT_PARKING_DISPLAY_ID);
     fsm_ultrasound_t *p_fsm_ultrasound_rear = fsm_ultrasound_new(PORT_REAR_PARKING_SENSOR_ID);
     fsm_display_t *p_fsm_display_rear = fsm_display_new(PORT_REAR_PARKING_DISPLAY_ID);
+    fsm_ultrasound_set_max_range(p_fsm_ultrasound_front, URBANITE_RANGE_OF_INTEREST_CM);
+    fsm_ultrasound_set_max_range(p_fsm_ultrasound_rear, URBANITE_RANGE_OF_INTEREST_CM);
+    fsm_display_set_fade(p_fsm_display_front, URBANITE_DISPLAY_FADE_MS, URBANITE_DISPLAY_PULSE_PERIOD_MS);
+    fsm_display_set_fade(p_fsm_display_rear, URBANITE_DISPLAY_FADE_MS, URBANITE_DISPLAY_PULSE_PERIOD_MS);
+    uint32_t num_boundaries = sizeof(urbanite_boundaries_arr) / sizeof(urbanite_boundaries_arr[0]);
+    fsm_display_set_conditioning(p_fsm_display_front, urbanite_boundaries_arr, num_boundaries, 0, URBANITE_OUTPUT_HOLD_MS);
+    fsm_display_set_conditioning(p_fsm_display_rear, urbanite_boundaries_arr, num_boundaries, 0, URBANITE_OUTPUT_HOLD_MS);
     fsm_buzzer_t *p_fsm_buzzer = fsm_buzzer_new(PORT_PARKING_BUZZER_ID);
+    fsm_buzzer_set_conditioning(p_fsm_buzzer, urbanite_boundaries_arr, num_boundaries, URBANITE_BUZZER_DEADBAND_CM, URBANITE_OUTPUT_HOLD_MS);
     fsm_urbanite_t *p_fsm_urbanite = fsm_urbanite_new(p_fsm_button, URBANITE_ON_OFF_PRESS_TIME_MS, URBANITE_FRONT_REAR_PRESS_TIME_MS, URBANITE_PAUSE_DISPLAY_TIME_MS, p_fsm_ultrasound_front, p_fsm_display_front, p_fsm_ultrasound_rear, p_fsm_display_rear, p_fsm_buzzer);
+    fsm_urbanite_set_measure_both(p_fsm_urbanite, URBANITE_MEASURE_BOTH_SIDES);
+    uint32_t last_temperature_ms = port_system_get_millis() - PORT_TEMPERATURE_UPDATE_PERIOD_MS;
 
     /* Infinite loop */
     while (1)
     {
+        // Compensate the speed of sound with the temperature of the air
+        if ((port_system_get_millis() - last_temperature_ms) >= PORT_TEMPERATURE_UPDATE_PERIOD_MS)
+        {
+            last_temperature_ms = port_system_get_millis();
+            int32_t temperature_c = port_temperature_get_celsius();
+            fsm_ultrasound_set_temperature(p_fsm_ultrasound_front, temperature_c);
+            fsm_ultrasound_set_temperature(p_fsm_ultrasound_rear, temperature_c);
+        }
+
         fsm_button_fire(p_fsm_button);
         fsm_ultrasound_fire(p_fsm_ultrasound_front);
         fsm_display_fire(p_fsm_display_front);
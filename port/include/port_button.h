@@ -16,6 +16,9 @@
 #include <string.h>
 #include <stdio.h>
 
+/* HW dependent includes */
+#include "port_event_queue.h"
+
 /* Defines and enums ----------------------------------------------------------*/
 /* Defines */
 // Define here all the button identifiers that are used in the system
@@ -31,6 +34,16 @@
  */
 #define PORT_PARKING_BUTTON_DEBOUNCE_TIME_MS 100
 
+/**
+ * @enum PORT_BUTTON_EVENT
+ * 
+ * @brief Types of the events that the interrupt of a button pushes to its event queue (see `port_event_queue.h`).
+ */
+enum PORT_BUTTON_EVENT {
+    PORT_BUTTON_EVENT_PRESSED = 0,  /**< The button has been pressed */
+    PORT_BUTTON_EVENT_RELEASED      /**< The button has been released */
+};
+
 /* Function prototypes and explanation -------------------------------------------------*/
 /**
  * @brief Configure the HW specifications of a given button.
@@ -96,4 +109,42 @@ void 	port_button_clear_pending_interrupt (uint32_t button_id);
  */
 void 	port_button_disable_interrupts (uint32_t button_id);
 
+/**
+ * @brief Push an event of a button to its event queue.
+ * 
+ * This function is called from the ISR instead of `port_button_set_pressed()`, so the ISR never writes the status of the button.
+ * 
+ * @param button_id Button ID. This index is used to get the correct button structure of the `buttons_arr[]` array.
+ * @param pressed true if the button has been pressed, false if it has been released.
+ */
+void 	port_button_push_event (uint32_t button_id, bool pressed);
+
+/**
+ * @brief Pop the oldest pending event of a button.
+ * 
+ * The interrupt never writes the status of the button. The FSM pops the events one by one in its `fire` function, applies each one with `port_button_set_pressed()` and checks its transitions at the time of the event, so a press and a release between two calls are both seen.
+ * 
+ * @param button_id Button ID. This index is used to get the correct button structure of the `buttons_arr[]` array.
+ * @param p_event Pointer to the structure where the event is stored. Its type is one of `PORT_BUTTON_EVENT`.
+ * @return true If an event has been popped.
+ * @return false If there are no pending events.
+ */
+bool 	port_button_pop_event (uint32_t button_id, port_event_t *p_event);
+
+/**
+ * @brief Get the number of events pushed by the interrupt of a button since its initialization.
+ * 
+ * @param button_id Button ID. This index is used to get the correct button structure of the `buttons_arr[]` array.
+ * @return uint32_t Number of events.
+ */
+uint32_t port_button_get_event_count (uint32_t button_id);
+
+/**
+ * @brief Get the number of events of a button lost because its event queue was full.
+ * 
+ * @param button_id Button ID. This index is used to get the correct button structure of the `buttons_arr[]` array.
+ * @return uint32_t Number of events lost. It must be 0 unless the main loop stalls.
+ */
+uint32_t port_button_get_event_overflows (uint32_t button_id);
+
 #endif
\ No newline at end of file
@@ -31,6 +31,18 @@
  * 
  */
 #define 	PORT_BUZZER_MIN_VALUE 0
+
+/**
+ * @brief Frequency in Hz of the tone of sound level 0. Level 0 itself is silence.
+ * 
+ */
+#define 	PORT_BUZZER_TONE_BASE_HZ 200
+
+/**
+ * @brief Increment in Hz of the frequency of the tone for each sound level: from 209 Hz (level 1) to 2495 Hz (level 255).
+ * 
+ */
+#define 	PORT_BUZZER_TONE_STEP_HZ 9
  
 
 
@@ -46,7 +58,7 @@ void port_buzzer_init	(uint32_t buzzer_id);
 /**
  * @brief Set the Capture/Compare register values for the buzzer.
  * 
- * This function disables the timer associated to the buzzer, sets the Capture/Compare register values for the buzzer, and enables the timer.
+ * The prescaler, auto-reload and Capture/Compare values of each sound are computed once in `port_buzzer_init()`. This function only writes them to the timer, which applies them at its next update event, without stopping it. Sound 0 is silence.
  * 
  * @param buzzer_id Buzzer system identifier number.
  * @param sound 	Sound to set.
@@ -11,6 +11,7 @@
 /* Includes ------------------------------------------------------------------*/
 /* Standard C includes */
 #include <stdint.h>
+#include <stdbool.h>
 
 /* Typedefs --------------------------------------------------------------------*/
 /**
@@ -58,6 +59,18 @@ typedef struct{
  * 
  */
 #define 	PORT_DISPLAY_RGB_MAX_VALUE 255
+
+/**
+ * @brief Duration in ms of a frame of a color sequence: one period of the PWM of the RGB LED.
+ * 
+ */
+#define 	PORT_DISPLAY_FRAME_MS 20
+
+/**
+ * @brief Maximum number of frames of a color sequence played by the HW.
+ * 
+ */
+#define 	PORT_DISPLAY_MAX_FRAMES 32
  
 /**
  * @brief Red color
@@ -107,8 +120,7 @@ void port_display_init	(uint32_t display_id);
 /**
  * @brief Set the Capture/Compare register values for each channel of the RGB LED given a color.
  * 
- * This function disables the timer associated to the RGB LEDs, sets the Capture/Compare register values for each channel of the RGB LED, and enables the timer.
- * 
+ * Only the Capture/Compare registers of the channels whose level changes are written. The new color is applied at the end of the current period of the PWM, without stopping the timer. Any color sequence being played is stopped.
  * 
  * @attention This function is valid for any given RGB LED, however, each RGB LED has its own timer.
  * 
@@ -117,5 +129,27 @@ void port_display_init	(uint32_t display_id);
  */
 void port_display_set_rgb(uint32_t 	display_id, rgb_color_t color );
 
+/**
+ * @brief Get the color set in the Capture/Compare registers of the RGB LED.
+ * 
+ * While a color sequence is played, it is the frame being shown.
+ * 
+ * @param display_id Display system identifier number.
+ * @return rgb_color_t Color of the RGB LED.
+ */
+rgb_color_t port_display_get_rgb(uint32_t display_id);
+
+/**
+ * @brief Play a sequence of colors on the RGB LED, one frame per period of the PWM (`PORT_DISPLAY_FRAME_MS`).
+ * 
+ * The HW plays the sequence by itself, so the CPU is not involved once this function returns. Any color sequence being played is replaced.
+ * 
+ * @param display_id Display system identifier number.
+ * @param p_frames Array of colors. It is copied, so it can be freed after the call.
+ * @param num_frames Number of frames, from 1 to `PORT_DISPLAY_MAX_FRAMES`. Longer sequences are truncated.
+ * @param loop `true` to repeat the sequence until another color or sequence is set. `false` to keep the last frame once the sequence ends.
+ */
+void port_display_play(uint32_t display_id, const rgb_color_t *p_frames, uint32_t num_frames, bool loop);
+
 
 #endif /* PORT_DISPLAY_SYSTEM_H_ */
\ No newline at end of file
@@ -0,0 +1,158 @@
+/**
+ * @file port_event_queue.h
+ * @brief Lock-free single-producer/single-consumer queue of timestamped hardware events.
+ *
+ * Each device has one queue: its interrupts push the events (e.g. "the trigger timer has expired") and the FSM of the device pops them in its `fire` function. Unlike a shared boolean flag, a queue keeps every repeated event and the order between events, and it counts the events that did not fit. Since every hardware event goes through one queue, tracing or replaying the events of a device only needs this queue.
+ *
+ * The producer only writes `head` and the consumer only writes `tail`, so neither needs to disable the interrupts. There must be a single producer (e.g. the interrupts of one priority) and a single consumer per queue.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+#ifndef PORT_EVENT_QUEUE_H_
+#define PORT_EVENT_QUEUE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/**
+ * @brief Number of events that a queue can hold. Must be a power of 2.
+ *
+ */
+#define PORT_EVENT_QUEUE_SIZE 16
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Hardware event.
+ *
+ */
+typedef struct
+{
+    uint32_t timestamp_ms;  /*!< System time in ms when the event happened */
+    uint32_t data;          /*!< Data of the event. Its meaning depends on the type */
+    uint8_t type;           /*!< Type of the event. The values are defined by each device */
+} port_event_t;
+
+/**
+ * @brief Queue of hardware events. Its fields must not be accessed by the user.
+ *
+ */
+typedef struct
+{
+    port_event_t events[PORT_EVENT_QUEUE_SIZE]; /*!< Circular buffer of events */
+    _Atomic uint32_t head;                      /*!< Number of events pushed. Only written by the producer */
+    _Atomic uint32_t tail;                      /*!< Number of events popped. Only written by the consumer */
+    _Atomic uint32_t overflows;                 /*!< Number of events lost because the queue was full. Only written by the producer */
+} port_event_queue_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Initialize an empty event queue.
+ *
+ * @param p_queue Pointer to the event queue.
+ */
+static inline void port_event_queue_init(port_event_queue_t *p_queue)
+{
+    atomic_init(&p_queue->head, 0);
+    atomic_init(&p_queue->tail, 0);
+    atomic_init(&p_queue->overflows, 0);
+}
+
+/**
+ * @brief Push an event to a queue. It must only be called by the producer.
+ *
+ * @param p_queue Pointer to the event queue.
+ * @param type Type of the event.
+ * @param data Data of the event.
+ * @param timestamp_ms System time in ms of the event.
+ * @return true If the event has been pushed.
+ * @return false If the queue was full. The event is lost and counted as an overflow.
+ */
+static inline bool port_event_queue_push(port_event_queue_t *p_queue, uint8_t type, uint32_t data, uint32_t timestamp_ms)
+{
+    uint32_t head = atomic_load_explicit(&p_queue->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&p_queue->tail, memory_order_acquire);
+    if ((head - tail) >= PORT_EVENT_QUEUE_SIZE)
+    {
+        atomic_store_explicit(&p_queue->overflows, atomic_load_explicit(&p_queue->overflows, memory_order_relaxed) + 1, memory_order_relaxed);
+        return false;
+    }
+    port_event_t *p_event = &p_queue->events[head % PORT_EVENT_QUEUE_SIZE];
+    p_event->timestamp_ms = timestamp_ms;
+    p_event->data = data;
+    p_event->type = type;
+    // The event must be complete before the consumer sees it
+    atomic_store_explicit(&p_queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Pop the oldest event of a queue. It must only be called by the consumer.
+ *
+ * @param p_queue Pointer to the event queue.
+ * @param p_event Pointer to the structure where the event is stored.
+ * @return true If an event has been popped.
+ * @return false If the queue was empty.
+ */
+static inline bool port_event_queue_pop(port_event_queue_t *p_queue, port_event_t *p_event)
+{
+    uint32_t tail = atomic_load_explicit(&p_queue->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&p_queue->head, memory_order_acquire);
+    if (head == tail)
+    {
+        return false;
+    }
+    *p_event = p_queue->events[tail % PORT_EVENT_QUEUE_SIZE];
+    // The event must be copied before the producer can overwrite it
+    atomic_store_explicit(&p_queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Read the oldest event of a queue without popping it. It must only be called by the consumer.
+ *
+ * @param p_queue Pointer to the event queue.
+ * @param p_event Pointer to the structure where the event is stored.
+ * @return true If the queue has an event.
+ * @return false If the queue was empty.
+ */
+static inline bool port_event_queue_peek(port_event_queue_t *p_queue, port_event_t *p_event)
+{
+    uint32_t tail = atomic_load_explicit(&p_queue->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&p_queue->head, memory_order_acquire);
+    if (head == tail)
+    {
+        return false;
+    }
+    *p_event = p_queue->events[tail % PORT_EVENT_QUEUE_SIZE];
+    return true;
+}
+
+/**
+ * @brief Get the number of events pushed to a queue since its initialization, not counting the overflows.
+ *
+ * @param p_queue Pointer to the event queue.
+ * @return uint32_t Number of events pushed.
+ */
+static inline uint32_t port_event_queue_get_count(port_event_queue_t *p_queue)
+{
+    return atomic_load_explicit(&p_queue->head, memory_order_relaxed);
+}
+
+/**
+ * @brief Get the number of events lost because a queue was full.
+ *
+ * @param p_queue Pointer to the event queue.
+ * @return uint32_t Number of events lost.
+ */
+static inline uint32_t port_event_queue_get_overflows(port_event_queue_t *p_queue)
+{
+    return atomic_load_explicit(&p_queue->overflows, memory_order_relaxed);
+}
+
+#endif /* PORT_EVENT_QUEUE_H_ */
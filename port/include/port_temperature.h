@@ -0,0 +1,39 @@
+/**
+ * @file port_temperature.h
+ * @brief Header for the portable functions to read the temperature of the air. The functions must be implemented in the platform-specific code.
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+#ifndef PORT_TEMPERATURE_H_
+#define PORT_TEMPERATURE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+/**
+ * @brief Period in ms to update the temperature used by the ultrasound sensors. The temperature of the air changes slowly.
+ * 
+ */
+#define PORT_TEMPERATURE_UPDATE_PERIOD_MS 1000
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Configure the HW of the temperature sensor and start the conversions.
+ * 
+ * The conversions run in the background without interrupting the CPU, so `port_temperature_get_celsius()` only reads the last one.
+ * 
+ */
+void port_temperature_init (void);
+
+/**
+ * @brief Get the last temperature measured by the temperature sensor.
+ * 
+ * @return int32_t Temperature in degrees Celsius.
+ */
+int32_t port_temperature_get_celsius (void);
+
+#endif /* PORT_TEMPERATURE_H_ */
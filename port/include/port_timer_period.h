@@ -0,0 +1,115 @@
+/**
+ * @file port_timer_period.h
+ * @brief Integer computation of the prescaler and the auto-reload values of a timer for a given frequency, and of tables of tones.
+ *
+ * It gives the same values as the previous computation with `double` and `round()`, which is soft-float library code on an FPU of single precision:
+ *
+ * @code
+ * psc = round(clock / freq / 65536 - 1);
+ * arr = round(clock / freq / (psc + 1) - 1);
+ * if (arr > 65535) { psc += 1; arr = round(clock / freq / (psc + 1) - 1); }
+ * @endcode
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+#ifndef PORT_TIMER_PERIOD_H_
+#define PORT_TIMER_PERIOD_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/**
+ * @brief Number of values of a 16-bit prescaler or auto-reload register.
+ *
+ */
+#define PORT_TIMER_PERIOD_RANGE 65536U
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Register values of a timer for a tone.
+ *
+ */
+typedef struct
+{
+    uint16_t psc; /*!< Prescaler (PSC) */
+    uint16_t arr; /*!< Auto-reload (ARR): period of the tone */
+    uint16_t ccr; /*!< Capture/compare (CCRx): duty cycle of the tone. 0 for silence */
+} port_timer_period_tone_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Division of positive integers rounded to the nearest integer, halves up.
+ *
+ * @param num Numerator.
+ * @param den Denominator. Must not be 0.
+ * @return uint64_t Rounded quotient.
+ */
+static inline uint64_t port_timer_period_div_round(uint64_t num, uint64_t den)
+{
+    return (2 * num + den) / (2 * den);
+}
+
+/**
+ * @brief Compute the prescaler (PSC) and auto-reload (ARR) values of a timer for a frequency.
+ *
+ * The prescaler is the smallest one that fits the period in a 16-bit auto-reload register, so the resolution of the compare registers is the highest.
+ *
+ * @param clock_hz Frequency in Hz of the clock of the timer.
+ * @param freq_hz Frequency in Hz of the period of the timer. Must not be 0.
+ * @param p_psc Pointer where the value of PSC is stored.
+ * @param p_arr Pointer where the value of ARR is stored.
+ */
+static inline void port_timer_period_solve(uint32_t clock_hz, uint32_t freq_hz, uint32_t *p_psc, uint32_t *p_arr)
+{
+    uint64_t psc;
+    // round(x - 1) rounds the halves away from zero: it is -1 for x <= 0.5, which leaves no valid ARR and always needs the correction below
+    if (2 * (uint64_t)clock_hz <= (uint64_t)freq_hz * PORT_TIMER_PERIOD_RANGE)
+    {
+        psc = 0;
+    }
+    else
+    {
+        psc = port_timer_period_div_round(clock_hz, (uint64_t)freq_hz * PORT_TIMER_PERIOD_RANGE) - 1;
+        uint64_t arr = port_timer_period_div_round(clock_hz, (uint64_t)freq_hz * (psc + 1)) - 1;
+        if (arr < PORT_TIMER_PERIOD_RANGE)
+        {
+            *p_psc = (uint32_t)psc;
+            *p_arr = (uint32_t)arr;
+            return;
+        }
+        psc++;
+    }
+    *p_psc = (uint32_t)psc;
+    *p_arr = (uint32_t)(port_timer_period_div_round(clock_hz, (uint64_t)freq_hz * (psc + 1)) - 1);
+}
+
+/**
+ * @brief Compute the register values of a timer for a table of tones whose frequency grows linearly with the level.
+ *
+ * The tone of a level has a frequency of `base_hz + step_hz * level` and a duty cycle of `ccr` counts. Level 0 is silence: a duty cycle of 0 keeps the output low in PWM mode 1, so the output compare never has to be disabled.
+ *
+ * @param clock_hz Frequency in Hz of the clock of the timer.
+ * @param base_hz Frequency in Hz of level 0. Must not be 0.
+ * @param step_hz Increment in Hz of the frequency for each level.
+ * @param ccr Duty cycle in counts of the levels above 0. It must be lower than the ARR of the highest level.
+ * @param p_tones Array where the table is stored.
+ * @param num_levels Number of levels of the table.
+ */
+static inline void port_timer_period_build_tones(uint32_t clock_hz, uint32_t base_hz, uint32_t step_hz, uint16_t ccr, port_timer_period_tone_t *p_tones, uint32_t num_levels)
+{
+    for (uint32_t level = 0; level < num_levels; level++)
+    {
+        uint32_t psc;
+        uint32_t arr;
+        port_timer_period_solve(clock_hz, base_hz + step_hz * level, &psc, &arr);
+        p_tones[level].psc = (uint16_t)psc;
+        p_tones[level].arr = (uint16_t)arr;
+        p_tones[level].ccr = (level == 0) ? 0 : ccr;
+    }
+}
+
+#endif /* PORT_TIMER_PERIOD_H_ */
@@ -13,6 +13,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/* HW dependent includes */
+#include "port_event_queue.h"
+
 /* Defines and enums ----------------------------------------------------------*/
 /**
  * @brief Front parking sensor identifier.
@@ -33,23 +36,45 @@
 #define PORT_PARKING_SENSOR_TRIGGER_UP_US 10
 
 /**
- * @brief Time in ms to wait for the next measurement.
+ * @brief Default time in ms to wait for the next measurement.
  * 
  */
 #define PORT_PARKING_SENSOR_TIMEOUT_MS 100
 
 /**
- * @brief Speed of sound in air in m/s.
+ * @brief Speed of sound in air in m/s at 20 degrees Celsius. The ultrasound FSM compensates it with the temperature of the air (see `fsm_ultrasound_set_temperature()`).
  * 
  */
 #define SPEED_OF_SOUND_MS 343
 
 /**
- * @brief Maximum time to wait for the echo signal to be received.
+ * @brief Minimum time in ms to wait for the echo signal to be received. The FSM waits longer if its range of interest needs it (see `fsm_ultrasound_get_echo_timeout_ms()`).
  * 
  */
 #define FSM_ULTRASOUND_ECHO_TIMEOUT_MS 20
 
+/**
+ * @enum PORT_ULTRASOUND_EVENT
+ * 
+ * @brief Types of the events that the interrupts of an ultrasound sensor push to its event queues (see `port_event_queue.h`).
+ */
+enum PORT_ULTRASOUND_EVENT {
+    PORT_ULTRASOUND_EVENT_TRIGGER_END = 0,  /**< The time of the trigger signal has expired */
+    PORT_ULTRASOUND_EVENT_TRIGGER_READY     /**< The time of the measurement has expired */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Snapshot of the echo signal of an ultrasound sensor (see `port_ultrasound_read_echo()`).
+ * 
+ */
+typedef struct
+{
+    uint32_t echo_init_tick;    /*!< Tick of the start of the echo signal. 0 if it has not been captured yet */
+    uint32_t echo_end_tick;     /*!< Tick of the end of the echo signal. 0 if it has not been captured yet */
+    bool echo_received;         /*!< Flag to indicate that both edges of the echo signal have been captured */
+} port_ultrasound_echo_t;
+
 /* Function prototypes and explanation -------------------------------------------------*/
 /**
  * @brief Configure the HW specifications of a given ultrasound sensor.
@@ -61,7 +86,7 @@ void port_ultrasound_init (uint32_t ultrasound_id);
 /**
  * @brief Start a new measurement of the ultrasound sensor.
  * 
- * This function prepares the timer of the trigger and the timer of the echo signal to start a new measurement. It also enables the timer that controls the new measurement.
+ * This function prepares the timer of the trigger and enables the capture of the echo signal to start a new measurement. The echo timer is never reset, so a measurement of one sensor does not disturb the measurement in progress of another. It also enables the timer that controls the new measurement.
  * 
  * @attention The timer that controls the time of a new measurement is common for all the ultrasound sensors in the system, but the timers that controls the trigger and echo signal are specific for each ultrasound sensor and must be configured separately (within a conditional statement).
  * 
@@ -72,16 +97,16 @@ void port_ultrasound_start_measurement (uint32_t ultrasound_id);
 /**
  * @brief Stop the timer that controls the trigger signal.
  * 
- * This function stops the timer that controls the trigger signal because the time to trigger the ultrasound sensor has finished. It also sets the trigger signal to low.
+ * This function stops the timer that controls the trigger signal because the time to trigger the ultrasound sensor has finished. It also sets the trigger signal to low. If the platform generates the trigger pulse in hardware, the pulse is never cut short: the timer is only stopped once the pulse is over.
  * 
  * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
  */
 void port_ultrasound_stop_trigger_timer (uint32_t ultrasound_id);
 
 /**
- * @brief Stop the timer that controls the echo signal.
+ * @brief Stop capturing the echo signal of an ultrasound sensor.
  * 
- * This function stops the timer that controls the echo signal because the echo signal has been received.
+ * This function stops listening to the echo signal because the echo signal has been received: its next edges are discarded by `port_ultrasound_consume_echo_edges()`. The echo timer itself is a timebase shared by all the ultrasound sensors, so it keeps running and the measurements of the other sensors are not affected.
  * 
  * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
  */
@@ -103,6 +128,24 @@ void port_ultrasound_start_new_measurement_timer (uint32_t ultrasound_id);
  */
 void port_ultrasound_stop_new_measurement_timer (uint32_t ultrasound_id);
 
+/**
+ * @brief Set the period of the timer that controls the new measurements.
+ * 
+ * The new period takes effect at the end of the current one. The registers are only written if the period changes, so this function can be called after every measurement.
+ * 
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
+ * @param period_ms New period in ms. The initial value is `PORT_PARKING_SENSOR_TIMEOUT_MS`.
+ */
+void port_ultrasound_set_measurement_period_ms (uint32_t ultrasound_id, uint32_t period_ms);
+
+/**
+ * @brief Get the period of the timer that controls the new measurements.
+ * 
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
+ * @return uint32_t Period in ms.
+ */
+uint32_t port_ultrasound_get_measurement_period_ms (uint32_t ultrasound_id);
+
 /**
  * @brief Reset the time ticks of the echo signal.
  * 
@@ -121,6 +164,48 @@ void port_ultrasound_reset_echo_ticks (uint32_t ultrasound_id);
  */
 void port_ultrasound_stop_ultrasound (uint32_t ultrasound_id);
 
+/**
+ * @brief Abandon the echo signal that is being received.
+ * 
+ * This function resets the echo ticks without waiting for the end of the echo signal. The ultrasound sensor does not accept a new trigger signal until its echo signal ends, so the port indicates that a new measurement can be started (`trigger_ready`) as soon as the end of the abandoned echo signal is consumed (see `port_ultrasound_consume_echo_edges()`), without waiting for the timer of new measurements.
+ * 
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
+ */
+void port_ultrasound_abort_echo (uint32_t ultrasound_id);
+
+/**
+ * @brief Get the number of ticks per microsecond of the timer that controls the echo signal.
+ * 
+ * All the ticks of the echo signal (init, end and current ticks) are in this unit. It is fixed when the platform is built, so it can be read once at initialization.
+ * 
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
+ * @return uint32_t Ticks of the echo timer per microsecond (1 for a microsecond timebase).
+ */
+uint32_t port_ultrasound_get_echo_ticks_per_us (uint32_t ultrasound_id);
+
+/**
+ * @brief Get the current tick of the timer that controls the echo signal.
+ * 
+ * The echo timer is a free-running timebase shared by all the ultrasound sensors, so the value is in the same time base as the echo init and end ticks and the time elapsed since the start of the echo signal is `current_tick - echo_init_tick` (modulo 2^32).
+ * 
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
+ * @return uint32_t Current tick of the echo timer.
+ */
+uint32_t port_ultrasound_get_echo_current_tick (uint32_t ultrasound_id);
+
+/**
+ * @brief Consume the edges of the echo signal captured since the last call.
+ * 
+ * The edges of the echo signal are captured by hardware into a circular buffer of timestamps, without interrupting the CPU. This function pairs them: a rising edge sets the echo init tick and the next falling edge sets the echo end tick and the `echo_received` flag. Edges captured while the echo signal is not being listened to (see `port_ultrasound_stop_echo_timer()`) are discarded, and the falling edge of an abandoned echo signal makes the sensor ready for a new trigger (see `port_ultrasound_abort_echo()`).
+ * 
+ * It must be called often enough that the buffer does not overflow (a few edges per sensor).
+ * 
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
+ * @return true If the echo signal has been received (same as `port_ultrasound_get_echo_received()`).
+ * @return false Otherwise.
+ */
+bool port_ultrasound_consume_echo_edges (uint32_t ultrasound_id);
+
 /**
  * @brief Get the readiness of the trigger signal.
  * 
@@ -145,7 +230,7 @@ void port_ultrasound_set_trigger_ready (uint32_t ultrasound_id, bool trigger_rea
 /**
  * @brief Get the status of the trigger signal.
  * 
- * This function returns the status of the trigger signal. It will be `true` if the time to trigger the ultrasound sensor has finished.
+ * This function returns the status of the trigger signal. It will be `true` if the time to trigger the ultrasound sensor has finished. If the platform generates the trigger pulse in hardware, it is `true` as soon as the measurement starts, because the pulse ends by itself.
  * 
  * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
  * @return true 
@@ -166,6 +251,8 @@ void port_ultrasound_set_trigger_end (uint32_t ultrasound_id, bool trigger_end);
 /**
  * @brief Get the time tick when the init of echo signal was received.
  * 
+ * The echo ticks are absolute timestamps in us of the free-running echo timebase, so the duration of the echo signal is `echo_end_tick - echo_init_tick` (modulo 2^32). A value of 0 means that the edge has not been captured yet.
+ * 
  * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
  * @return uint32_t 
  */
@@ -221,24 +308,42 @@ bool port_ultrasound_get_echo_received (uint32_t ultrasound_id);
 void port_ultrasound_set_echo_received (uint32_t ultrasound_id, bool echo_received);
 
 /**
- * @brief Get the number of overflows of the echo signal timer.
+ * @brief Read the echo ticks and the echo received flag of an ultrasound sensor in one call.
  * 
- * This function returns the number of overflows of the echo signal timer. It is used to calculate the real time elapsed in the echo signal.
+ * The edges of the echo signal are copied by DMA and only turned into ticks by `port_ultrasound_consume_echo_edges()`, in the main loop, so no interrupt writes these values and no lock is needed.
  * 
  * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
- * @return uint32_t 
+ * @param p_echo Pointer to the structure where the snapshot is stored.
+ */
+void port_ultrasound_read_echo (uint32_t ultrasound_id, port_ultrasound_echo_t *p_echo);
+
+/**
+ * @brief Pop the oldest pending event of the interrupts of an ultrasound sensor.
+ * 
+ * The interrupts never write the flags `trigger_end` and `trigger_ready`: they push timestamped events to lock-free queues (see `port_event_queue.h`). The FSM pops the events one by one in its `fire` function and applies each one with the setter of its flag before checking the transitions, so two events between two calls are not merged into one.
+ * 
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
+ * @param p_event Pointer to the structure where the event is stored. Its type is one of `PORT_ULTRASOUND_EVENT`.
+ * @return true If an event has been popped.
+ * @return false If there are no pending events.
  */
-uint32_t port_ultrasound_get_echo_overflows (uint32_t ultrasound_id);
+bool port_ultrasound_pop_event (uint32_t ultrasound_id, port_event_t *p_event);
 
 /**
- * @brief Set the number of overflows of the echo signal timer.
+ * @brief Get the number of events pushed by the interrupts of an ultrasound sensor since its initialization.
  * 
- * This function sets the number of overflows of the echo signal timer. It is called by the ISR of the input capture of the echo signal when an overflow occurs to increment the number of overflows.
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
+ * @return uint32_t Number of events.
+ */
+uint32_t port_ultrasound_get_event_count (uint32_t ultrasound_id);
+
+/**
+ * @brief Get the number of events of an ultrasound sensor lost because its event queues were full.
  * 
  * @param ultrasound_id Ultrasound ID. This index is used to select the element of the `ultrasound_arr[]` array.
- * @param echo_overflows Number of overflows of the echo signal timer.
+ * @return uint32_t Number of events lost. It must be 0 unless the main loop stalls.
  */
-void port_ultrasound_set_echo_overflows (uint32_t ultrasound_id, uint32_t echo_overflows);
+uint32_t port_ultrasound_get_event_overflows (uint32_t ultrasound_id);
 
 
 #endif /* PORT_ULTRASOUND_H_ */
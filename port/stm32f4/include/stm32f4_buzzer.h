@@ -21,12 +21,24 @@
  * @brief Buzzer GPIO port
  * 
  */
-#define 	STM32F4_PARKING_BUZZER_GPIO GPIOA
+#define 	STM32F4_PARKING_BUZZER_GPIO GPIOB
  
 /**
  * @brief Buzzer GPIO pin
  * 
  */
-#define 	STM32F4_PARKING_BUZZER_PIN 0
+#define 	STM32F4_PARKING_BUZZER_PIN 14
+
+/**
+ * @brief Timer of the PWM of the buzzer (CH1 on AF9). **TIM5** is the second timebase of the echo signals (see `STM32F4_ULTRASOUND_MAX_SENSORS`).
+ * 
+ */
+#define 	STM32F4_PARKING_BUZZER_TIMER TIM12
+
+/**
+ * @brief Frequency in Hz of the timer of the buzzer after its configuration, before any sound is set.
+ *
+ */
+#define STM32F4_BUZZER_CONFIG_FREQ_HZ 4000
 
 #endif /* STM32F4_BUZZER_SYSTEM_H_ */
\ No newline at end of file
@@ -88,4 +88,36 @@
  */
 #define 	STM32F4_FRONT_PARKING_DISPLAY_RGB_B_PIN 1
 
+/**
+ * @brief DMA stream that plays the color sequences of the REAR display (TIM4_CH1 request).
+ * 
+ * TIM4_UP is on DMA1 Stream6, which is used by the echo of the REAR ultrasound, so the CH1 request of TIM4 is used instead. It is sent on the update event (CCDS bit of CR2).
+ * 
+ */
+#define 	STM32F4_REAR_PARKING_DISPLAY_DMA_STREAM DMA1_Stream0
+
+/**
+ * @brief DMA channel of the request of the color sequences of the REAR display.
+ * 
+ */
+#define 	STM32F4_REAR_PARKING_DISPLAY_DMA_CHANNEL 2
+
+/**
+ * @brief DMA stream that plays the color sequences of the FRONT display (TIM3_CH1 request).
+ * 
+ */
+#define 	STM32F4_FRONT_PARKING_DISPLAY_DMA_STREAM DMA1_Stream4
+
+/**
+ * @brief DMA channel of the request of the color sequences of the FRONT display.
+ * 
+ */
+#define 	STM32F4_FRONT_PARKING_DISPLAY_DMA_CHANNEL 5
+
+/**
+ * @brief Number of registers written by the DMA burst of each frame of a color sequence: from CCR1 (RED) to CCR4 (BLUE). CCR2 is not used by the display.
+ * 
+ */
+#define 	STM32F4_DISPLAY_BURST_LENGTH 4
+
 #endif /* STM32F4_DISPLAY_SYSTEM_H_ */
\ No newline at end of file
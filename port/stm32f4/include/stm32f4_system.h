@@ -43,6 +43,7 @@
 #define STM32F4_AF1 0x01U /*!< Alternate function 1 */
 #define STM32F4_AF2 0x02U /*!< Alternate function 2 */
 #define STM32F4_AF3 0x03U /*!< Alternate function 3 */
+#define STM32F4_AF9 0x09U /*!< Alternate function 9 */
 
 /** @verbatim
       ==============================================================================
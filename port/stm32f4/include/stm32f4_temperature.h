@@ -0,0 +1,62 @@
+/**
+ * @file stm32f4_temperature.h
+ * @brief Header for stm32f4_temperature.c file.
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+#ifndef STM32F4_TEMPERATURE_H_
+#define STM32F4_TEMPERATURE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* HW dependent includes */
+#include "stm32f4xx.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+/**
+ * @brief ADC that converts the internal temperature sensor. On the STM32F446 the sensor is only connected to **ADC1**.
+ * 
+ */
+#define STM32F4_TEMPERATURE_ADC ADC1
+
+/**
+ * @brief ADC channel of the internal temperature sensor.
+ * 
+ */
+#define STM32F4_TEMPERATURE_ADC_CHANNEL 18
+
+/**
+ * @brief Sampling time of the temperature sensor (`SMPx` = 111, 480 cycles). The sensor needs at least 10 us of sampling, i.e. 160 cycles at 16 MHz.
+ * 
+ */
+#define STM32F4_TEMPERATURE_SAMPLING_TIME 0x7U
+
+/**
+ * @brief Address of the factory calibration of the temperature sensor at `STM32F4_TEMPERATURE_CAL1_C`, measured with VDDA = 3.3 V.
+ * 
+ */
+#define STM32F4_TEMPERATURE_CAL1_ADDR ((const uint16_t *)0x1FFF7A2CU)
+
+/**
+ * @brief Address of the factory calibration of the temperature sensor at `STM32F4_TEMPERATURE_CAL2_C`, measured with VDDA = 3.3 V.
+ * 
+ */
+#define STM32F4_TEMPERATURE_CAL2_ADDR ((const uint16_t *)0x1FFF7A2EU)
+
+/**
+ * @brief Temperature in degrees Celsius of the first factory calibration point.
+ * 
+ */
+#define STM32F4_TEMPERATURE_CAL1_C 30
+
+/**
+ * @brief Temperature in degrees Celsius of the second factory calibration point.
+ * 
+ */
+#define STM32F4_TEMPERATURE_CAL2_C 110
+
+#endif /* STM32F4_TEMPERATURE_H_ */
@@ -66,6 +66,142 @@
  */
 #define STM32F4_FRONT_PARKING_SENSOR_ECHO_PIN 5
 
+/**
+ * @brief Maximum number of ultrasound transceivers supported by the port: 4 at the front and 4 at the rear.
+ * 
+ * The echo signals are captured by two 32-bit timebases with 4 channels each, **TIM2** and **TIM5** (the buzzer uses **TIM12**). The captures of TIM2 are copied by DMA1 on channel 3: CH1 on Stream5, CH2 on Stream6, CH3 on Stream1 and CH4 on Stream7. The captures of TIM5 are copied by DMA1 on channel 6: CH1 on Stream2 and CH4 on Stream3. TIM5 CH2 and CH3 only have requests on Stream4 and Stream0, which play the bursts of the displays, so their captures are copied by `stm32f4_ultrasound_capture_isr()` instead (`p_dma_stream` is NULL). Each sensor also needs its own trigger and period timers, and their interrupt handlers in `interr.c`.
+ * 
+ */
+#define STM32F4_ULTRASOUND_MAX_SENSORS 8
+
+/**
+ * @brief Timer that generates the trigger signal of the REAR ultrasound (CH1 on AF9 with the hardware trigger).
+ * 
+ */
+#define STM32F4_REAR_PARKING_SENSOR_TRIGGER_TIMER TIM13
+
+/**
+ * @brief Interrupt of the timer of the trigger signal of the REAR ultrasound.
+ * 
+ */
+#define STM32F4_REAR_PARKING_SENSOR_TRIGGER_IRQ TIM8_UP_TIM13_IRQn
+
+/**
+ * @brief Timer of new measurements of the REAR ultrasound.
+ * 
+ */
+#define STM32F4_REAR_PARKING_SENSOR_PERIOD_TIMER TIM10
+
+/**
+ * @brief Interrupt of the timer of new measurements of the REAR ultrasound.
+ * 
+ */
+#define STM32F4_REAR_PARKING_SENSOR_PERIOD_IRQ TIM1_UP_TIM10_IRQn
+
+/**
+ * @brief 32-bit timer that captures the echo signal of the REAR ultrasound.
+ * 
+ */
+#define STM32F4_REAR_PARKING_SENSOR_ECHO_TIMER TIM2
+
+/**
+ * @brief Input capture channel (1 to 4) of the echo signal of the REAR ultrasound.
+ * 
+ */
+#define STM32F4_REAR_PARKING_SENSOR_ECHO_CHANNEL 2
+
+/**
+ * @brief Timer that generates the trigger signal of the FRONT ultrasound (CH1 on AF9 with the hardware trigger).
+ * 
+ */
+#define STM32F4_FRONT_PARKING_SENSOR_TRIGGER_TIMER TIM14
+
+/**
+ * @brief Interrupt of the timer of the trigger signal of the FRONT ultrasound.
+ * 
+ */
+#define STM32F4_FRONT_PARKING_SENSOR_TRIGGER_IRQ TIM8_TRG_COM_TIM14_IRQn
+
+/**
+ * @brief Timer of new measurements of the FRONT ultrasound.
+ * 
+ */
+#define STM32F4_FRONT_PARKING_SENSOR_PERIOD_TIMER TIM6
+
+/**
+ * @brief Interrupt of the timer of new measurements of the FRONT ultrasound.
+ * 
+ */
+#define STM32F4_FRONT_PARKING_SENSOR_PERIOD_IRQ TIM6_DAC_IRQn
+
+/**
+ * @brief 32-bit timer that captures the echo signal of the FRONT ultrasound.
+ * 
+ */
+#define STM32F4_FRONT_PARKING_SENSOR_ECHO_TIMER TIM2
+
+/**
+ * @brief Input capture channel (1 to 4) of the echo signal of the FRONT ultrasound.
+ * 
+ */
+#define STM32F4_FRONT_PARKING_SENSOR_ECHO_CHANNEL 1
+
+/**
+ * @brief Counting frequency in Hz of the timers of new measurements (100 us per tick). It allows periods up to 6553 ms.
+ * 
+ */
+#define STM32F4_ULTRASOUND_MEASUREMENT_TICK_HZ 10000
+
+/**
+ * @brief Generate the trigger pulse in hardware (1) or in software (0).
+ * 
+ * With the hardware trigger, **TIM13** (REAR, PA6) and **TIM14** (FRONT, PA7) drive the trigger pins in output compare mode (AF9): the pulse is ended by the compare match after exactly `PORT_PARKING_SENSOR_TRIGGER_UP_US`, whatever the latency of the main loop, and no interrupt is needed. With the software trigger, the pin is raised by `port_ultrasound_start_measurement()` and lowered by the FSM after the interrupt of the trigger timer.
+ * 
+ */
+#ifndef STM32F4_ULTRASOUND_HW_TRIGGER
+#define STM32F4_ULTRASOUND_HW_TRIGGER 1
+#endif
+
+/**
+ * @brief Run the echo timebase at the full timer clock (1) or at 1 MHz (0).
+ * 
+ * At 1 MHz each tick of **TIM2** is 1 us, about 0.17 mm of distance. At the full timer clock (`SystemCoreClock`, 16 MHz with the HSI) each tick is 62.5 ns, about 0.01 mm, and the 32-bit timebase wraps around every 268 s instead of every 71 minutes, which is still far longer than any echo signal. The FSM reads the resolution with `port_ultrasound_get_echo_ticks_per_us()`.
+ * 
+ */
+#ifndef STM32F4_ULTRASOUND_HIGH_RES
+#define STM32F4_ULTRASOUND_HIGH_RES 0
+#endif
+
+/**
+ * @brief DMA stream that copies the captures of the echo signal of the REAR ultrasound (TIM2_CH2 request).
+ * 
+ */
+#define STM32F4_REAR_PARKING_SENSOR_ECHO_DMA_STREAM DMA1_Stream6
+
+/**
+ * @brief DMA channel of the request of the captures of the echo signal of the REAR ultrasound.
+ * 
+ */
+#define STM32F4_REAR_PARKING_SENSOR_ECHO_DMA_CHANNEL 3
+
+/**
+ * @brief DMA stream that copies the captures of the echo signal of the FRONT ultrasound (TIM2_CH1 request).
+ * 
+ */
+#define STM32F4_FRONT_PARKING_SENSOR_ECHO_DMA_STREAM DMA1_Stream5
+
+/**
+ * @brief DMA channel of the request of the captures of the echo signal of the FRONT ultrasound.
+ * 
+ */
+#define STM32F4_FRONT_PARKING_SENSOR_ECHO_DMA_CHANNEL 3
+
+/**
+ * @brief Number of edges of the echo signal that the DMA can store for each ultrasound before they are consumed. Must be a power of 2.
+ * 
+ */
+#define STM32F4_ULTRASOUND_EDGE_BUFFER_SIZE 8
+
 /* Function prototypes and explanation -------------------------------------------------*/
 /**
  * @brief Auxiliary function to change the GPIO and pin of the trigger pin of an ultrasound transceiver. This function is used for testing purposes mainly although it can be used in the final implementation if needed.
@@ -87,5 +223,34 @@ void stm32f4_ultrasound_set_new_trigger_gpio(uint32_t ultrasound_id, GPIO_TypeDe
  */
 void stm32f4_ultrasound_set_new_echo_gpio(uint32_t ultrasound_id, GPIO_TypeDef *p_port, uint8_t pin);
 
+/**
+ * @brief Read the current level of the echo pin of an ultrasound transceiver.
+ *
+ * The echo pin is in alternate function mode, but its level can still be read from the input data register. It is used to align the parity of the edges captured by the DMA (rising or falling) with the real level of the echo signal.
+ *
+ * @param ultrasound_id ID of the ultrasound transceiver.
+ * @return true If the echo signal is HIGH.
+ * @return false If the echo signal is LOW.
+ */
+bool stm32f4_ultrasound_get_echo_level(uint32_t ultrasound_id);
+
+/**
+ * @brief Handle the update interrupt of a timer of the ultrasound transceivers.
+ *
+ * The function looks for the transceivers that use the timer: if it is their timer of the trigger signal, the trigger signal has ended (`trigger_end`); if it is their timer of new measurements, a new measurement can be started (`trigger_ready`). It is called by the ISRs of the timers, so the ISRs do not depend on the number of transceivers.
+ *
+ * @param p_tim Timer that has interrupted.
+ */
+void stm32f4_ultrasound_timer_isr(TIM_TypeDef *p_tim);
+
+/**
+ * @brief Handle the capture interrupt of a timebase of the echo signals.
+ *
+ * The function copies the captures of the transceivers that use the timer and have no DMA stream to their circular buffer of edges, as the DMA does for the others. Reading the capture register clears its flag.
+ *
+ * @param p_tim Timer that has interrupted.
+ */
+void stm32f4_ultrasound_capture_isr(TIM_TypeDef *p_tim);
+
 
 #endif /* STM32F4_ULTRASOUND_H_ */
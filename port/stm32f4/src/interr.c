@@ -45,74 +45,16 @@ void EXTI15_10_IRQHandler(void)
     port_system_systick_resume();
     if (port_button_get_pending_interrupt(PORT_PARKING_BUTTON_ID))
     {
+        /* The status is applied from the main loop (see `port_button_pop_event()`) */
         if(port_button_get_value(PORT_PARKING_BUTTON_ID)) {
-            port_button_set_pressed(PORT_PARKING_BUTTON_ID, false);
+            port_button_push_event(PORT_PARKING_BUTTON_ID, false);
         } else {
-            port_button_set_pressed(PORT_PARKING_BUTTON_ID, true);
+            port_button_push_event(PORT_PARKING_BUTTON_ID, true);
         }
         port_button_clear_pending_interrupt(PORT_PARKING_BUTTON_ID);
     }
 }
 
-/**
- * @brief Interrupt service routine for the TIM2 timer.
- * 
- * This timer controls the duration of the measurements of the ultrasound sensor. When the interrupt occurs it means that the time of the a measurement has expired and a new measurement can be started.
- * 
- * **The timer can interrupt in two cases:**
- * 
- * 1. When the echo signal has not been received and the ARR register overflows. In this case, the echo_overflows counter is incremented.
- * 
- * 2. When the echo signal has been received. In this case, the echo_init_tick and echo_end_tick are updated.
- * 
- */
-void TIM2_IRQHandler(void)
-{
-    /* ISR ultrasound echo timer*/
-    port_system_systick_resume();
-    if (TIM2->SR & TIM_SR_UIF)
-    {
-        uint32_t overflows = port_ultrasound_get_echo_overflows(PORT_REAR_PARKING_SENSOR_ID);
-        overflows++;
-        port_ultrasound_set_echo_overflows(PORT_REAR_PARKING_SENSOR_ID, overflows);
-        overflows = port_ultrasound_get_echo_overflows(PORT_FRONT_PARKING_SENSOR_ID);
-        overflows++;
-        port_ultrasound_set_echo_overflows(PORT_FRONT_PARKING_SENSOR_ID, overflows);
-        TIM2->SR &= ~TIM_SR_UIF;
-    }
-    
-    if (TIM2->SR & TIM_SR_CC2IF)
-    {
-        uint32_t currentTicks = TIM2->CCR2;
-        uint32_t init = port_ultrasound_get_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID);
-        uint32_t end = port_ultrasound_get_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID);
-        if (init == 0 && end == 0)
-        {
-            port_ultrasound_set_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID, currentTicks);
-        } 
-        else
-        {
-            port_ultrasound_set_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID, currentTicks);
-            port_ultrasound_set_echo_received(PORT_REAR_PARKING_SENSOR_ID, true);
-        }
-    }
-    if (TIM2->SR & TIM_SR_CC1IF)
-    {
-        uint32_t currentTicks = TIM2->CCR1;
-        uint32_t init = port_ultrasound_get_echo_init_tick(PORT_FRONT_PARKING_SENSOR_ID);
-        uint32_t end = port_ultrasound_get_echo_end_tick(PORT_FRONT_PARKING_SENSOR_ID);
-        if (init == 0 && end == 0)
-        {
-            port_ultrasound_set_echo_init_tick(PORT_FRONT_PARKING_SENSOR_ID, currentTicks);
-        } 
-        else
-        {
-            port_ultrasound_set_echo_end_tick(PORT_FRONT_PARKING_SENSOR_ID, currentTicks);
-            port_ultrasound_set_echo_received(PORT_FRONT_PARKING_SENSOR_ID, true);
-        }
-    }
-}
-
 /**
  * @brief Interrupt service routine for the TIM10 timer.
  * 
@@ -122,8 +64,7 @@ void TIM2_IRQHandler(void)
 void TIM1_UP_TIM10_IRQHandler(void)
 {
     /* ISR ultrasound new measurement timer */
-    TIM10->SR &= ~TIM_SR_UIF;
-    port_ultrasound_set_trigger_ready(PORT_REAR_PARKING_SENSOR_ID, true); 
+    stm32f4_ultrasound_timer_isr(TIM10);
 }
 
 /**
@@ -135,32 +76,42 @@ void TIM1_UP_TIM10_IRQHandler(void)
 void TIM6_DAC_IRQHandler(void)
 {
     /* ISR ultrasound new measurement timer */
-    TIM6->SR &= ~TIM_SR_UIF;
-    port_ultrasound_set_trigger_ready(PORT_FRONT_PARKING_SENSOR_ID, true); 
+    stm32f4_ultrasound_timer_isr(TIM6);
 }
 
 /**
  * @brief Interrupt service routine for the TIM13 timer.
  * 
- * This timer controls the duration of the trigger signal of the REAR ultrasound sensor. When the interrupt occurs it means that the time of the trigger signal has expired and must be lowered.
+ * This timer controls the duration of the trigger signal of the REAR ultrasound sensor. When the interrupt occurs it means that the time of the trigger signal has expired and must be lowered. It only interrupts with the software trigger (see `STM32F4_ULTRASOUND_HW_TRIGGER`).
  * 
  */
 void TIM8_UP_TIM13_IRQHandler(void)
 {
 /* ISR ultrasound trigger timer */
-    TIM13->SR &= ~TIM_SR_UIF;
-    port_ultrasound_set_trigger_end(PORT_REAR_PARKING_SENSOR_ID, true);
+    stm32f4_ultrasound_timer_isr(TIM13);
 }
 
 /**
  * @brief Interrupt service routine for the TIM14 timer.
  * 
- * This timer controls the duration of the trigger signal of the FRONT ultrasound sensor. When the interrupt occurs it means that the time of the trigger signal has expired and must be lowered.
+ * This timer controls the duration of the trigger signal of the FRONT ultrasound sensor. When the interrupt occurs it means that the time of the trigger signal has expired and must be lowered. It only interrupts with the software trigger (see `STM32F4_ULTRASOUND_HW_TRIGGER`).
  * 
  */
 void TIM8_TRG_COM_TIM14_IRQHandler(void)
 {
-    TIM14->SR &= ~TIM_SR_UIF;
-    port_ultrasound_set_trigger_end(PORT_FRONT_PARKING_SENSOR_ID, true);
+/* ISR ultrasound trigger timer */
+    stm32f4_ultrasound_timer_isr(TIM14);
+}
+
+/**
+ * @brief Interrupt service routine for the TIM5 timer.
+ * 
+ * This timer is the second timebase of the echo signals of the ultrasound sensors. It only interrupts for the capture channels without a free DMA stream: the ISR copies their captures to the buffers of edges of their sensors.
+ * 
+ */
+void TIM5_IRQHandler(void)
+{
+    /* ISR ultrasound echo captures */
+    stm32f4_ultrasound_capture_isr(TIM5);
 }
 
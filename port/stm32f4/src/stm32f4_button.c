@@ -49,6 +49,12 @@ typedef struct
      * 
      */
     bool flag_pressed;
+
+    /**
+     * @brief Events pushed by the ISR of the button. The FSM pops them and applies them to `flag_pressed` one by one.
+     * 
+     */
+    port_event_queue_t events;
 } stm32f4_button_hw_t;
 
 /* Global variables ------------------------------------------------------------*/
@@ -90,6 +96,7 @@ void port_button_init(uint32_t button_id)
     // Retrieve the button struct using the private function and the button ID
     stm32f4_button_hw_t *p_button = _stm32f4_button_get(button_id);
     /* TO-DO alumnos */
+    port_event_queue_init(&p_button->events);
 
     stm32f4_system_gpio_config(p_button->p_port, p_button->pin, 0, p_button->pupd_mode);
 
@@ -139,4 +146,24 @@ void port_button_disable_interrupts (uint32_t button_id){
     stm32f4_button_hw_t *p_button = _stm32f4_button_get(button_id);
     uint8_t pin = p_button->pin;
     stm32f4_system_gpio_exti_disable(pin);
-}
\ No newline at end of file
+}
+
+void port_button_push_event (uint32_t button_id, bool pressed){
+    stm32f4_button_hw_t *p_button = _stm32f4_button_get(button_id);
+    port_event_queue_push(&p_button->events, pressed ? PORT_BUTTON_EVENT_PRESSED : PORT_BUTTON_EVENT_RELEASED, 0, port_system_get_millis());
+}
+
+bool port_button_pop_event (uint32_t button_id, port_event_t *p_event){
+    stm32f4_button_hw_t *p_button = _stm32f4_button_get(button_id);
+    return port_event_queue_pop(&p_button->events, p_event);
+}
+
+uint32_t port_button_get_event_count (uint32_t button_id){
+    stm32f4_button_hw_t *p_button = _stm32f4_button_get(button_id);
+    return port_event_queue_get_count(&p_button->events);
+}
+
+uint32_t port_button_get_event_overflows (uint32_t button_id){
+    stm32f4_button_hw_t *p_button = _stm32f4_button_get(button_id);
+    return port_event_queue_get_overflows(&p_button->events);
+}
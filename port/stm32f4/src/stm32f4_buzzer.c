@@ -8,11 +8,12 @@
 
 /* Standard C includes */
 #include <stdio.h>
-#include <math.h>
+#include <stdbool.h>
 
 /* HW dependent includes */
 #include "port_buzzer.h"
 #include "port_system.h"
+#include "port_timer_period.h"
 
 /* Microcontroller dependent includes */
 #include "stm32f4_system.h"
@@ -38,6 +39,18 @@ typedef struct
      */
     uint8_t pin_buzzer;
 
+    /**
+     * @brief Register values of the timer for each sound level, computed once in `port_buzzer_init()`.
+     *
+     */
+    port_timer_period_tone_t tones[PORT_BUZZER_MAX_VALUE + 1];
+
+    /**
+     * @brief Flag to indicate if the output compare and the counter of the timer have been enabled.
+     *
+     */
+    bool running;
+
 } stm32f4_buzzer_hw_t;
 
 /* Global variables */
@@ -88,38 +101,31 @@ stm32f4_buzzer_hw_t *_stm32f4_buzzer_get(uint32_t buzzer_id)
 void _timer_pwm_buzzer_config(uint32_t buzzer_id)
 {    
         /*Primero, habilitamos la fuente de reloj del temporizador.*/
-        RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
+        RCC->APB1ENR |= RCC_APB1ENR_TIM12EN;
         /*Segundo, inhabilitamos el contador y habilitamos el autoreload preload.*/
-        TIM5->CR1 &= ~TIM_CR1_CEN;
-        TIM5->CR1 |= TIM_CR1_ARPE;
+        STM32F4_PARKING_BUZZER_TIMER->CR1 &= ~TIM_CR1_CEN;
+        STM32F4_PARKING_BUZZER_TIMER->CR1 |= TIM_CR1_ARPE;
         /*Tercero, reseteamos el contador*/
-        TIM5->CNT = 0;
+        STM32F4_PARKING_BUZZER_TIMER->CNT = 0;
         /*Cuarto, calculamos ARR y PSC para una frecuencia de 4 kHz, que equivale a un periodo de 0,25 ms.*/
-        double reloj = (double)SystemCoreClock;
-        double periodo = 0.00025;
-        double arr = 65535.0;
-        double psc = round((periodo * reloj / (arr + 1.0)) - 1.0);
-        arr = round((periodo * reloj / (psc + 1.0)) - 1.0);
-        if (arr > 65535.0)
-        {
-            psc += 1.0;
-            arr = round((periodo * reloj / (psc + 1.0)) - 1.0);
-        }
-        TIM5->ARR = (uint32_t)arr;
-        TIM5->PSC = (uint32_t)psc;
+        uint32_t psc;
+        uint32_t arr;
+        port_timer_period_solve(SystemCoreClock, STM32F4_BUZZER_CONFIG_FREQ_HZ, &psc, &arr);
+        STM32F4_PARKING_BUZZER_TIMER->ARR = arr;
+        STM32F4_PARKING_BUZZER_TIMER->PSC = psc;
         /*Quinto, inhabilitamos la comparación de salida (output compare).*/
-        TIM5->CCER &= ~TIM_CCER_CC1E;
+        STM32F4_PARKING_BUZZER_TIMER->CCER &= ~TIM_CCER_CC1E;
         /*Sexto, limpiamos los bits P y NP del Output Compare Register.*/
-        TIM5->CCER &= ~TIM_CCER_CC1P;
-        TIM5->CCER &= ~TIM_CCER_CC1NP;
+        STM32F4_PARKING_BUZZER_TIMER->CCER &= ~TIM_CCER_CC1P;
+        STM32F4_PARKING_BUZZER_TIMER->CCER &= ~TIM_CCER_CC1NP;
         /*Septimo, activamos el modo PWM 1 (bits '110') y habilitamos el preload.*/
-        TIM5->CCMR1 |= TIM_CCMR1_OC1PE;
+        STM32F4_PARKING_BUZZER_TIMER->CCMR1 |= TIM_CCMR1_OC1PE;
         
-        TIM5->CCMR1 &= ~TIM_CCMR1_OC1M_0;
-        TIM5->CCMR1 |= TIM_CCMR1_OC1M_1;
-        TIM5->CCMR1 |= TIM_CCMR1_OC1M_2;
+        STM32F4_PARKING_BUZZER_TIMER->CCMR1 &= ~TIM_CCMR1_OC1M_0;
+        STM32F4_PARKING_BUZZER_TIMER->CCMR1 |= TIM_CCMR1_OC1M_1;
+        STM32F4_PARKING_BUZZER_TIMER->CCMR1 |= TIM_CCMR1_OC1M_2;
         /*Octavo, generamos un evento de actualizacion*/
-        TIM5->EGR |= TIM_EGR_UG;
+        STM32F4_PARKING_BUZZER_TIMER->EGR |= TIM_EGR_UG;
 
 }
 
@@ -128,50 +134,33 @@ void port_buzzer_init(uint32_t buzzer_id)
 {
     stm32f4_buzzer_hw_t *p_buzzer = _stm32f4_buzzer_get(buzzer_id);
     stm32f4_system_gpio_config(p_buzzer->p_port_buzzer, p_buzzer->pin_buzzer, STM32F4_GPIO_MODE_AF, STM32F4_GPIO_PUPDR_NOPULL);
-    stm32f4_system_gpio_config_alternate(p_buzzer->p_port_buzzer, p_buzzer->pin_buzzer, STM32F4_AF2);
+    stm32f4_system_gpio_config_alternate(p_buzzer->p_port_buzzer, p_buzzer->pin_buzzer, STM32F4_AF9);
     /*Finalmente*/
     _timer_pwm_buzzer_config(buzzer_id);
+    /*Por ultimo, calculamos una vez los registros del timer de cada nivel de sonido (ver port_timer_period.h)*/
+    port_timer_period_build_tones(SystemCoreClock, PORT_BUZZER_TONE_BASE_HZ, PORT_BUZZER_TONE_STEP_HZ, (PORT_BUZZER_MAX_VALUE + 1) / 2, p_buzzer->tones, PORT_BUZZER_MAX_VALUE + 1);
+    p_buzzer->running = false;
     port_buzzer_set_sound(buzzer_id, PORT_BUZZER_MIN_VALUE);
 }
 
 void port_buzzer_set_sound(uint32_t buzzer_id, uint8_t sound)
 {
-    if (buzzer_id == PORT_PARKING_BUZZER_ID)
+    stm32f4_buzzer_hw_t *p_buzzer = _stm32f4_buzzer_get(buzzer_id);
+    if (p_buzzer == NULL)
     {
-        TIM5->CR1 &= ~TIM_CR1_CEN;
-        if (sound == 0)
-        {
-            /*Inhabilitamos output compare.*/
-            TIM5->CCER &= ~TIM_CCER_CC1E;
-        }
-        else
-        {
-            /*Configuramos el duty cycle.*/
-            uint32_t pwm = (PORT_BUZZER_MAX_VALUE + 1) / 2;
-            TIM5->CCR1 = pwm;
-            /*Cambiamos el periodo para una frecuencia inversamente proporcional a la distancia desde 200 Hz a 2495 Hz*/
-            double reloj = (double)SystemCoreClock;
-            double periodo = 1/(200.0 + 9 * ((double) sound));
-            double arr = 65535.0;
-            double psc = round((periodo * reloj / (arr + 1.0)) - 1.0);
-            arr = round((periodo * reloj / (psc + 1.0)) - 1.0);
-            if (arr > 65535.0)
-            {
-                psc += 1.0;
-                arr = round((periodo * reloj / (psc + 1.0)) - 1.0);
-            }
-            TIM5->ARR = (uint32_t)arr;
-            TIM5->PSC = (uint32_t)psc;
-            /*Habilitamos output compare.*/
-            TIM5->CCER |= TIM_CCER_CC1E;
-        }
-        /*Finalmente, generamos un evento de actualizacion y habilitamos el contador.*/
-        TIM5->EGR |= TIM_EGR_UG;
-        TIM5->CR1 |= TIM_CR1_CEN;
         return;
     }
-    else
+    /*PSC, ARR y CCR1 tienen precarga: el nuevo tono empieza en el siguiente evento de actualizacion, sin cortar el periodo actual.*/
+    const port_timer_period_tone_t *p_tone = &p_buzzer->tones[sound];
+    STM32F4_PARKING_BUZZER_TIMER->PSC = p_tone->psc;
+    STM32F4_PARKING_BUZZER_TIMER->ARR = p_tone->arr;
+    STM32F4_PARKING_BUZZER_TIMER->CCR1 = p_tone->ccr;
+    if (!p_buzzer->running && (sound != 0))
     {
-        return;
+        /*Solo la primera vez, habilitamos output compare, generamos un evento de actualizacion y habilitamos el contador.*/
+        STM32F4_PARKING_BUZZER_TIMER->CCER |= TIM_CCER_CC1E;
+        STM32F4_PARKING_BUZZER_TIMER->EGR |= TIM_EGR_UG;
+        STM32F4_PARKING_BUZZER_TIMER->CR1 |= TIM_CR1_CEN;
+        p_buzzer->running = true;
     }
-}
\ No newline at end of file
+}
@@ -8,6 +8,8 @@
 
 /* Standard C includes */
 #include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
 #include <math.h>
 
 /* HW dependent includes */
@@ -61,6 +63,54 @@ typedef struct
      *
      */
     uint8_t pin_blue;
+
+    /**
+     * @brief Timer that generates the PWM of the three LEDs. Channel 1 is the RED LED, channel 3 the GREEN LED and channel 4 the BLUE LED.
+     *
+     */
+    TIM_TypeDef *p_timer;
+
+    /**
+     * @brief Compare value (CCRx) of each intensity level of a LED, from 0 to `PORT_DISPLAY_RGB_MAX_VALUE`. It is computed once from the ARR of the timer when the display is initialized.
+     *
+     */
+    uint32_t ccr_lut[PORT_DISPLAY_RGB_MAX_VALUE + 1];
+
+    /**
+     * @brief Color whose compare values are loaded in the CCRx registers.
+     *
+     */
+    rgb_color_t color;
+
+    /**
+     * @brief Flag to indicate whether the counter and the outputs of the timer are enabled. Once enabled, they are never stopped again.
+     *
+     */
+    bool running;
+
+    /**
+     * @brief DMA stream that writes each frame of a color sequence to the CCRx registers with a burst through the DMAR register of the timer.
+     *
+     */
+    DMA_Stream_TypeDef *p_dma_stream;
+
+    /**
+     * @brief DMA channel (request selection) of the CH1 request of the timer.
+     *
+     */
+    uint8_t dma_channel;
+
+    /**
+     * @brief Values of CCR1 to CCR4 of each frame of the color sequence being played, read by the DMA.
+     *
+     */
+    uint32_t burst_buf[PORT_DISPLAY_MAX_FRAMES * STM32F4_DISPLAY_BURST_LENGTH];
+
+    /**
+     * @brief Flag to indicate whether a color sequence has been started. The CCRx registers do not match `color` anymore.
+     *
+     */
+    bool playing;
 } stm32f4_display_hw_t;
 
 /* Global variables */
@@ -77,14 +127,20 @@ static stm32f4_display_hw_t displays_arr[] = {
         .p_port_green = STM32F4_REAR_PARKING_DISPLAY_RGB_G_GPIO,
         .pin_green = STM32F4_REAR_PARKING_DISPLAY_RGB_G_PIN,
         .p_port_blue = STM32F4_REAR_PARKING_DISPLAY_RGB_B_GPIO,
-        .pin_blue = STM32F4_REAR_PARKING_DISPLAY_RGB_B_PIN},
+        .pin_blue = STM32F4_REAR_PARKING_DISPLAY_RGB_B_PIN,
+        .p_timer = TIM4,
+        .p_dma_stream = STM32F4_REAR_PARKING_DISPLAY_DMA_STREAM,
+        .dma_channel = STM32F4_REAR_PARKING_DISPLAY_DMA_CHANNEL},
     [PORT_FRONT_PARKING_DISPLAY_ID] = {
         .p_port_red = STM32F4_FRONT_PARKING_DISPLAY_RGB_R_GPIO,
         .pin_red = STM32F4_FRONT_PARKING_DISPLAY_RGB_R_PIN,
         .p_port_green = STM32F4_FRONT_PARKING_DISPLAY_RGB_G_GPIO,
         .pin_green = STM32F4_FRONT_PARKING_DISPLAY_RGB_G_PIN,
         .p_port_blue = STM32F4_FRONT_PARKING_DISPLAY_RGB_B_GPIO,
-        .pin_blue = STM32F4_FRONT_PARKING_DISPLAY_RGB_B_PIN},
+        .pin_blue = STM32F4_FRONT_PARKING_DISPLAY_RGB_B_PIN,
+        .p_timer = TIM3,
+        .p_dma_stream = STM32F4_FRONT_PARKING_DISPLAY_DMA_STREAM,
+        .dma_channel = STM32F4_FRONT_PARKING_DISPLAY_DMA_CHANNEL},
 };
 
 /* Private functions -----------------------------------------------------------*/
@@ -109,6 +165,87 @@ stm32f4_display_hw_t *_stm32f4_display_get(uint32_t display_id)
     }
 }
 
+/**
+ * @brief Compute the compare value of each intensity level of the LEDs of a display.
+ *
+ * This function is called by the `port_display_init()` public function once the timer has been configured, so that `port_display_set_rgb()` does not need any division.
+ *
+ * @param p_display Pointer to the display HW struct.
+ */
+void _build_ccr_lut(stm32f4_display_hw_t *p_display)
+{
+    uint32_t period = p_display->p_timer->ARR + 1;
+    for (uint32_t level = 0; level <= PORT_DISPLAY_RGB_MAX_VALUE; level++)
+    {
+        p_display->ccr_lut[level] = period * level / PORT_DISPLAY_RGB_MAX_VALUE;
+    }
+}
+
+/**
+ * @brief Enable the outputs and the counter of the timer of a display, if they are not enabled yet.
+ *
+ * The CCRx registers are loaded with an update event before the counter starts, so the first period already has the right duty cycle. Once enabled, the counter is never stopped again.
+ *
+ * @param p_display Pointer to the display HW struct.
+ */
+void _start_timer(stm32f4_display_hw_t *p_display)
+{
+    if (!p_display->running)
+    {
+        TIM_TypeDef *p_timer = p_display->p_timer;
+        p_timer->CCER |= TIM_CCER_CC1E | TIM_CCER_CC3E | TIM_CCER_CC4E;
+        p_timer->EGR |= TIM_EGR_UG;
+        p_timer->CR1 |= TIM_CR1_CEN;
+        p_display->running = true;
+    }
+}
+
+/**
+ * @brief Configure the DMA burst that plays the color sequences of a display.
+ *
+ * Each update event of the timer sends the CH1 DMA request of the timer (**DMA1** Stream0 channel 2 for REAR and Stream4 channel 5 for FRONT). The DMA then writes one frame of `burst_buf` to the DMAR register, and the timer spreads it over CCR1 to CCR4. The new duty cycles are preloaded, so they are applied at the next update event. The stream is enabled by `port_display_play()`.
+ *
+ * @param p_display Pointer to the display HW struct.
+ */
+void _dma_burst_setup(stm32f4_display_hw_t *p_display)
+{
+    TIM_TypeDef *p_timer = p_display->p_timer;
+    DMA_Stream_TypeDef *p_stream = p_display->p_dma_stream;
+
+    /*Primero, habilitamos el reloj del DMA*/
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+    /*Segundo, deshabilitamos el stream y esperamos a que se pare*/
+    p_stream->CR &= ~DMA_SxCR_EN;
+    while (p_stream->CR & DMA_SxCR_EN)
+    {
+    }
+    /*Tercero, destino en el registro DMAR del temporizador*/
+    p_stream->PAR = (uint32_t)&p_timer->DMAR;
+    /*Cuarto, canal de la peticion, de memoria a periferico, palabras de 32 bits e incremento en memoria*/
+    p_stream->CR = ((uint32_t)p_display->dma_channel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_DIR_0 | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC;
+    /*Quinto, modo directo: sin FIFO*/
+    p_stream->FCR = 0;
+    /*Sexto, cada rafaga escribe de CCR1 a CCR4*/
+    p_timer->DCR = ((STM32F4_DISPLAY_BURST_LENGTH - 1) << TIM_DCR_DBL_Pos) | ((offsetof(TIM_TypeDef, CCR1) / sizeof(uint32_t)) << TIM_DCR_DBA_Pos);
+    /*Septimo, la peticion de DMA del canal 1 se envia en el evento de actualizacion*/
+    p_timer->CR2 |= TIM_CR2_CCDS;
+}
+
+/**
+ * @brief Stop the color sequence being played on a display, if any. The CCRx registers keep the last frame written.
+ *
+ * @param p_display Pointer to the display HW struct.
+ */
+void _stop_sequence(stm32f4_display_hw_t *p_display)
+{
+    DMA_Stream_TypeDef *p_stream = p_display->p_dma_stream;
+    p_display->p_timer->DIER &= ~TIM_DIER_CC1DE;
+    p_stream->CR &= ~DMA_SxCR_EN;
+    while (p_stream->CR & DMA_SxCR_EN)
+    {
+    }
+}
+
 /**
  * @brief Configure the timer that controls the PWM of **each one** of the RGB LEDs of the display system.
  *
@@ -238,134 +375,124 @@ void port_display_init(uint32_t display_id)
     stm32f4_system_gpio_config_alternate(p_display->p_port_blue, p_display->pin_blue, STM32F4_AF2);
     /*Finalmente*/
     _timer_pwm_config(display_id);
+    _build_ccr_lut(p_display);
+    _dma_burst_setup(p_display);
+    p_display->running = false;
+    p_display->playing = false;
+    p_display->color = COLOR_OFF;
     port_display_set_rgb(display_id, COLOR_OFF);
 }
 
 void port_display_set_rgb(uint32_t display_id, rgb_color_t color)
 {
-    uint8_t r = color.r;
-    uint8_t g = color.g;
-    uint8_t b = color.b;
-    if (display_id == PORT_REAR_PARKING_DISPLAY_ID)
+    stm32f4_display_hw_t *p_display = _stm32f4_display_get(display_id);
+    if (p_display == NULL)
     {
-        TIM4->CR1 &= ~TIM_CR1_CEN;
-        if (r == 0 && g == 0 && b == 0)
-        {
-            TIM4->CCER &= ~TIM_CCER_CC1E;
-            TIM4->CCER &= ~TIM_CCER_CC3E;
-            TIM4->CCER &= ~TIM_CCER_CC4E;
-            return;
-        }
-        else
-        {
-            if (r == 0)
-            {
-                /*Inhabilitamos output compare solo para el rojo.*/
-                TIM4->CCER &= ~TIM_CCER_CC1E;
-            }
-            else
-            {
-                /*Configuramos el duty cycle para el rojo.*/
-                uint32_t pwm = (TIM4->ARR + 1) * r / PORT_DISPLAY_RGB_MAX_VALUE;
-                TIM4->CCR1 = pwm;
-                /*Habilitamos output compare solo para el rojo.*/
-                TIM4->CCER |= TIM_CCER_CC1E;
-            }
-
-            if (g == 0)
-            {
-                /*Inhabilitamos output compare solo para el verde.*/
-                TIM4->CCER &= ~TIM_CCER_CC3E;
-            }
-            else
-            {
-                /*Configuramos el duty cycle para el verde.*/
-                uint32_t pwm = (TIM4->ARR + 1) * g / PORT_DISPLAY_RGB_MAX_VALUE;
-                TIM4->CCR3 = pwm;
-                /*Habilitamos output compare solo para el verde.*/
-                TIM4->CCER |= TIM_CCER_CC3E;
-            }
-
-            if (b == 0)
-            {
-                /*Inhabilitamos output compare solo para el azul.*/
-                TIM4->CCER &= ~TIM_CCER_CC4E;
-            }
-            else
-            {
-                /*Configuramos el duty cycle para el azul.*/
-                uint32_t pwm = (TIM4->ARR + 1) * b / PORT_DISPLAY_RGB_MAX_VALUE;
-                TIM4->CCR4 = pwm;
-                /*Habilitamos output compare solo para el azul.*/
-                TIM4->CCER |= TIM_CCER_CC4E;
-            }
-            /*Finalmente, generamos un evento de actualizacion y habilitamos el contador.*/
-            TIM4->EGR |= TIM_EGR_UG;
-            TIM4->CR1 |= TIM_CR1_CEN;
-            return;
-        }
+        return;
     }
-    if (display_id == PORT_FRONT_PARKING_DISPLAY_ID)
+    TIM_TypeDef *p_timer = p_display->p_timer;
+    /*Primero, paramos la secuencia que se este reproduciendo: los CCRx ya no coinciden con el ultimo color y hay que escribirlos todos.*/
+    bool write_all = p_display->playing;
+    if (write_all)
     {
-        TIM3->CR1 &= ~TIM_CR1_CEN;
-        if (r == 0 && g == 0 && b == 0)
-        {
-            TIM3->CCER &= ~TIM_CCER_CC1E;
-            TIM3->CCER &= ~TIM_CCER_CC3E;
-            TIM3->CCER &= ~TIM_CCER_CC4E;
-            return;
-        }
-        else
-        {
-            if (r == 0)
-            {
-                /*Inhabilitamos output compare solo para el rojo.*/
-                TIM3->CCER &= ~TIM_CCER_CC1E;
-            }
-            else
-            {
-                /*Configuramos el duty cycle para el rojo.*/
-                uint32_t pwm = (TIM3->ARR + 1) * r / PORT_DISPLAY_RGB_MAX_VALUE;
-                TIM3->CCR1 = pwm;
-                /*Habilitamos output compare solo para el rojo.*/
-                TIM3->CCER |= TIM_CCER_CC1E;
-            }
-
-            if (g == 0)
-            {
-                /*Inhabilitamos output compare solo para el verde.*/
-                TIM3->CCER &= ~TIM_CCER_CC3E;
-            }
-            else
-            {
-                /*Configuramos el duty cycle para el verde.*/
-                uint32_t pwm = (TIM3->ARR + 1) * g / PORT_DISPLAY_RGB_MAX_VALUE;
-                TIM3->CCR3 = pwm;
-                /*Habilitamos output compare solo para el verde.*/
-                TIM3->CCER |= TIM_CCER_CC3E;
-            }
-
-            if (b == 0)
-            {
-                /*Inhabilitamos output compare solo para el azul.*/
-                TIM3->CCER &= ~TIM_CCER_CC4E;
-            }
-            else
-            {
-                /*Configuramos el duty cycle para el azul.*/
-                uint32_t pwm = (TIM3->ARR + 1) * b / PORT_DISPLAY_RGB_MAX_VALUE;
-                TIM3->CCR4 = pwm;
-                /*Habilitamos output compare solo para el azul.*/
-                TIM3->CCER |= TIM_CCER_CC4E;
-            }
-            /*Finalmente, generamos un evento de actualizacion y habilitamos el contador.*/
-            TIM3->EGR |= TIM_EGR_UG;
-            TIM3->CR1 |= TIM_CR1_CEN;
-            return;
-        }
+        _stop_sequence(p_display);
+        p_display->playing = false;
     }
-    else
+    /*Segundo, escribimos solo los CCRx que cambian. Con el preload (OCxPE) activo, el nuevo duty cycle se aplica en el siguiente evento de actualizacion, sin cortar el periodo en curso. Un nivel 0 da CCRx = 0, que en modo PWM 1 mantiene la salida a nivel bajo.*/
+    if (write_all || color.r != p_display->color.r)
+    {
+        p_timer->CCR1 = p_display->ccr_lut[color.r];
+    }
+    if (write_all || color.g != p_display->color.g)
+    {
+        p_timer->CCR3 = p_display->ccr_lut[color.g];
+    }
+    if (write_all || color.b != p_display->color.b)
+    {
+        p_timer->CCR4 = p_display->ccr_lut[color.b];
+    }
+    p_display->color = color;
+
+    /*Tercero, la primera vez que se enciende un LED, habilitamos las salidas y arrancamos el contador.*/
+    if (color.r != 0 || color.g != 0 || color.b != 0)
+    {
+        _start_timer(p_display);
+    }
+}
+
+rgb_color_t port_display_get_rgb(uint32_t display_id)
+{
+    stm32f4_display_hw_t *p_display = _stm32f4_display_get(display_id);
+    if (p_display == NULL)
+    {
+        return COLOR_OFF;
+    }
+    if (!p_display->playing)
+    {
+        return p_display->color;
+    }
+    /*Durante una secuencia, convertimos los CCRx del frame actual en niveles, redondeando*/
+    TIM_TypeDef *p_timer = p_display->p_timer;
+    uint32_t period = p_timer->ARR + 1;
+    uint32_t r = (p_timer->CCR1 * PORT_DISPLAY_RGB_MAX_VALUE + period / 2) / period;
+    uint32_t g = (p_timer->CCR3 * PORT_DISPLAY_RGB_MAX_VALUE + period / 2) / period;
+    uint32_t b = (p_timer->CCR4 * PORT_DISPLAY_RGB_MAX_VALUE + period / 2) / period;
+    return (rgb_color_t){(r > PORT_DISPLAY_RGB_MAX_VALUE) ? PORT_DISPLAY_RGB_MAX_VALUE : r,
+                         (g > PORT_DISPLAY_RGB_MAX_VALUE) ? PORT_DISPLAY_RGB_MAX_VALUE : g,
+                         (b > PORT_DISPLAY_RGB_MAX_VALUE) ? PORT_DISPLAY_RGB_MAX_VALUE : b};
+}
+
+void port_display_play(uint32_t display_id, const rgb_color_t *p_frames, uint32_t num_frames, bool loop)
+{
+    stm32f4_display_hw_t *p_display = _stm32f4_display_get(display_id);
+    if ((p_display == NULL) || (num_frames == 0))
     {
         return;
     }
-}
\ No newline at end of file
+    if (num_frames > PORT_DISPLAY_MAX_FRAMES)
+    {
+        num_frames = PORT_DISPLAY_MAX_FRAMES;
+    }
+    DMA_Stream_TypeDef *p_stream = p_display->p_dma_stream;
+    uint32_t stream = (((uint32_t)p_stream & 0xFFU) - 0x10U) / 0x18U;
+    static const uint8_t flags_shift[4] = {0, 6, 16, 22};
+
+    /*Primero, paramos la secuencia anterior antes de tocar el buffer*/
+    _stop_sequence(p_display);
+    /*Segundo, convertimos cada frame en los valores de CCR1 a CCR4 de la rafaga*/
+    for (uint32_t i = 0; i < num_frames; i++)
+    {
+        uint32_t *p_burst = &p_display->burst_buf[i * STM32F4_DISPLAY_BURST_LENGTH];
+        p_burst[0] = p_display->ccr_lut[p_frames[i].r];
+        p_burst[1] = 0;
+        p_burst[2] = p_display->ccr_lut[p_frames[i].g];
+        p_burst[3] = p_display->ccr_lut[p_frames[i].b];
+    }
+    /*Tercero, limpiamos los flags del stream antes de habilitarlo*/
+    if (stream < 4)
+    {
+        DMA1->LIFCR = 0x3DU << flags_shift[stream];
+    }
+    else
+    {
+        DMA1->HIFCR = 0x3DU << flags_shift[stream - 4];
+    }
+    /*Cuarto, origen en el buffer de rafagas. En modo circular la secuencia se repite sin fin; si no, el stream se para tras el ultimo frame y los CCRx se quedan con el*/
+    p_stream->M0AR = (uint32_t)p_display->burst_buf;
+    p_stream->NDTR = num_frames * STM32F4_DISPLAY_BURST_LENGTH;
+    if (loop)
+    {
+        p_stream->CR |= DMA_SxCR_CIRC;
+    }
+    else
+    {
+        p_stream->CR &= ~DMA_SxCR_CIRC;
+    }
+    p_stream->CR |= DMA_SxCR_EN;
+    p_display->playing = true;
+    p_display->color = p_frames[num_frames - 1];
+
+    /*Quinto, arrancamos el temporizador si hace falta y habilitamos la peticion de DMA: el primer frame se escribe en el siguiente evento de actualizacion*/
+    _start_timer(p_display);
+    p_display->p_timer->DIER |= TIM_DIER_CC1DE;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file stm32f4_temperature.c
+ * @brief Portable functions to read the internal temperature sensor of the STM32F4.
+ *
+ * The sensor measures the temperature of the die, which is a few degrees above the temperature of the air when the MCU works. It is good enough to compensate the speed of sound; a more precise external sensor can be injected with `fsm_ultrasound_set_temperature()` instead.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* HW dependent includes */
+#include "port_temperature.h"
+#include "port_system.h"
+
+/* Microcontroller dependent includes */
+#include "stm32f4_temperature.h"
+
+/* Public functions -----------------------------------------------------------*/
+void port_temperature_init(void)
+{
+    ADC_TypeDef *p_adc = STM32F4_TEMPERATURE_ADC;
+    uint32_t channel = STM32F4_TEMPERATURE_ADC_CHANNEL;
+
+    /*Primero, habilitamos el reloj del ADC y el sensor de temperatura (TSVREFE)*/
+    RCC->APB2ENR |= RCC_APB2ENR_ADC1EN;
+    ADC->CCR |= ADC_CCR_TSVREFE;
+    /*Segundo, resolucion de 12 bits, alineado a la derecha y conversion continua de un solo canal, sin interrupciones*/
+    p_adc->CR1 = 0;
+    p_adc->CR2 = ADC_CR2_CONT;
+    /*Tercero, configuramos el tiempo de muestreo del canal (los canales 10 a 18 estan en SMPR1)*/
+    p_adc->SMPR1 &= ~(0x7U << ((channel - 10) * 3));
+    p_adc->SMPR1 |= STM32F4_TEMPERATURE_SAMPLING_TIME << ((channel - 10) * 3);
+    /*Cuarto, una secuencia regular de una sola conversion: el canal del sensor*/
+    p_adc->SQR1 = 0;
+    p_adc->SQR3 = channel;
+    /*Quinto, encendemos el ADC y esperamos a que se estabilice (tSTAB, unos pocos us)*/
+    p_adc->CR2 |= ADC_CR2_ADON;
+    port_system_delay_ms(1);
+    /*Sexto, arrancamos las conversiones, que ya no se paran nunca*/
+    p_adc->CR2 |= ADC_CR2_SWSTART;
+}
+
+int32_t port_temperature_get_celsius(void)
+{
+    /* The data register always holds the last conversion: there is nothing to wait for */
+    int32_t raw = (int32_t)(STM32F4_TEMPERATURE_ADC->DR & 0xFFFU);
+    int32_t cal1 = (int32_t)*STM32F4_TEMPERATURE_CAL1_ADDR;
+    int32_t cal2 = (int32_t)*STM32F4_TEMPERATURE_CAL2_ADDR;
+    // Line through the two factory calibration points
+    return STM32F4_TEMPERATURE_CAL1_C + (raw - cal1) * (STM32F4_TEMPERATURE_CAL2_C - STM32F4_TEMPERATURE_CAL1_C) / (cal2 - cal1);
+}
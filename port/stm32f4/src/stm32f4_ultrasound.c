@@ -13,6 +13,7 @@
 /* HW dependent includes */
 #include "port_ultrasound.h"
 #include "port_system.h"
+#include "port_event_queue.h"
 
 /* Microcontroller dependent includes */
 #include "stm32f4_system.h"
@@ -55,6 +56,60 @@ typedef struct
      */
     uint8_t echo_alt_fun;
 
+    /**
+     * @brief Alternate function for the trigger signal, if it is generated in hardware (see `STM32F4_ULTRASOUND_HW_TRIGGER`).
+     * 
+     */
+    uint8_t trigger_alt_fun;
+
+    /**
+     * @brief Timer that controls the duration of the trigger signal. With the hardware trigger, its channel 1 drives the trigger pin.
+     * 
+     */
+    TIM_TypeDef *p_trigger_timer;
+
+    /**
+     * @brief Interrupt of the timer of the trigger signal.
+     * 
+     */
+    IRQn_Type trigger_irqn;
+
+    /**
+     * @brief Timer that controls the period of new measurements.
+     * 
+     */
+    TIM_TypeDef *p_period_timer;
+
+    /**
+     * @brief Interrupt of the timer of new measurements.
+     * 
+     */
+    IRQn_Type period_irqn;
+
+    /**
+     * @brief 32-bit timer that captures the echo signal (**TIM2** or **TIM5**). It is a free-running timebase that can be shared by up to 4 sensors, one per channel.
+     * 
+     */
+    TIM_TypeDef *p_echo_timer;
+
+    /**
+     * @brief Input capture channel (1 to 4) of `p_echo_timer` of the echo signal.
+     * 
+     */
+    uint8_t echo_channel;
+
+    /**
+     * @brief DMA channel (request selection) of the captures of `echo_channel`.
+     * 
+     */
+    uint8_t dma_channel;
+
+    /**
+     * @brief Interrupt of `p_echo_timer`. It is only used if the captures are copied by `stm32f4_ultrasound_capture_isr()`.
+     * 
+     */
+    IRQn_Type echo_irqn;
+
     /**
      * @brief Flag to indicate that a new measurement can be started.
      * 
@@ -67,6 +122,20 @@ typedef struct
      */
     bool trigger_end;
 
+    /**
+     * @brief Events pushed by the ISR of `p_trigger_timer`. The FSM pops them and applies them to `trigger_end` one by one.
+     * 
+     * Each timer has its own queue because the two ISRs have different priorities: a queue only admits one producer.
+     * 
+     */
+    port_event_queue_t trigger_events;
+
+    /**
+     * @brief Events pushed by the ISR of `p_period_timer`. The FSM pops them and applies them to `trigger_ready` one by one.
+     * 
+     */
+    port_event_queue_t period_events;
+
     /**
      * @brief Flag to indicate that the echo signal has been received.
      * 
@@ -86,10 +155,52 @@ typedef struct
     uint32_t echo_end_tick;
 
     /**
-     * @brief Number of overflows of the timer during the echo signal.
+     * @brief Flag to indicate that the echo signal has been abandoned before its end. The next trigger is ready when the echo signal ends.
+     * 
+     */
+    bool echo_aborted;
+
+    /**
+     * @brief Flag to indicate that the edges of the echo signal are stored as the echo ticks of a measurement.
+     * 
+     */
+    bool echo_listening;
+
+    /**
+     * @brief Level of the echo signal after the last consumed edge. Both edges are captured, so each edge toggles it.
+     * 
+     */
+    bool echo_level;
+
+    /**
+     * @brief DMA stream that copies the captures of the echo signal to `edge_buf`, or NULL if they are copied by the ISR of `p_echo_timer` (see `stm32f4_ultrasound_capture_isr()`).
+     * 
+     */
+    DMA_Stream_TypeDef *p_dma_stream;
+
+    /**
+     * @brief Circular buffer of ticks of the edges of the echo signal, written by the DMA.
+     * 
+     */
+    volatile uint32_t edge_buf[STM32F4_ULTRASOUND_EDGE_BUFFER_SIZE];
+
+    /**
+     * @brief Index of the next edge of `edge_buf` to write, if the captures are copied by the ISR of `p_echo_timer`. With a DMA stream it is given by its `NDTR` register.
+     * 
+     */
+    volatile uint32_t edge_write_idx;
+
+    /**
+     * @brief Index of the next edge of `edge_buf` to consume.
+     * 
+     */
+    uint32_t edge_read_idx;
+
+    /**
+     * @brief Current period in ms of the timer of new measurements.
      * 
      */
-    uint32_t echo_overflows;
+    uint32_t measurement_period_ms;
 }  stm32f4_ultrasound_hw_t;
 
 /* Global variables */
@@ -98,22 +209,46 @@ typedef struct
  * 
  * This must be hidden from the user, so it is declared as static. To access the elements of this array, use the function `_stm32f4_ultrasound_get()`.
  * 
+ * Each element describes all the resources of a sensor (pins, timers, capture channel and DMA stream), so the rest of the driver does not depend on the number of sensors. Up to `STM32F4_ULTRASOUND_MAX_SENSORS` sensors can be added, one for each capture channel of the two echo timebases.
+ * 
  */
 static stm32f4_ultrasound_hw_t ultrasound_arr[] = {
     [PORT_REAR_PARKING_SENSOR_ID] = {
         .p_trigger_port = STM32F4_REAR_PARKING_SENSOR_TRIGGER_GPIO,
         .p_echo_port = STM32F4_REAR_PARKING_SENSOR_ECHO_GPIO,
         .trigger_pin = STM32F4_REAR_PARKING_SENSOR_TRIGGER_PIN,
-        .echo_pin = STM32F4_REAR_PARKING_SENSOR_ECHO_PIN
+        .echo_pin = STM32F4_REAR_PARKING_SENSOR_ECHO_PIN,
+        .echo_alt_fun = STM32F4_AF1,
+        .trigger_alt_fun = STM32F4_AF9,
+        .p_trigger_timer = STM32F4_REAR_PARKING_SENSOR_TRIGGER_TIMER,
+        .trigger_irqn = STM32F4_REAR_PARKING_SENSOR_TRIGGER_IRQ,
+        .p_period_timer = STM32F4_REAR_PARKING_SENSOR_PERIOD_TIMER,
+        .period_irqn = STM32F4_REAR_PARKING_SENSOR_PERIOD_IRQ,
+        .p_echo_timer = STM32F4_REAR_PARKING_SENSOR_ECHO_TIMER,
+        .echo_channel = STM32F4_REAR_PARKING_SENSOR_ECHO_CHANNEL,
+        .p_dma_stream = STM32F4_REAR_PARKING_SENSOR_ECHO_DMA_STREAM,
+        .dma_channel = STM32F4_REAR_PARKING_SENSOR_ECHO_DMA_CHANNEL
     },
     [PORT_FRONT_PARKING_SENSOR_ID] = {
         .p_trigger_port = STM32F4_FRONT_PARKING_SENSOR_TRIGGER_GPIO,
         .p_echo_port = STM32F4_FRONT_PARKING_SENSOR_ECHO_GPIO,
         .trigger_pin = STM32F4_FRONT_PARKING_SENSOR_TRIGGER_PIN,
-        .echo_pin = STM32F4_FRONT_PARKING_SENSOR_ECHO_PIN
+        .echo_pin = STM32F4_FRONT_PARKING_SENSOR_ECHO_PIN,
+        .echo_alt_fun = STM32F4_AF1,
+        .trigger_alt_fun = STM32F4_AF9,
+        .p_trigger_timer = STM32F4_FRONT_PARKING_SENSOR_TRIGGER_TIMER,
+        .trigger_irqn = STM32F4_FRONT_PARKING_SENSOR_TRIGGER_IRQ,
+        .p_period_timer = STM32F4_FRONT_PARKING_SENSOR_PERIOD_TIMER,
+        .period_irqn = STM32F4_FRONT_PARKING_SENSOR_PERIOD_IRQ,
+        .p_echo_timer = STM32F4_FRONT_PARKING_SENSOR_ECHO_TIMER,
+        .echo_channel = STM32F4_FRONT_PARKING_SENSOR_ECHO_CHANNEL,
+        .p_dma_stream = STM32F4_FRONT_PARKING_SENSOR_ECHO_DMA_STREAM,
+        .dma_channel = STM32F4_FRONT_PARKING_SENSOR_ECHO_DMA_CHANNEL
     },
 };
 
+_Static_assert(sizeof(ultrasound_arr) / sizeof(ultrasound_arr[0]) <= STM32F4_ULTRASOUND_MAX_SENSORS, "There are more ultrasounds than capture channels in the echo timebases");
+
 /* Private functions ----------------------------------------------------------*/
 /**
  * @brief Get the ultrasound status struct with the given ID.
@@ -136,30 +271,70 @@ stm32f4_ultrasound_hw_t *_stm32f4_ultrasound_get (uint32_t ultrasound_id)
     }
 }
 
+/**
+ * @brief Get the index of the next edge that will be written in the circular buffer of an ultrasound sensor.
+ *
+ * @param p_ultrasound Pointer to the HW description of the ultrasound sensor.
+ * @return uint32_t Index of `edge_buf`.
+ */
+static uint32_t _edge_write_idx(stm32f4_ultrasound_hw_t *p_ultrasound)
+{
+    if (p_ultrasound->p_dma_stream == NULL)
+    {
+        return p_ultrasound->edge_write_idx;
+    }
+    /* NDTR counts the transfers left until the DMA wraps around to the start of the buffer */
+    return (STM32F4_ULTRASOUND_EDGE_BUFFER_SIZE - p_ultrasound->p_dma_stream->NDTR) % STM32F4_ULTRASOUND_EDGE_BUFFER_SIZE;
+}
+
+/**
+ * @brief Enable the clock of a timer.
+ *
+ * @param p_tim Timer.
+ */
+static void _timer_enable_clock(TIM_TypeDef *p_tim)
+{
+    if (p_tim == TIM1) RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;
+    if (p_tim == TIM2) RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+    if (p_tim == TIM3) RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
+    if (p_tim == TIM4) RCC->APB1ENR |= RCC_APB1ENR_TIM4EN;
+    if (p_tim == TIM5) RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
+    if (p_tim == TIM6) RCC->APB1ENR |= RCC_APB1ENR_TIM6EN;
+    if (p_tim == TIM7) RCC->APB1ENR |= RCC_APB1ENR_TIM7EN;
+    if (p_tim == TIM8) RCC->APB2ENR |= RCC_APB2ENR_TIM8EN;
+    if (p_tim == TIM9) RCC->APB2ENR |= RCC_APB2ENR_TIM9EN;
+    if (p_tim == TIM10) RCC->APB2ENR |= RCC_APB2ENR_TIM10EN;
+    if (p_tim == TIM11) RCC->APB2ENR |= RCC_APB2ENR_TIM11EN;
+    if (p_tim == TIM12) RCC->APB1ENR |= RCC_APB1ENR_TIM12EN;
+    if (p_tim == TIM13) RCC->APB1ENR |= RCC_APB1ENR_TIM13EN;
+    if (p_tim == TIM14) RCC->APB1ENR |= RCC_APB1ENR_TIM14EN;
+}
+
+#if !STM32F4_ULTRASOUND_HW_TRIGGER
 /**
  * @brief Configure the timer that controls the duration of the trigger signal.
- * 
- * This function configures the timers **TIM13** (REAR) and **TIM14** (FRONT) to generate internal interrupts to control the raise and fall of the trigger signal. The duration of the trigger signal is defined in the `PORT_PARKING_SENSOR_TRIGGER_UP_US` macro. This function is called by the `port_ultrasound_init()` public function to configure the timer that controls the duration of the trigger signal.
- * 
+ *
+ * This function configures the trigger timer of the sensor (**TIM13** for REAR and **TIM14** for FRONT) to generate internal interrupts to control the raise and fall of the trigger signal. The duration of the trigger signal is defined in the `PORT_PARKING_SENSOR_TRIGGER_UP_US` macro. This function is called by the `port_ultrasound_init()` public function to configure the timer that controls the duration of the trigger signal.
+ *
  * **To calculare the `ARR` and `PSC` an efficient algorithm is used:**
- * 
+ *
  * This option is the most efficient way to calculate the `ARR` and `PSC` values. It is based on the fact that the `ARR` value is near or equal to its maximum value (65535.0). And only one update of the `PSC` is needed. This eliminates the need for a loop, which could be slow if `ARR` is much larger than 0xFFFF.
- * 
- * @param ultrasound_id Ultrasound ID. This ID is used to configure the timer that controls the echo signal of the ultrasound sensor.
- * 
+ *
+ * @param p_ultrasound Pointer to the HW description of the ultrasound sensor.
+ *
  * @note **The timer is not enabled yet**. This will be done when the trigger signal must be sent.
  */
-static void _timer_trigger_setup (uint32_t ultrasound_id)
+static void _timer_trigger_setup(stm32f4_ultrasound_hw_t *p_ultrasound)
 {
-    // Configuramos TIM13
+    TIM_TypeDef *p_tim = p_ultrasound->p_trigger_timer;
     /*Primero, habilitamos el timer del trigger*/
-    RCC->APB1ENR |= RCC_APB1ENR_TIM13EN;
+    _timer_enable_clock(p_tim);
     /*Segundo, inhabilitamos el controlador*/
-    TIM13->CR1 &= ~TIM_CR1_CEN;
+    p_tim->CR1 &= ~TIM_CR1_CEN;
     /*Tercero, habilitamos el autoreload preload*/
-    TIM13->CR1 |= TIM_CR1_ARPE;
+    p_tim->CR1 |= TIM_CR1_ARPE;
     /*Cuarto, aseguramos el inicio del contador a cero*/
-    TIM13->CNT = 0;
+    p_tim->CNT = 0;
     /*Quinto, calculamos ARR y PSC para que el periodo del timer sea 10 microsegundos*/
     double reloj = (double) SystemCoreClock;
     double periodo = (double) PORT_PARKING_SENSOR_TRIGGER_UP_US;
@@ -172,190 +347,253 @@ static void _timer_trigger_setup (uint32_t ultrasound_id)
     arr = round((periodo * reloj / (psc + 1.0)) - 1.0);
     }
     /*Sexto, cargamos ARR y PSC en sus correspondientes registros*/
-    TIM13->ARR = (uint32_t)arr;
-    TIM13->PSC = (uint32_t)psc;
+    p_tim->ARR = (uint32_t)arr;
+    p_tim->PSC = (uint32_t)psc;
     /*Septimo, generamos un evento de actualizacion*/
-    TIM13->EGR |= TIM_EGR_UG;
+    p_tim->EGR |= TIM_EGR_UG;
     /*Octavo, limpiamos las interrupciones*/
-    TIM13->SR &= ~TIM_SR_UIF;
+    p_tim->SR &= ~TIM_SR_UIF;
     /*Noveno, habilitamos las interrupciones del timer*/
-    TIM13->DIER |= TIM_DIER_UIE;
+    p_tim->DIER |= TIM_DIER_UIE;
     /*Decimo, establecemos las prioridades de las interrupciones*/
-    NVIC_SetPriority(TIM8_UP_TIM13_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 4, 0));
+    NVIC_SetPriority(p_ultrasound->trigger_irqn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 4, 0));
+}
+#else
+/**
+ * @brief Configure the timer that generates the trigger signal in hardware.
+ *
+ * This function configures the channel 1 of the trigger timer of the sensor (**TIM13** for REAR and **TIM14** for FRONT) in output compare mode to generate the trigger pulse. The timer counts microseconds and the pulse ends when the counter reaches `CCR1` = `PORT_PARKING_SENSOR_TRIGGER_UP_US` (see `_timer_trigger_pulse()`). The timer has no interrupts.
+ *
+ * @param p_ultrasound Pointer to the HW description of the ultrasound sensor.
+ *
+ * @note **The timer is not enabled yet**. This will be done when the trigger signal must be sent.
+ */
+static void _timer_trigger_setup(stm32f4_ultrasound_hw_t *p_ultrasound)
+{
+    TIM_TypeDef *p_tim = p_ultrasound->p_trigger_timer;
+    /*Primero, habilitamos el timer del trigger y deshabilitamos el contador*/
+    _timer_enable_clock(p_tim);
+    p_tim->CR1 &= ~TIM_CR1_CEN;
+    /*Segundo, cada tick es 1 microsegundo*/
+    p_tim->PSC = SystemCoreClock / 1000000 - 1;
+    p_tim->ARR = 0xFFFF;
+    /*Tercero, el pulso termina cuando el contador llega a CCR1*/
+    p_tim->CCR1 = PORT_PARKING_SENSOR_TRIGGER_UP_US;
+    /*Cuarto, generamos un evento de actualizacion para cargar PSC*/
+    p_tim->EGR |= TIM_EGR_UG;
+    /*Quinto, canal 1 como salida, forzada a nivel bajo hasta el primer pulso*/
+    p_tim->CCMR1 &= ~(TIM_CCMR1_CC1S | TIM_CCMR1_OC1M | TIM_CCMR1_OC1PE);
+    p_tim->CCMR1 |= (0x4 << TIM_CCMR1_OC1M_Pos);
+    /*Sexto, habilitamos la salida del canal 1, activa a nivel alto*/
+    p_tim->CCER &= ~TIM_CCER_CC1P;
+    p_tim->CCER |= TIM_CCER_CC1E;
+    /*Septimo, limpiamos los flags y deshabilitamos las interrupciones*/
+    p_tim->SR = 0;
+    p_tim->DIER &= ~TIM_DIER_UIE;
+}
 
-    // Configuramos TIM14
-    /*Primero, habilitamos el timer del trigger*/
-    RCC->APB1ENR |= RCC_APB1ENR_TIM14EN;
-    /*Segundo, inhabilitamos el controlador*/
-    TIM14->CR1 &= ~TIM_CR1_CEN;
-    /*Tercero, habilitamos el autoreload preload*/
-    TIM14->CR1 |= TIM_CR1_ARPE;
-    /*Cuarto, aseguramos el inicio del contador a cero*/
-    TIM14->CNT = 0;
-    /*Quinto, calculamos ARR y PSC para que el periodo del timer sea 10 microsegundos*/
-    /*double*/ reloj = (double) SystemCoreClock;
-    /*double*/ periodo = (double) PORT_PARKING_SENSOR_TRIGGER_UP_US;
-    periodo /= 1000000.0;
-    /*double*/ arr = 65535.0;
-    /*double*/ psc = round((periodo * reloj / (arr + 1.0)) - 1.0);
-    arr = round((periodo * reloj / (psc + 1.0)) - 1.0);
-    if (arr > 65535.0) {
-    psc += 1.0;
-    arr = round((periodo * reloj / (psc + 1.0)) - 1.0);
-    }
-    /*Sexto, cargamos ARR y PSC en sus correspondientes registros*/
-    TIM14->ARR = (uint32_t)arr;
-    TIM14->PSC = (uint32_t)psc;
-    /*Septimo, generamos un evento de actualizacion*/
-    TIM14->EGR |= TIM_EGR_UG;
-    /*Octavo, limpiamos las interrupciones*/
-    TIM14->SR &= ~TIM_SR_UIF;
-    /*Noveno, habilitamos las interrupciones del timer*/
-    TIM14->DIER |= TIM_DIER_UIE;
-    /*Decimo, establecemos las prioridades de las interrupciones*/
-    NVIC_SetPriority(TIM8_TRG_COM_TIM14_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 4, 0)); 
+/**
+ * @brief Generate a trigger pulse in hardware.
+ *
+ * The output is forced HIGH with the counter stopped at 0, and then the channel is switched to "set inactive on match" mode, so the compare match pulls it LOW after exactly `CCR1` ticks. The counter keeps running afterwards but the output stays LOW, since the next matches keep it inactive. Interrupts are masked between forcing the output and enabling the counter, so the pulse cannot be stretched.
+ *
+ * @param p_tim Timer of the trigger signal.
+ */
+static void _timer_trigger_pulse(TIM_TypeDef *p_tim)
+{
+    p_tim->CR1 &= ~TIM_CR1_CEN;
+    p_tim->CNT = 0;
+    /* The compare flag tells when the pulse is over (see `port_ultrasound_stop_trigger_timer()`) */
+    p_tim->SR = ~TIM_SR_CC1IF;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    p_tim->CCMR1 = (p_tim->CCMR1 & ~TIM_CCMR1_OC1M) | (0x5 << TIM_CCMR1_OC1M_Pos);
+    p_tim->CCMR1 = (p_tim->CCMR1 & ~TIM_CCMR1_OC1M) | (0x2 << TIM_CCMR1_OC1M_Pos);
+    p_tim->CR1 |= TIM_CR1_CEN;
+    __set_PRIMASK(primask);
 }
+#endif
 
 /**
  * @brief Configure the timer that controls the duration of the echo signal.
- * 
- * This function configures the timer **TIM2** as input capture to measure the duration of the echo signal. `port_ultrasound_init()` public function to configure the timer.
- * 
- * @attention The timer that controls the echo signal is specific for each ultrasound sensor and must be configured separately (within a conditional statement). Use the ultrasound ID to select the correct timer.
- * 
- * @note **The timer is not enabled yet**. This will be done when the trigger signal must be sent. **The timer interrupt is not enabled yet**. This will be done when the trigger signal must be sent.
- * 
- * @param ultrasound_id Ultrasound ID. This ID is used to configure the timer that controls the echo signal of the ultrasound sensor.
+ *
+ * This function configures the capture channel of the sensor on its 32-bit echo timer (**TIM2** CH2 for REAR and CH1 for FRONT). This function is called by the `port_ultrasound_init()` public function to configure the timer.
+ *
+ * The echo timer is a free-running timebase shared by all the sensors that use it: it counts up to `0xFFFFFFFF` (71 minutes at 1 us per tick, 268 s at the full timer clock with `STM32F4_ULTRASOUND_HIGH_RES`) and it is never stopped nor reset, so every capture is an absolute timestamp. The duration of an echo signal is the difference of two captures, which is correct modulo 2^32 even if the counter wraps around in between. Therefore there is no update interrupt and no overflow counting. The timebase is configured by the first sensor that uses it; the next ones only configure their channel. If the other timebase is already running, the new one starts from its count, so the timestamps of both differ by a few ticks at most.
+ *
+ * Each capture generates a DMA request instead of an interrupt (see `_dma_echo_setup()`), so the edges of the echo signal do not interrupt the CPU. Only the channels without a free DMA stream generate a capture interrupt (see `stm32f4_ultrasound_capture_isr()`).
+ *
+ * @param p_ultrasound Pointer to the HW description of the ultrasound sensor.
+ *
+ * @note **The timer is enabled here**. It only interrupts if a channel has no DMA stream.
  */
-static void _timer_echo_setup(uint32_t ultrasound_id)
+static void _timer_echo_setup(stm32f4_ultrasound_hw_t *p_ultrasound)
 {
-    /*Primero, habilitamos el timer del echo y deshabilitamos el contador*/
-    RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
-    TIM2->CR1 &= ~TIM_CR1_CEN;
-    /*Segundo, calculamos ARR y PSC para que el periodo del timer sea 1 microsegundo*/
-    double reloj = (double) SystemCoreClock;
-    double periodo = 0.000001;
-    double arr = 65535.0;  // Se dice que arr debe configurarse a su máximo
-    double psc = (reloj*periodo) - 1;
-    TIM2->ARR = (uint32_t)arr;
-    TIM2->PSC = (uint32_t)psc;
-    /*Tercero, habilitamos el autoreload preload y generamos un evento de actualizacion*/
-    TIM2->CR1 |= TIM_CR1_ARPE;
-    TIM2->EGR |= TIM_EGR_UG;
-
-    // Configuramos CH2
-    /*Cuarto, marcamos la direccion como input en el registros de Captura/Compare*/
-    TIM2->CCMR1 |= (0x1 << TIM_CCMR1_CC2S_Pos);
-    /*Quinto, deshabilitamos el filtro digital*/
-    TIM2->CCMR1 &= ~TIM_CCMR1_IC2F;
-    /*Sexto, habilitamos la captura de entrada en ambos flancos (subida y bajada), mediante los bits CC2NP y CC2P del registro CCER*/
-    TIM2->CCER |= TIM_CCER_CC2NP;
-    TIM2->CCER |= TIM_CCER_CC2P;
-    /*Septimo, programamos el preescalado de entrada para capturar cada transicion valida, poner a 0*/
-    TIM2->CCMR1 &= ~(TIM_CCMR1_IC2PSC);
-    /*Octavo, habilitamos la captura de entrada*/
-    TIM2->CCER |= TIM_CCER_CC2E;
-    /*Noveno, habilitamos las interrupciones de la captura de entrada*/
-    TIM2->DIER |= TIM_DIER_CC2IE;
-    
-    // Configuramos CH1
-    /*Cuarto, marcamos la direccion como input en el registros de Captura/Compare*/
-    TIM2->CCMR1 |= (0x1 << TIM_CCMR1_CC1S_Pos);
-    /*Quinto, deshabilitamos el filtro digital*/
-    TIM2->CCMR1 &= ~TIM_CCMR1_IC1F;
-    /*Sexto, habilitamos la captura de entrada en ambos flancos (subida y bajada), mediante los bits CC2NP y CC2P del registro CCER*/
-    TIM2->CCER |= TIM_CCER_CC1NP;
-    TIM2->CCER |= TIM_CCER_CC1P;
-    /*Septimo, programamos el preescalado de entrada para capturar cada transicion valida, poner a 0*/
-    TIM2->CCMR1 &= ~(TIM_CCMR1_IC1PSC);
-    /*Octavo, habilitamos la captura de entrada*/
-    TIM2->CCER |= TIM_CCER_CC1E;
-    /*Noveno, habilitamos las interrupciones de la captura de entrada*/
-    TIM2->DIER |= TIM_DIER_CC1IE;
-
-    // Configuracion comun
-    /*Decimo, actualizamos las interrupciones del timer*/
-    TIM2->DIER |= TIM_DIER_UIE;
-    /*Undecimo, establecemos las prioridades de las interrupciones*/
-    NVIC_SetPriority(TIM2_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 3, 0));
+    TIM_TypeDef *p_tim = p_ultrasound->p_echo_timer;
+    uint32_t channel = p_ultrasound->echo_channel - 1;
+
+    // Base de tiempos comun, solo la primera vez
+    if (!(p_tim->CR1 & TIM_CR1_CEN))
+    {
+        /*Primero, habilitamos el timer del echo*/
+        _timer_enable_clock(p_tim);
+        /*Segundo, configuramos PSC para que cada tick sea 1 microsegundo (o un ciclo del reloj en alta resolucion) y ARR a su maximo (timer de 32 bits)*/
+        p_tim->ARR = 0xFFFFFFFF;
+        p_tim->PSC = SystemCoreClock / (1000000 * port_ultrasound_get_echo_ticks_per_us(0)) - 1;
+        /*Tercero, habilitamos el autoreload preload y generamos un evento de actualizacion*/
+        p_tim->CR1 |= TIM_CR1_ARPE;
+        p_tim->EGR |= TIM_EGR_UG;
+        /*Cuarto, limpiamos los flags y no habilitamos ninguna interrupcion: no hay desbordamientos que contar*/
+        p_tim->SR = 0;
+        p_tim->DIER = 0;
+        /*Quinto, arrancamos la base de tiempos, que ya no se para nunca, alineada con la otra si ya esta en marcha*/
+        for (uint32_t i = 0; i < sizeof(ultrasound_arr) / sizeof(ultrasound_arr[0]); i++)
+        {
+            TIM_TypeDef *p_other = ultrasound_arr[i].p_echo_timer;
+            if ((p_other != p_tim) && (p_other->CR1 & TIM_CR1_CEN))
+            {
+                p_tim->CNT = p_other->CNT;
+                break;
+            }
+        }
+        p_tim->CR1 |= TIM_CR1_CEN;
+    }
+
+    // Canal de captura del sensor
+    /*Sexto, marcamos la direccion como input, sin filtro digital y sin preescalado de entrada (CCxS = 01, ICxF = 0, ICxPSC = 0)*/
+    volatile uint32_t *p_ccmr = (channel < 2) ? &p_tim->CCMR1 : &p_tim->CCMR2;
+    uint32_t ccmr_shift = (channel % 2) * 8;
+    *p_ccmr = (*p_ccmr & ~(0xFFU << ccmr_shift)) | (0x1U << ccmr_shift);
+    /*Septimo, habilitamos la captura de entrada en ambos flancos (subida y bajada), mediante los bits CCxNP y CCxP del registro CCER*/
+    p_tim->CCER |= (TIM_CCER_CC1NP | TIM_CCER_CC1P | TIM_CCER_CC1E) << (channel * 4);
+    /*Octavo, cada captura genera una peticion de DMA en lugar de una interrupcion, salvo si el canal no tiene stream libre*/
+    if (p_ultrasound->p_dma_stream != NULL)
+    {
+        p_tim->DIER &= ~(TIM_DIER_CC1IE << channel);
+        p_tim->DIER |= (TIM_DIER_CC1DE << channel);
+    }
+    else
+    {
+        p_tim->SR = ~(TIM_SR_CC1IF << channel);
+        p_tim->DIER &= ~(TIM_DIER_CC1DE << channel);
+        p_tim->DIER |= (TIM_DIER_CC1IE << channel);
+        /*Noveno, la captura ya esta en el registro: basta con copiarla antes del siguiente flanco del mismo canal*/
+        NVIC_SetPriority(p_ultrasound->echo_irqn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 3, 0));
+        NVIC_EnableIRQ(p_ultrasound->echo_irqn);
+    }
 }
 
 /**
- * @brief Configure the timer that controls the duration of the new measurement.
- * 
- * This function configures the timer **TIM10** to generate an internal interrupt to control the duration of a measurement. The duration of a measurement is defined in the `PORT_PARKING_SENSOR_TIMEOUT_MS` macro. This function is called by the `port_ultrasound_init()` public function to configure the timer that controls the duration of the new measurement.
- * 
- * **To calculare the `ARR` and `PSC` an efficient algorithm is used:**
- * 
- * This option is the most efficient way to calculate the `ARR` and `PSC` values. It is based on the fact that the `ARR` value is near or equal to its maximum value (65535.0). And only one update of the `PSC` is needed. This eliminates the need for a loop, which could be slow if `ARR` is much larger than 0xFFFF.
- * 
- * @note **The timer is not enabled yet**. This will be done when the trigger signal must be sent. **The timer interrupt is not enabled yet**. This will be done when the trigger signal must be sent.
+ * @brief Configure the DMA stream that copies the captures of the echo signal of an ultrasound sensor.
+ *
+ * The stream copies each capture of the channel of the echo timer of the sensor to the circular buffer `edge_buf` of the sensor (**DMA1** Stream6 for REAR and Stream5 for FRONT, both on channel 3). It works in circular mode, so it never stops and it needs no interrupts: `port_ultrasound_consume_echo_edges()` reads the buffer up to the position given by the `NDTR` register.
+ *
+ * If the sensor has no DMA stream, only the circular buffer is reset: the captures are copied by `stm32f4_ultrasound_capture_isr()`.
+ *
+ * @param p_ultrasound Pointer to the HW description of the ultrasound sensor.
  */
-void _timer_new_measurement_setup(uint32_t ultrasound_id) 
+static void _dma_echo_setup(stm32f4_ultrasound_hw_t *p_ultrasound)
 {
-    // Configuramos TIM10
-    /*Primero, habilitamos el timer del measurement*/
-    RCC->APB2ENR |= RCC_APB2ENR_TIM10EN;
-    /*Segundo, inhabilitamos el controlador*/
-    TIM10->CR1 &= ~TIM_CR1_CEN;
-    /*Tercero, habilitamos el autoreload preload*/
-    TIM10->CR1 |= TIM_CR1_ARPE;
-    /*Cuarto, aseguramos el inicio del contador a cero*/
-    TIM10->CNT = 0;
-    /*Quinto, calculamos ARR y PSC para que el periodo del timer sea 10 microsegundos*/
-    double reloj = (double) SystemCoreClock;
-    double periodo = PORT_PARKING_SENSOR_TIMEOUT_MS;
-    periodo /= 1000.0;
-    double arr = 65535.0;
-    double psc = round((periodo * reloj / (arr + 1.0)) - 1.0);
-    arr = round((periodo * reloj / (psc + 1.0)) - 1.0);
-    if (arr > 65535.0) {
-    psc += 1.0;
-    arr = round((periodo * reloj / (psc + 1.0)) - 1.0);
+    DMA_Stream_TypeDef *p_stream = p_ultrasound->p_dma_stream;
+    if (p_stream == NULL)
+    {
+        p_ultrasound->edge_write_idx = 0;
+        p_ultrasound->edge_read_idx = 0;
+        p_ultrasound->echo_level = false;
+        return;
     }
-    /*Sexto, cargamos ARR y PSC en sus correspondientes registros*/
-    TIM10->ARR = (uint32_t)arr;
-    TIM10->PSC = (uint32_t)psc;
-    /*Septimo, generamos un evento de actualizacion*/
-    TIM10->EGR |= TIM_EGR_UG;
-    /*Octavo, limpiamos las interrupciones*/
-    TIM10->SR &= ~TIM_SR_UIF;
-    /*Noveno, habilitamos las interrupciones del timer*/
-    TIM10->DIER |= TIM_DIER_UIE;
-    /*Decimo, establecemos las prioridades de las interrupciones*/
-    NVIC_SetPriority(TIM1_UP_TIM10_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 5, 0));
+    DMA_TypeDef *p_dma = ((uint32_t)p_stream < DMA2_BASE) ? DMA1 : DMA2;
+    uint32_t stream = (((uint32_t)p_stream & 0xFFU) - 0x10U) / 0x18U;
+    static const uint8_t flags_shift[4] = {0, 6, 16, 22};
+
+    /*Primero, habilitamos el reloj del DMA*/
+    RCC->AHB1ENR |= (p_dma == DMA1) ? RCC_AHB1ENR_DMA1EN : RCC_AHB1ENR_DMA2EN;
+    /*Segundo, deshabilitamos el stream y esperamos a que se pare*/
+    p_stream->CR &= ~DMA_SxCR_EN;
+    while (p_stream->CR & DMA_SxCR_EN)
+    {
+    }
+    /*Tercero, limpiamos los flags del stream antes de habilitarlo*/
+    if (stream < 4)
+    {
+        p_dma->LIFCR = 0x3DU << flags_shift[stream];
+    }
+    else
+    {
+        p_dma->HIFCR = 0x3DU << flags_shift[stream - 4];
+    }
+    /*Cuarto, origen en el registro de captura y destino en el buffer circular*/
+    p_stream->PAR = (uint32_t)(&p_ultrasound->p_echo_timer->CCR1 + (p_ultrasound->echo_channel - 1));
+    p_stream->M0AR = (uint32_t)p_ultrasound->edge_buf;
+    p_stream->NDTR = STM32F4_ULTRASOUND_EDGE_BUFFER_SIZE;
+    /*Quinto, canal de la peticion, de periferico a memoria, palabras de 32 bits, incremento en memoria y modo circular*/
+    p_stream->CR = ((uint32_t)p_ultrasound->dma_channel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_CIRC;
+    /*Sexto, modo directo: sin FIFO*/
+    p_stream->FCR = 0;
+    /*Septimo, habilitamos el stream*/
+    p_stream->CR |= DMA_SxCR_EN;
+
+    p_ultrasound->edge_read_idx = 0;
+    p_ultrasound->echo_level = false;
+}
+
+/**
+ * @brief Convert a measurement period in ms to the `ARR` value of the timers of new measurements.
+ *
+ * The timers count at `STM32F4_ULTRASOUND_MEASUREMENT_TICK_HZ`, so the `PSC` is fixed and only the `ARR` changes with the period. The period is saturated to the range of the 16-bit `ARR`.
+ *
+ * @param period_ms Period in ms.
+ * @return uint32_t Value of the `ARR` register.
+ */
+static uint32_t _measurement_period_to_arr(uint32_t period_ms)
+{
+    uint32_t ticks = period_ms * (STM32F4_ULTRASOUND_MEASUREMENT_TICK_HZ / 1000);
+    if (ticks == 0)
+    {
+        ticks = 1;
+    }
+    if (ticks > 0x10000)
+    {
+        ticks = 0x10000;
+    }
+    return ticks - 1;
+}
 
-    // Configuramos TIM6
+/**
+ * @brief Configure the timer that controls the duration of the new measurement.
+ *
+ * This function configures the timer of new measurements of the sensor (**TIM10** for REAR and **TIM6** for FRONT) to generate an internal interrupt to control the duration of a measurement. The initial duration of a measurement is defined in the `PORT_PARKING_SENSOR_TIMEOUT_MS` macro, and it can be changed at runtime with `port_ultrasound_set_measurement_period_ms()`. This function is called by the `port_ultrasound_init()` public function to configure the timer that controls the duration of the new measurement.
+ *
+ * The `PSC` is fixed so that the timers count at `STM32F4_ULTRASOUND_MEASUREMENT_TICK_HZ`, and the period is set only with the `ARR` register using integer arithmetic (see `_measurement_period_to_arr()`).
+ *
+ * @param p_ultrasound Pointer to the HW description of the ultrasound sensor.
+ *
+ * @note **The timer is not enabled yet**. This will be done when the trigger signal must be sent. **The timer interrupt is not enabled yet**. This will be done when the trigger signal must be sent.
+ */
+static void _timer_new_measurement_setup(stm32f4_ultrasound_hw_t *p_ultrasound)
+{
+    TIM_TypeDef *p_tim = p_ultrasound->p_period_timer;
     /*Primero, habilitamos el timer del measurement*/
-    RCC->APB1ENR |= RCC_APB1ENR_TIM6EN;
+    _timer_enable_clock(p_tim);
     /*Segundo, inhabilitamos el controlador*/
-    TIM6->CR1 &= ~TIM_CR1_CEN;
+    p_tim->CR1 &= ~TIM_CR1_CEN;
     /*Tercero, habilitamos el autoreload preload*/
-    TIM6->CR1 |= TIM_CR1_ARPE;
+    p_tim->CR1 |= TIM_CR1_ARPE;
     /*Cuarto, aseguramos el inicio del contador a cero*/
-    TIM6->CNT = 0;
-    /*Quinto, calculamos ARR y PSC para que el periodo del timer sea 10 microsegundos*/
-    reloj = (double) SystemCoreClock;
-    periodo = PORT_PARKING_SENSOR_TIMEOUT_MS;
-    periodo /= 1000.0;
-    arr = 65535.0;
-    psc = round((periodo * reloj / (arr + 1.0)) - 1.0);
-    arr = round((periodo * reloj / (psc + 1.0)) - 1.0);
-    if (arr > 65535.0) {
-    psc += 1.0;
-    arr = round((periodo * reloj / (psc + 1.0)) - 1.0);
-    }
+    p_tim->CNT = 0;
+    /*Quinto, calculamos ARR y PSC para que el periodo del timer sea PORT_PARKING_SENSOR_TIMEOUT_MS*/
+    p_ultrasound->measurement_period_ms = PORT_PARKING_SENSOR_TIMEOUT_MS;
     /*Sexto, cargamos ARR y PSC en sus correspondientes registros*/
-    TIM6->ARR = (uint32_t)arr;
-    TIM6->PSC = (uint32_t)psc;
+    p_tim->ARR = _measurement_period_to_arr(PORT_PARKING_SENSOR_TIMEOUT_MS);
+    p_tim->PSC = SystemCoreClock / STM32F4_ULTRASOUND_MEASUREMENT_TICK_HZ - 1;
     /*Septimo, generamos un evento de actualizacion*/
-    TIM6->EGR |= TIM_EGR_UG;
+    p_tim->EGR |= TIM_EGR_UG;
     /*Octavo, limpiamos las interrupciones*/
-    TIM6->SR &= ~TIM_SR_UIF;
+    p_tim->SR &= ~TIM_SR_UIF;
     /*Noveno, habilitamos las interrupciones del timer*/
-    TIM6->DIER |= TIM_DIER_UIE;
+    p_tim->DIER |= TIM_DIER_UIE;
     /*Decimo, establecemos las prioridades de las interrupciones*/
-    NVIC_SetPriority(TIM6_DAC_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 5, 0));
+    NVIC_SetPriority(p_ultrasound->period_irqn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 5, 0));
 }
 
 /* Public functions -----------------------------------------------------------*/
@@ -365,26 +603,30 @@ void port_ultrasound_init(uint32_t ultrasound_id)
     stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
 
     /* Trigger pin configuration */
+    port_event_queue_init(&p_ultrasound->trigger_events);
+    port_event_queue_init(&p_ultrasound->period_events);
     p_ultrasound->trigger_ready = true;
     p_ultrasound->trigger_end = false;
+#if STM32F4_ULTRASOUND_HW_TRIGGER
+    stm32f4_system_gpio_config(p_ultrasound->p_trigger_port, p_ultrasound->trigger_pin, STM32F4_GPIO_MODE_AF, STM32F4_GPIO_PUPDR_NOPULL);
+    stm32f4_system_gpio_config_alternate(p_ultrasound->p_trigger_port, p_ultrasound->trigger_pin, p_ultrasound->trigger_alt_fun);
+#else
     stm32f4_system_gpio_config(p_ultrasound->p_trigger_port, p_ultrasound->trigger_pin, STM32F4_GPIO_MODE_OUT, STM32F4_GPIO_PUPDR_NOPULL);
+#endif
 
     /* Echo pin configuration */
-    p_ultrasound->echo_alt_fun = STM32F4_AF1;
     p_ultrasound->echo_received = false;
+    p_ultrasound->echo_listening = false;
     p_ultrasound->echo_init_tick = 0;
     p_ultrasound->echo_end_tick = 0;
-    p_ultrasound->echo_overflows = 0;
     stm32f4_system_gpio_config(p_ultrasound->p_echo_port, p_ultrasound->echo_pin, STM32F4_GPIO_MODE_AF, STM32F4_GPIO_PUPDR_NOPULL);
     stm32f4_system_gpio_config_alternate(p_ultrasound->p_echo_port, p_ultrasound->echo_pin, p_ultrasound->echo_alt_fun);
 
     /* Configure timers */
-    // Se configuran una sola vez
-    if (ultrasound_id == 0) {
-        _timer_trigger_setup(ultrasound_id);
-        _timer_echo_setup(ultrasound_id);
-        _timer_new_measurement_setup(ultrasound_id);
-    }
+    _timer_trigger_setup(p_ultrasound);
+    _dma_echo_setup(p_ultrasound);
+    _timer_echo_setup(p_ultrasound);
+    _timer_new_measurement_setup(p_ultrasound);
 }
 
 // Getters and setters functions
@@ -402,6 +644,43 @@ void stm32f4_ultrasound_set_new_echo_gpio(uint32_t ultrasound_id, GPIO_TypeDef *
     p_ultrasound->echo_pin = pin;
 }
 
+bool stm32f4_ultrasound_get_echo_level(uint32_t ultrasound_id)
+{
+    stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
+    return stm32f4_system_gpio_read(p_ultrasound->p_echo_port, p_ultrasound->echo_pin);
+}
+
+void stm32f4_ultrasound_timer_isr(TIM_TypeDef *p_tim)
+{
+    p_tim->SR &= ~TIM_SR_UIF;
+    uint32_t now_ms = port_system_get_millis();
+    for (uint32_t i = 0; i < sizeof(ultrasound_arr) / sizeof(ultrasound_arr[0]); i++)
+    {
+        if (ultrasound_arr[i].p_trigger_timer == p_tim)
+        {
+            port_event_queue_push(&ultrasound_arr[i].trigger_events, PORT_ULTRASOUND_EVENT_TRIGGER_END, 0, now_ms);
+        }
+        if (ultrasound_arr[i].p_period_timer == p_tim)
+        {
+            port_event_queue_push(&ultrasound_arr[i].period_events, PORT_ULTRASOUND_EVENT_TRIGGER_READY, 0, now_ms);
+        }
+    }
+}
+
+void stm32f4_ultrasound_capture_isr(TIM_TypeDef *p_tim)
+{
+    for (uint32_t i = 0; i < sizeof(ultrasound_arr) / sizeof(ultrasound_arr[0]); i++)
+    {
+        stm32f4_ultrasound_hw_t *p_ultrasound = &ultrasound_arr[i];
+        uint32_t channel = p_ultrasound->echo_channel - 1;
+        if ((p_ultrasound->p_echo_timer == p_tim) && (p_ultrasound->p_dma_stream == NULL) && (p_tim->SR & (TIM_SR_CC1IF << channel)))
+        {
+            p_ultrasound->edge_buf[p_ultrasound->edge_write_idx] = (&p_tim->CCR1)[channel];
+            p_ultrasound->edge_write_idx = (p_ultrasound->edge_write_idx + 1) % STM32F4_ULTRASOUND_EDGE_BUFFER_SIZE;
+        }
+    }
+}
+
 bool port_ultrasound_get_trigger_ready (uint32_t ultrasound_id)
 {
     stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
@@ -450,42 +729,70 @@ void port_ultrasound_set_echo_init_tick(uint32_t ultrasound_id, uint32_t echo_in
     p_ultrasound->echo_init_tick = echo_init_tick;
 }
 
-uint32_t port_ultrasound_get_echo_overflows(uint32_t ultrasound_id)
+bool port_ultrasound_get_echo_received(uint32_t ultrasound_id)
 {
     stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-    return p_ultrasound->echo_overflows;
+    return p_ultrasound->echo_received;
 }
 
-void port_ultrasound_set_echo_overflows(uint32_t ultrasound_id, uint32_t echo_overflows)
+void port_ultrasound_set_echo_received(uint32_t ultrasound_id, bool echo_received)
 {
     stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-    p_ultrasound->echo_overflows = echo_overflows;
+    p_ultrasound->echo_received = echo_received;
 }
 
-bool port_ultrasound_get_echo_received(uint32_t ultrasound_id)
+void port_ultrasound_read_echo(uint32_t ultrasound_id, port_ultrasound_echo_t *p_echo)
 {
     stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-    return p_ultrasound->echo_received;
+    p_echo->echo_init_tick = p_ultrasound->echo_init_tick;
+    p_echo->echo_end_tick = p_ultrasound->echo_end_tick;
+    p_echo->echo_received = p_ultrasound->echo_received;
 }
 
-void port_ultrasound_set_echo_received(uint32_t ultrasound_id, bool echo_received)
+bool port_ultrasound_pop_event(uint32_t ultrasound_id, port_event_t *p_event)
 {
     stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-    p_ultrasound->echo_received = echo_received;
+    port_event_t trigger_event;
+    port_event_t period_event;
+    bool trigger_pending = port_event_queue_peek(&p_ultrasound->trigger_events, &trigger_event);
+    bool period_pending = port_event_queue_peek(&p_ultrasound->period_events, &period_event);
+    /* The oldest event of the two queues. At the same time, the trigger signal ends before the measurement time expires */
+    if (trigger_pending && (!period_pending || ((int32_t)(period_event.timestamp_ms - trigger_event.timestamp_ms) >= 0)))
+    {
+        return port_event_queue_pop(&p_ultrasound->trigger_events, p_event);
+    }
+    return port_event_queue_pop(&p_ultrasound->period_events, p_event);
+}
+
+uint32_t port_ultrasound_get_event_count(uint32_t ultrasound_id)
+{
+    stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
+    return port_event_queue_get_count(&p_ultrasound->trigger_events) + port_event_queue_get_count(&p_ultrasound->period_events);
+}
+
+uint32_t port_ultrasound_get_event_overflows(uint32_t ultrasound_id)
+{
+    stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
+    return port_event_queue_get_overflows(&p_ultrasound->trigger_events) + port_event_queue_get_overflows(&p_ultrasound->period_events);
 }
 
 // Util
 void port_ultrasound_stop_trigger_timer (uint32_t ultrasound_id){
     stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
+#if STM32F4_ULTRASOUND_HW_TRIGGER
+    /* Stopping the counter during the pulse would freeze the output HIGH: if the pulse is not over, the counter keeps running with the output LOW */
+    if (p_ultrasound->p_trigger_timer->SR & TIM_SR_CC1IF) p_ultrasound->p_trigger_timer->CR1 &= ~TIM_CR1_CEN;
+#else
     stm32f4_system_gpio_write(p_ultrasound->p_trigger_port, p_ultrasound->trigger_pin, false);
-    if (ultrasound_id == PORT_REAR_PARKING_SENSOR_ID) TIM13->CR1 &= ~TIM_CR1_CEN;
-    if (ultrasound_id == PORT_FRONT_PARKING_SENSOR_ID) TIM14->CR1 &= ~TIM_CR1_CEN;
-    
+    p_ultrasound->p_trigger_timer->CR1 &= ~TIM_CR1_CEN;
+#endif
 }
 
 void port_ultrasound_stop_echo_timer(uint32_t ultrasound_id) 
 {
-    TIM2->CR1 &= ~TIM_CR1_CEN;
+    /* The timebase and the DMA keep running for the other sensors: the next edges of this sensor are just not stored */
+    stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
+    p_ultrasound->echo_listening = false;
 }
 
 void port_ultrasound_reset_echo_ticks(uint32_t ultrasound_id) 
@@ -493,73 +800,123 @@ void port_ultrasound_reset_echo_ticks(uint32_t ultrasound_id)
     stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
     p_ultrasound->echo_init_tick = 0;
     p_ultrasound->echo_end_tick = 0;
-    p_ultrasound->echo_overflows = 0;
     p_ultrasound->echo_received = false;
 }
 
-void port_ultrasound_start_measurement(uint32_t ultrasound_id)
+void port_ultrasound_abort_echo(uint32_t ultrasound_id)
 {
     stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-    p_ultrasound->trigger_ready = false;
-    if (ultrasound_id == PORT_REAR_PARKING_SENSOR_ID)
-    {
-        TIM13->CNT = 0; 
-        TIM2->CNT = 0;
-        TIM10->CNT = 0;
-    }
-    if (ultrasound_id == PORT_FRONT_PARKING_SENSOR_ID)
-    {
-        TIM14->CNT = 0;
-        TIM2->CNT = 0;
-        TIM6->CNT = 0;
-    }
-    stm32f4_system_gpio_write(p_ultrasound->p_trigger_port, p_ultrasound->trigger_pin, true);
-    if (ultrasound_id == PORT_REAR_PARKING_SENSOR_ID)
-    {
-        NVIC_EnableIRQ(TIM8_UP_TIM13_IRQn);  
-        NVIC_EnableIRQ(TIM2_IRQn);
-        NVIC_EnableIRQ(TIM1_UP_TIM10_IRQn);
+    port_ultrasound_reset_echo_ticks(ultrasound_id);
+    /* The echo timer keeps running to capture the end of the abandoned echo signal (see `port_ultrasound_consume_echo_edges()`) */
+    p_ultrasound->echo_aborted = true;
+}
 
-        TIM13->CR1 |= TIM_CR1_CEN;  
-        TIM2->CR1 |= TIM_CR1_CEN; 
-        TIM10->CR1 |= TIM_CR1_CEN;
-    }
-    if (ultrasound_id == PORT_FRONT_PARKING_SENSOR_ID)
-    {
-        NVIC_EnableIRQ(TIM8_TRG_COM_TIM14_IRQn);
-        NVIC_EnableIRQ(TIM2_IRQn);
-        NVIC_EnableIRQ(TIM6_DAC_IRQn);
+uint32_t port_ultrasound_get_echo_ticks_per_us(uint32_t ultrasound_id)
+{
+    /* All the sensors share the timebase, so the resolution does not depend on the sensor */
+#if STM32F4_ULTRASOUND_HIGH_RES
+    return SystemCoreClock / 1000000;
+#else
+    return 1;
+#endif
+}
 
-        TIM14->CR1 |= TIM_CR1_CEN; 
-        TIM2->CR1 |= TIM_CR1_CEN;  
-        TIM6->CR1 |= TIM_CR1_CEN;
-    }    
+uint32_t port_ultrasound_get_echo_current_tick(uint32_t ultrasound_id)
+{
+    stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
+    return p_ultrasound->p_echo_timer->CNT;
 }
 
-void port_ultrasound_start_new_measurement_timer(uint32_t ultrasound_id)
+bool port_ultrasound_consume_echo_edges(uint32_t ultrasound_id)
 {
-    if(ultrasound_id == PORT_REAR_PARKING_SENSOR_ID)
+    stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
+    uint32_t write_idx = _edge_write_idx(p_ultrasound);
+    while (p_ultrasound->edge_read_idx != write_idx)
     {
-        NVIC_EnableIRQ(TIM1_UP_TIM10_IRQn); 
-        TIM10->CR1 |= TIM_CR1_CEN;
+        uint32_t tick = p_ultrasound->edge_buf[p_ultrasound->edge_read_idx];
+        p_ultrasound->edge_read_idx = (p_ultrasound->edge_read_idx + 1) % STM32F4_ULTRASOUND_EDGE_BUFFER_SIZE;
+        // A tick of 0 means that no edge has been captured yet
+        if (tick == 0)
+        {
+            tick = 1;
+        }
+        p_ultrasound->echo_level = !p_ultrasound->echo_level;
+        if (p_ultrasound->echo_level)
+        {
+            if (p_ultrasound->echo_listening && (p_ultrasound->echo_init_tick == 0) && (p_ultrasound->echo_end_tick == 0))
+            {
+                p_ultrasound->echo_init_tick = tick;
+            }
+        }
+        else if ((p_ultrasound->echo_init_tick != 0) && (p_ultrasound->echo_end_tick == 0))
+        {
+            p_ultrasound->echo_end_tick = tick;
+            p_ultrasound->echo_received = true;
+        }
+        else if (p_ultrasound->echo_aborted)
+        {
+            // A falling edge without a stored rising edge ends an abandoned echo: the sensor is free again
+            p_ultrasound->echo_aborted = false;
+            p_ultrasound->trigger_ready = true;
+        }
     }
-    if(ultrasound_id == PORT_FRONT_PARKING_SENSOR_ID)
+    return p_ultrasound->echo_received;
+}
+
+void port_ultrasound_start_measurement(uint32_t ultrasound_id)
+{
+    stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
+    /* The events still queued are older than the new measurement: the FSM tells them apart by their timestamp */
+    p_ultrasound->trigger_ready = false;
+    p_ultrasound->echo_aborted = false;
+    /* Discard the old edges and align their parity with the level of the echo signal, in case the buffer overflowed */
+    p_ultrasound->edge_read_idx = _edge_write_idx(p_ultrasound);
+    p_ultrasound->echo_level = stm32f4_ultrasound_get_echo_level(ultrasound_id);
+    p_ultrasound->echo_listening = true;
+    p_ultrasound->p_period_timer->CNT = 0;
+    NVIC_EnableIRQ(p_ultrasound->period_irqn);
+#if STM32F4_ULTRASOUND_HW_TRIGGER
+    /* The pulse ends by itself: the FSM can go on waiting for the echo without any interrupt */
+    p_ultrasound->trigger_end = true;
+    _timer_trigger_pulse(p_ultrasound->p_trigger_timer);
+#else
+    p_ultrasound->p_trigger_timer->CNT = 0;
+    stm32f4_system_gpio_write(p_ultrasound->p_trigger_port, p_ultrasound->trigger_pin, true);
+    NVIC_EnableIRQ(p_ultrasound->trigger_irqn);
+    p_ultrasound->p_trigger_timer->CR1 |= TIM_CR1_CEN;
+#endif
+    p_ultrasound->p_period_timer->CR1 |= TIM_CR1_CEN;
+}
+
+void port_ultrasound_start_new_measurement_timer(uint32_t ultrasound_id)
+{
+    stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
+    NVIC_EnableIRQ(p_ultrasound->period_irqn);
+    p_ultrasound->p_period_timer->CR1 |= TIM_CR1_CEN;
+}
+
+void port_ultrasound_set_measurement_period_ms(uint32_t ultrasound_id, uint32_t period_ms)
+{
+    stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
+    if (p_ultrasound->measurement_period_ms == period_ms)
     {
-        NVIC_EnableIRQ(TIM6_DAC_IRQn); 
-        TIM6->CR1 |= TIM_CR1_CEN;
+        return;
     }
+    p_ultrasound->measurement_period_ms = period_ms;
+    /* ARR is preloaded (ARPE), so the new period starts at the next update event without disturbing the current one */
+    p_ultrasound->p_period_timer->ARR = _measurement_period_to_arr(period_ms);
+}
+
+uint32_t port_ultrasound_get_measurement_period_ms(uint32_t ultrasound_id)
+{
+    stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
+    return p_ultrasound->measurement_period_ms;
 }
 
 void port_ultrasound_stop_new_measurement_timer(uint32_t ultrasound_id)
 {
-    if(ultrasound_id == PORT_REAR_PARKING_SENSOR_ID)
-    {
-        TIM10->CR1 &= ~TIM_CR1_CEN;
-    }
-    if(ultrasound_id == PORT_FRONT_PARKING_SENSOR_ID)
-    {
-        TIM6->CR1 &= ~TIM_CR1_CEN;
-    }
+    stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
+    p_ultrasound->p_period_timer->CR1 &= ~TIM_CR1_CEN;
 }
 
 void port_ultrasound_stop_ultrasound(uint32_t ultrasound_id)
@@ -568,4 +925,5 @@ void port_ultrasound_stop_ultrasound(uint32_t ultrasound_id)
     port_ultrasound_stop_echo_timer(ultrasound_id);
     port_ultrasound_stop_new_measurement_timer(ultrasound_id);
     port_ultrasound_reset_echo_ticks(ultrasound_id);
+    _stm32f4_ultrasound_get(ultrasound_id)->echo_aborted = false;
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+/**
+ * @file bench.h
+ * @brief Timestamps and report of the host micro-benchmarks of the native tests.
+ *
+ * The timestamps are CPU cycles on x86 and nanoseconds otherwise. They are only meaningful on the host: the results on the STM32F4 must be measured on the target.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+#ifndef BENCH_H_
+#define BENCH_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/* Defines and enums ----------------------------------------------------------*/
+/**
+ * @brief Unit of the timestamps of `bench_timestamp()`.
+ *
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_UNIT "cycles"
+#else
+#define BENCH_UNIT "ns"
+#endif
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Return a timestamp in CPU cycles if available, or in nanoseconds otherwise.
+ *
+ * @return uint64_t Timestamp in `BENCH_UNIT`.
+ */
+static inline uint64_t bench_timestamp(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Print the time per call of a reference implementation and of its replacement, and the speed-up.
+ *
+ * @param p_name Name of the benchmark.
+ * @param p_ref_name Name of the reference implementation.
+ * @param ref_ticks Time of all the calls of the reference implementation, in `BENCH_UNIT`.
+ * @param p_new_name Name of the replacement.
+ * @param new_ticks Time of all the calls of the replacement, in `BENCH_UNIT`.
+ * @param calls Number of calls of each implementation.
+ */
+static inline void bench_report(const char *p_name, const char *p_ref_name, uint64_t ref_ticks, const char *p_new_name, uint64_t new_ticks, double calls)
+{
+    printf("[BENCH] %s: %s %.1f %s/call, %s %.1f %s/call (x%.1f)\n", p_name, p_ref_name, ref_ticks / calls, BENCH_UNIT, p_new_name, new_ticks / calls, BENCH_UNIT, (double)ref_ticks / (double)(new_ticks ? new_ticks : 1));
+}
+
+#endif /* BENCH_H_ */
@@ -0,0 +1,63 @@
+/**
+ * @file bench_buzzer_tone.c
+ * @brief Host micro-benchmark of setting a sound level of the buzzer: solving the timer registers with `double` in every call, as `port_buzzer_set_sound()` did, against reading them from the table built by `port_timer_period_build_tones()`.
+ *
+ * It is built with the native tests but it is not run by CTest: it only prints its results.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+/* System dependent libraries */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* HW independent libraries */
+#include "port_buzzer.h"
+#include "port_timer_period.h"
+#include "timer_period_reference.h"
+#include "bench.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define BENCH_CLOCK_HZ 16000000 /*!< Clock of the timer of the buzzer with the HSI */
+#define NUM_BENCH_ROUNDS 2000   /*!< Number of times each level is set */
+
+/* Private variables ---------------------------------------------------------*/
+static port_timer_period_tone_t tones[PORT_BUZZER_MAX_VALUE + 1]; /*!< Table of tones, as built by the STM32F4 port */
+static volatile uint32_t bench_sink;                               /*!< Avoids the compiler removing the benchmark loops */
+
+int main(void)
+{
+    port_timer_period_build_tones(BENCH_CLOCK_HZ, PORT_BUZZER_TONE_BASE_HZ, PORT_BUZZER_TONE_STEP_HZ, (PORT_BUZZER_MAX_VALUE + 1) / 2, tones, PORT_BUZZER_MAX_VALUE + 1);
+    volatile double reloj = (double)BENCH_CLOCK_HZ;
+
+    uint64_t start = bench_timestamp();
+    for (uint32_t r = 0; r < NUM_BENCH_ROUNDS; r++)
+    {
+        for (uint32_t level = 1; level <= PORT_BUZZER_MAX_VALUE; level++)
+        {
+            uint32_t psc, arr;
+            timer_period_reference_solve(reloj, 1 / (200.0 + 9 * ((double)level)), &psc, &arr);
+            bench_sink = psc;
+            bench_sink = arr;
+            bench_sink = (PORT_BUZZER_MAX_VALUE + 1) / 2;
+        }
+    }
+    uint64_t ticks_double = bench_timestamp() - start;
+
+    start = bench_timestamp();
+    for (uint32_t r = 0; r < NUM_BENCH_ROUNDS; r++)
+    {
+        for (uint32_t level = 1; level <= PORT_BUZZER_MAX_VALUE; level++)
+        {
+            const port_timer_period_tone_t *p_tone = &tones[level];
+            bench_sink = p_tone->psc;
+            bench_sink = p_tone->arr;
+            bench_sink = p_tone->ccr;
+        }
+    }
+    uint64_t ticks_table = bench_timestamp() - start;
+
+    bench_report("Buzzer tone", "double solver", ticks_double, "tone table", ticks_table, (double)NUM_BENCH_ROUNDS * PORT_BUZZER_MAX_VALUE);
+    return EXIT_SUCCESS;
+}
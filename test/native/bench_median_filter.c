@@ -0,0 +1,80 @@
+/**
+ * @file bench_median_filter.c
+ * @brief Host micro-benchmark of the median selection kernels against the previous implementation of the ultrasound FSM, which sorted a copy of the window with `qsort()` and took the middle element (see `median_filter_reference.h`).
+ *
+ * It is built with the native tests but it is not run by CTest: it only prints its results.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+/* System dependent libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* HW independent libraries */
+#include "median_filter.h"
+#include "median_filter_reference.h"
+#include "bench.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define MAX_SIZE MEDIAN_FILTER_REFERENCE_MAX_SIZE /*!< Maximum size of the windows */
+#define NUM_BENCH_WINDOWS 1024                    /*!< Number of different windows used in the benchmark */
+#define NUM_BENCH_ROUNDS 200                      /*!< Number of times each window is filtered in the benchmark */
+#define MAX_DISTANCE_CM 400                       /*!< Maximum distance of the random windows (HC-SR04 range) */
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t bench_windows[NUM_BENCH_WINDOWS][MAX_SIZE]; /*!< Random windows used in the benchmark */
+static volatile uint32_t bench_sink;                       /*!< Avoids the compiler removing the benchmark loops */
+
+/**
+ * @brief Measure the time per call of the `qsort()` path and the median kernel for a window size.
+ *
+ */
+static void _bench_size(uint32_t n)
+{
+    uint64_t start = bench_timestamp();
+    for (uint32_t r = 0; r < NUM_BENCH_ROUNDS; r++)
+    {
+        for (uint32_t w = 0; w < NUM_BENCH_WINDOWS; w++)
+        {
+            bench_sink = median_filter_reference_select(bench_windows[w], n);
+        }
+    }
+    uint64_t ticks_qsort = bench_timestamp() - start;
+
+    start = bench_timestamp();
+    for (uint32_t r = 0; r < NUM_BENCH_ROUNDS; r++)
+    {
+        for (uint32_t w = 0; w < NUM_BENCH_WINDOWS; w++)
+        {
+            uint32_t copy[MAX_SIZE];
+            memcpy(copy, bench_windows[w], n * sizeof(uint32_t));
+            bench_sink = median_filter_select(copy, n);
+        }
+    }
+    uint64_t ticks_kernel = bench_timestamp() - start;
+
+    char name[16];
+    sprintf(name, "N = %u", (unsigned)n);
+    bench_report(name, "qsort", ticks_qsort, "median kernel", ticks_kernel, (double)NUM_BENCH_ROUNDS * NUM_BENCH_WINDOWS);
+}
+
+int main(void)
+{
+    srand(1234);
+    for (uint32_t w = 0; w < NUM_BENCH_WINDOWS; w++)
+    {
+        for (uint32_t i = 0; i < MAX_SIZE; i++)
+        {
+            bench_windows[w][i] = (uint32_t)(rand() % MAX_DISTANCE_CM);
+        }
+    }
+    _bench_size(3);
+    _bench_size(5);
+    _bench_size(7);
+    _bench_size(9);
+    _bench_size(MAX_SIZE);
+    return EXIT_SUCCESS;
+}
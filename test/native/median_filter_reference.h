@@ -0,0 +1,48 @@
+/**
+ * @file median_filter_reference.h
+ * @brief Previous computation of the median of the window of the ultrasound FSM, which sorted a copy with `qsort()`. It is the reference of `median_filter.h`.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+#ifndef MEDIAN_FILTER_REFERENCE_H_
+#define MEDIAN_FILTER_REFERENCE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define MEDIAN_FILTER_REFERENCE_MAX_SIZE 15 /*!< Maximum number of values of the reference median */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Comparison function of the previous implementation, without the unsigned subtraction overflow.
+ *
+ */
+static inline int median_filter_reference_compare(const void *a, const void *b)
+{
+    uint32_t va = *(const uint32_t *)a;
+    uint32_t vb = *(const uint32_t *)b;
+    return (va > vb) - (va < vb);
+}
+
+/**
+ * @brief Reference median: sort a copy with `qsort()` and take the element of rank n / 2.
+ *
+ * @param p_values Values, which are not modified.
+ * @param n Number of values, up to `MEDIAN_FILTER_REFERENCE_MAX_SIZE`.
+ * @return uint32_t Median of the values.
+ */
+static inline uint32_t median_filter_reference_select(const uint32_t *p_values, uint32_t n)
+{
+    uint32_t copy[MEDIAN_FILTER_REFERENCE_MAX_SIZE];
+    memcpy(copy, p_values, n * sizeof(uint32_t));
+    qsort(copy, n, sizeof(uint32_t), median_filter_reference_compare);
+    return copy[n / 2];
+}
+
+#endif /* MEDIAN_FILTER_REFERENCE_H_ */
@@ -0,0 +1,99 @@
+/**
+ * @file test_buzzer_tone.c
+ * @brief Unit test of the computation of the timer registers for the tones of the buzzer.
+ *
+ * The reference is the previous implementation of `port_buzzer_set_sound()`, which solved PSC and ARR with `double` and `round()` in every call (see `timer_period_reference.h`). The STM32F4 port now builds a table with `port_timer_period_build_tones()` once, in `port_buzzer_init()`, and each call only copies a row of it. The cost of both is compared by `bench_buzzer_tone.c`.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+/* System dependent libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW independent libraries */
+#include "port_buzzer.h"
+#include "port_timer_period.h"
+#include "timer_period_reference.h"
+
+/* Private variables ---------------------------------------------------------*/
+/**
+ * @brief Clocks of the timers to test: HSI, and the maximum APB1 timer clocks of the STM32F401 and the STM32F446.
+ *
+ */
+static const uint32_t clocks_arr[] = {16000000, 84000000, 90000000, 180000000};
+
+static port_timer_period_tone_t tones[PORT_BUZZER_MAX_VALUE + 1]; /*!< Table of tones, as built by the STM32F4 port */
+
+/* Private functions ---------------------------------------------------------*/
+void setUp(void)
+{
+    // Nothing to do
+}
+
+void tearDown(void)
+{
+    // Nothing to do
+}
+
+/**
+ * @brief The integer solver gives the same registers as the previous one for every level, and for the 4 kHz of the configuration of the timer.
+ *
+ */
+void test_same_as_double(void)
+{
+    char msg[96];
+    for (uint32_t c = 0; c < sizeof(clocks_arr) / sizeof(clocks_arr[0]); c++)
+    {
+        for (uint32_t level = 0; level <= PORT_BUZZER_MAX_VALUE; level++)
+        {
+            uint32_t freq_hz = PORT_BUZZER_TONE_BASE_HZ + PORT_BUZZER_TONE_STEP_HZ * level;
+            uint32_t psc, arr, ref_psc, ref_arr;
+            port_timer_period_solve(clocks_arr[c], freq_hz, &psc, &arr);
+            timer_period_reference_solve((double)clocks_arr[c], 1 / (200.0 + 9 * ((double)level)), &ref_psc, &ref_arr);
+            sprintf(msg, "ERROR: Different registers at %u Hz with a clock of %u Hz", freq_hz, clocks_arr[c]);
+            TEST_ASSERT_EQUAL_UINT32_MESSAGE(ref_psc, psc, msg);
+            TEST_ASSERT_EQUAL_UINT32_MESSAGE(ref_arr, arr, msg);
+        }
+        uint32_t psc, arr, ref_psc, ref_arr;
+        port_timer_period_solve(clocks_arr[c], 4000, &psc, &arr);
+        timer_period_reference_solve((double)clocks_arr[c], 0.00025, &ref_psc, &ref_arr);
+        TEST_ASSERT_EQUAL_UINT32(ref_psc, psc);
+        TEST_ASSERT_EQUAL_UINT32(ref_arr, arr);
+    }
+}
+
+/**
+ * @brief The table of every level has valid registers that give its frequency, within the rounding of ARR, and level 0 is silence.
+ *
+ */
+void test_tone_table(void)
+{
+    for (uint32_t c = 0; c < sizeof(clocks_arr) / sizeof(clocks_arr[0]); c++)
+    {
+        port_timer_period_build_tones(clocks_arr[c], PORT_BUZZER_TONE_BASE_HZ, PORT_BUZZER_TONE_STEP_HZ, (PORT_BUZZER_MAX_VALUE + 1) / 2, tones, PORT_BUZZER_MAX_VALUE + 1);
+        TEST_ASSERT_EQUAL_UINT16(0, tones[0].ccr);
+        for (uint32_t level = 1; level <= PORT_BUZZER_MAX_VALUE; level++)
+        {
+            uint32_t freq_hz = PORT_BUZZER_TONE_BASE_HZ + PORT_BUZZER_TONE_STEP_HZ * level;
+            uint64_t counts = (uint64_t)(tones[level].psc + 1) * (tones[level].arr + 1);
+            TEST_ASSERT_UINT32_WITHIN((uint32_t)tones[level].psc + 1, clocks_arr[c] / freq_hz, (uint32_t)counts);
+            TEST_ASSERT_EQUAL_UINT16((PORT_BUZZER_MAX_VALUE + 1) / 2, tones[level].ccr);
+            TEST_ASSERT_LESS_THAN_UINT32(tones[level].arr, tones[level].ccr);
+            // The higher the level, the shorter the period
+            TEST_ASSERT_LESS_THAN_UINT32((uint32_t)(tones[level - 1].psc + 1) * (tones[level - 1].arr + 1), (uint32_t)counts);
+        }
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_same_as_double);
+    RUN_TEST(test_tone_table);
+
+    exit(UNITY_END());
+}
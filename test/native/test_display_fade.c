@@ -0,0 +1,274 @@
+/**
+ * @file test_display_fade.c
+ * @brief Unit test and host model of the color sequences of the displays.
+ *
+ * The model plays the sequences as the STM32F4 port does: each frame is converted to the values of CCR1 to CCR4, and each update event of the timer loads the preloaded CCRx registers and lets the DMA write the next frame with a burst.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+/* System dependent libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unity.h>
+
+/* HW independent libraries */
+#include "display_fade.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define MODEL_ARR 63999     /*!< ARR of the timer of the displays (20 ms at 16 MHz with PSC = 4) */
+#define MODEL_BURST_LENGTH 4 /*!< Registers written by each burst: CCR1 to CCR4 */
+
+/* Private variables ---------------------------------------------------------*/
+/**
+ * @brief Model of the timer and the DMA stream of a display.
+ *
+ */
+typedef struct
+{
+    uint32_t preload[MODEL_BURST_LENGTH];                            /*!< CCR1 to CCR4 as written by the CPU or the DMA */
+    uint32_t active[MODEL_BURST_LENGTH];                             /*!< CCR1 to CCR4 used by the PWM in the current period */
+    uint32_t burst_buf[DISPLAY_FADE_MAX_FRAMES * MODEL_BURST_LENGTH]; /*!< Frames read by the DMA */
+    uint32_t length;                                                 /*!< Number of words of the sequence */
+    uint32_t ndtr;                                                   /*!< Words left until the end of the sequence */
+    bool circular;                                                   /*!< Circular mode of the stream */
+    bool enabled;                                                    /*!< Stream enabled */
+} model_display_t;
+
+static model_display_t model; /*!< Display under test */
+
+/* Private functions ---------------------------------------------------------*/
+void setUp(void)
+{
+    model = (model_display_t){0};
+}
+
+void tearDown(void)
+{
+    // Nothing to do
+}
+
+/**
+ * @brief Compare value of a level, as computed by the port.
+ *
+ */
+static uint32_t _ccr(uint8_t level)
+{
+    return (MODEL_ARR + 1) * level / PORT_DISPLAY_RGB_MAX_VALUE;
+}
+
+/**
+ * @brief Start a sequence in the model, as `port_display_play()` does.
+ *
+ */
+static void _model_play(const rgb_color_t *p_frames, uint32_t num_frames, bool loop)
+{
+    for (uint32_t i = 0; i < num_frames; i++)
+    {
+        uint32_t *p_burst = &model.burst_buf[i * MODEL_BURST_LENGTH];
+        p_burst[0] = _ccr(p_frames[i].r);
+        p_burst[1] = 0;
+        p_burst[2] = _ccr(p_frames[i].g);
+        p_burst[3] = _ccr(p_frames[i].b);
+    }
+    model.length = num_frames * MODEL_BURST_LENGTH;
+    model.ndtr = model.length;
+    model.circular = loop;
+    model.enabled = true;
+}
+
+/**
+ * @brief Update event of the timer: the preloaded values become active and the DMA writes the next frame.
+ *
+ */
+static void _model_update_event(void)
+{
+    for (uint32_t i = 0; i < MODEL_BURST_LENGTH; i++)
+    {
+        model.active[i] = model.preload[i];
+    }
+    if (!model.enabled)
+    {
+        return;
+    }
+    for (uint32_t i = 0; i < MODEL_BURST_LENGTH; i++)
+    {
+        model.preload[i] = model.burst_buf[model.length - model.ndtr];
+        model.ndtr--;
+    }
+    if (model.ndtr == 0)
+    {
+        if (model.circular)
+        {
+            model.ndtr = model.length;
+        }
+        else
+        {
+            model.enabled = false;
+        }
+    }
+}
+
+/**
+ * @brief Check that the active CCRx registers show a color.
+ *
+ */
+static void _assert_active(rgb_color_t color, uint32_t update)
+{
+    char msg[64];
+    sprintf(msg, "ERROR: Wrong color after update event %u", update);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(_ccr(color.r), model.active[0], msg);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(_ccr(color.g), model.active[2], msg);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(_ccr(color.b), model.active[3], msg);
+}
+
+/**
+ * @brief Check the conversions to and from the perceptual scale.
+ *
+ */
+void test_perceptual_scale(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(0, display_fade_to_perceptual(0));
+    TEST_ASSERT_EQUAL_UINT32(PORT_DISPLAY_RGB_MAX_VALUE, display_fade_to_perceptual(PORT_DISPLAY_RGB_MAX_VALUE));
+    for (uint32_t level = 1; level <= PORT_DISPLAY_RGB_MAX_VALUE; level++)
+    {
+        // The perceived brightness increases with the level, faster at low levels. At high levels a perceptual step is up to 2 levels
+        uint32_t perceptual = display_fade_to_perceptual(level);
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(display_fade_to_perceptual(level - 1), perceptual);
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(level, perceptual);
+        TEST_ASSERT_UINT32_WITHIN(2, level, display_fade_from_perceptual(perceptual));
+    }
+}
+
+/**
+ * @brief Check the frames of a fade: even perceptual steps, monotonic channels and exact final color.
+ *
+ */
+void test_fade_frames(void)
+{
+    rgb_color_t frames[DISPLAY_FADE_MAX_FRAMES];
+    rgb_color_t from = COLOR_BLUE;
+    rgb_color_t to = COLOR_YELLOW;
+
+    uint32_t num_frames = display_fade_build(frames, from, to, 8);
+    TEST_ASSERT_EQUAL_UINT32(8, num_frames);
+    TEST_ASSERT_EQUAL_MEMORY(&to, &frames[num_frames - 1], sizeof(rgb_color_t));
+
+    rgb_color_t prev = from;
+    uint32_t step_b = (display_fade_to_perceptual(from.b) - display_fade_to_perceptual(to.b)) / num_frames;
+    for (uint32_t i = 0; i < num_frames; i++)
+    {
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT8(prev.r, frames[i].r);
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT8(prev.g, frames[i].g);
+        TEST_ASSERT_LESS_THAN_UINT8(prev.b, frames[i].b);
+        // Equal steps in the perceptual scale, up to the rounding
+        uint32_t delta_b = display_fade_to_perceptual(prev.b) - display_fade_to_perceptual(frames[i].b);
+        TEST_ASSERT_UINT32_WITHIN(2, step_b, delta_b);
+        prev = frames[i];
+    }
+
+    // The number of frames is clamped
+    TEST_ASSERT_EQUAL_UINT32(1, display_fade_build(frames, from, to, 0));
+    TEST_ASSERT_EQUAL_MEMORY(&to, &frames[0], sizeof(rgb_color_t));
+    TEST_ASSERT_EQUAL_UINT32(DISPLAY_FADE_MAX_FRAMES, display_fade_build(frames, from, to, 1000));
+    TEST_ASSERT_EQUAL_MEMORY(&to, &frames[DISPLAY_FADE_MAX_FRAMES - 1], sizeof(rgb_color_t));
+}
+
+/**
+ * @brief Check the frames of a pulse: symmetric, dimmest at the middle and continuous when looped.
+ *
+ */
+void test_pulse_frames(void)
+{
+    rgb_color_t frames[DISPLAY_FADE_MAX_FRAMES];
+    rgb_color_t color = COLOR_RED;
+
+    uint32_t num_frames = display_fade_build_pulse(frames, color, 24);
+    TEST_ASSERT_EQUAL_UINT32(24, num_frames);
+    TEST_ASSERT_EQUAL_MEMORY(&color, &frames[0], sizeof(rgb_color_t));
+
+    uint32_t dim = display_fade_from_perceptual(display_fade_to_perceptual(color.r) * DISPLAY_FADE_PULSE_DIM_PERCENT / 100);
+    TEST_ASSERT_EQUAL_UINT8(dim, frames[num_frames / 2].r);
+    for (uint32_t i = 1; i < num_frames; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(0, frames[i].g);
+        TEST_ASSERT_EQUAL_UINT8(0, frames[i].b);
+        TEST_ASSERT_EQUAL_UINT8(frames[num_frames - i].r, frames[i].r);
+        if (i <= num_frames / 2)
+        {
+            TEST_ASSERT_LESS_THAN_UINT8(frames[i - 1].r, frames[i].r);
+        }
+    }
+    // The last frame joins the first one of the next period
+    TEST_ASSERT_LESS_THAN_UINT8(color.r, frames[num_frames - 1].r);
+    TEST_ASSERT_GREATER_THAN_UINT8(frames[num_frames - 2].r, frames[num_frames - 1].r);
+
+    TEST_ASSERT_EQUAL_UINT32(2, display_fade_build_pulse(frames, color, 0));
+    TEST_ASSERT_EQUAL_UINT32(DISPLAY_FADE_MAX_FRAMES, display_fade_build_pulse(frames, color, 1000));
+}
+
+/**
+ * @brief Play a fade in the model: one frame per update event, and the final color is kept when the sequence ends.
+ *
+ */
+void test_model_fade(void)
+{
+    rgb_color_t frames[DISPLAY_FADE_MAX_FRAMES];
+    rgb_color_t from = COLOR_GREEN;
+    rgb_color_t to = COLOR_RED;
+    model.preload[0] = model.active[0] = _ccr(from.r);
+    model.preload[2] = model.active[2] = _ccr(from.g);
+    model.preload[3] = model.active[3] = _ccr(from.b);
+
+    uint32_t num_frames = display_fade_build(frames, from, to, 8);
+    _model_play(frames, num_frames, false);
+
+    // The burst of each update event is applied at the next one, so the period being shown is never cut
+    _model_update_event();
+    _assert_active(from, 0);
+    for (uint32_t i = 0; i < num_frames; i++)
+    {
+        _model_update_event();
+        _assert_active(frames[i], i + 1);
+    }
+    TEST_ASSERT_FALSE_MESSAGE(model.enabled, "ERROR: The stream must stop at the end of a fade");
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        _model_update_event();
+        _assert_active(to, num_frames + 1 + i);
+    }
+}
+
+/**
+ * @brief Play a pulse in the model: the frames repeat with the period of the pulse without any intervention.
+ *
+ */
+void test_model_pulse(void)
+{
+    rgb_color_t frames[DISPLAY_FADE_MAX_FRAMES];
+    uint32_t num_frames = display_fade_build_pulse(frames, COLOR_RED, 24);
+    _model_play(frames, num_frames, true);
+
+    _model_update_event();
+    for (uint32_t i = 0; i < 5 * num_frames; i++)
+    {
+        _model_update_event();
+        _assert_active(frames[i % num_frames], i + 1);
+    }
+    TEST_ASSERT_TRUE_MESSAGE(model.enabled, "ERROR: The stream must keep running during a pulse");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_perceptual_scale);
+    RUN_TEST(test_fade_frames);
+    RUN_TEST(test_pulse_frames);
+    RUN_TEST(test_model_fade);
+    RUN_TEST(test_model_pulse);
+
+    exit(UNITY_END());
+}
@@ -0,0 +1,143 @@
+/**
+ * @file test_measurement_bus.c
+ * @brief Unit test of the publish/subscribe bus of the measurements of the sensors.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+/* System dependent libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW independent libraries */
+#include "measurement_bus.h"
+
+/* Private variables ---------------------------------------------------------*/
+/**
+ * @brief Records received by a test subscriber.
+ *
+ */
+typedef struct
+{
+    uint32_t count;                         /*!< Number of records received */
+    const measurement_record_t *p_last;     /*!< Last record received */
+} test_subscriber_t;
+
+static test_subscriber_t subscriber_a; /*!< First test subscriber */
+static test_subscriber_t subscriber_b; /*!< Second test subscriber */
+
+/* Private functions ---------------------------------------------------------*/
+void setUp(void)
+{
+    measurement_bus_init();
+    subscriber_a = (test_subscriber_t){0};
+    subscriber_b = (test_subscriber_t){0};
+}
+
+void tearDown(void)
+{
+    // Nothing to do
+}
+
+/**
+ * @brief Callback of the test subscribers.
+ *
+ */
+static void _receive(const measurement_record_t *p_record, void *p_context)
+{
+    test_subscriber_t *p_sub = (test_subscriber_t *)p_context;
+    p_sub->count++;
+    p_sub->p_last = p_record;
+}
+
+/**
+ * @brief Check that every subscriber receives the records of its sensors, by reference.
+ *
+ */
+void test_sensor_filter(void)
+{
+    measurement_bus_filter_t all = {.sensor_mask = MEASUREMENT_BUS_ALL_SENSORS};
+    measurement_bus_filter_t only_1 = {.sensor_mask = 1U << 1};
+    TEST_ASSERT_EQUAL_INT32(0, measurement_bus_subscribe(&all, _receive, &subscriber_a));
+    TEST_ASSERT_EQUAL_INT32(1, measurement_bus_subscribe(&only_1, _receive, &subscriber_b));
+
+    measurement_record_t record_0 = {.sensor_id = 0, .distance_cm = 50};
+    measurement_record_t record_1 = {.sensor_id = 1, .distance_cm = 80};
+    TEST_ASSERT_EQUAL_UINT32(1, measurement_bus_publish(&record_0));
+    TEST_ASSERT_EQUAL_UINT32(2, measurement_bus_publish(&record_1));
+
+    TEST_ASSERT_EQUAL_UINT32(2, subscriber_a.count);
+    TEST_ASSERT_EQUAL_UINT32(1, subscriber_b.count);
+    TEST_ASSERT_TRUE_MESSAGE(subscriber_b.p_last == &record_1, "ERROR: The record should be passed by reference, without copies");
+
+    // A sensor ID out of the bus is never delivered
+    measurement_record_t record_out = {.sensor_id = MEASUREMENT_BUS_MAX_SENSORS};
+    TEST_ASSERT_EQUAL_UINT32(0, measurement_bus_publish(&record_out));
+}
+
+/**
+ * @brief Check the minimum change of distance and the rate limit, per sensor.
+ *
+ */
+void test_change_and_rate_filter(void)
+{
+    measurement_bus_filter_t change = {.sensor_mask = MEASUREMENT_BUS_ALL_SENSORS, .min_change_cm = 5};
+    measurement_bus_filter_t rate = {.sensor_mask = MEASUREMENT_BUS_ALL_SENSORS, .min_period_ms = 100};
+    measurement_bus_subscribe(&change, _receive, &subscriber_a);
+    measurement_bus_subscribe(&rate, _receive, &subscriber_b);
+
+    uint32_t distances[] = {100, 103, 96, 95, 110};
+    uint32_t expected_a[] = {1, 1, 1, 2, 3}; // 100, then 95 (5 from 100), then 110
+    uint32_t expected_b[] = {1, 1, 2, 2, 3}; // 0 ms, then 100 ms and 200 ms
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        measurement_record_t record = {.sensor_id = 0, .distance_cm = distances[i], .timestamp_ms = 50 * i};
+        measurement_bus_publish(&record);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected_a[i], subscriber_a.count, "ERROR: Wrong records delivered with a minimum change");
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected_b[i], subscriber_b.count, "ERROR: Wrong records delivered with a rate limit");
+    }
+
+    // The first record of another sensor is always delivered
+    measurement_record_t record = {.sensor_id = 3, .distance_cm = 110, .timestamp_ms = 210};
+    measurement_bus_publish(&record);
+    TEST_ASSERT_EQUAL_UINT32(4, subscriber_a.count);
+    TEST_ASSERT_EQUAL_UINT32(4, subscriber_b.count);
+}
+
+/**
+ * @brief Check the capacity of the bus and the cancellation of the subscriptions.
+ *
+ */
+void test_subscribe_unsubscribe(void)
+{
+    measurement_bus_filter_t all = {.sensor_mask = MEASUREMENT_BUS_ALL_SENSORS};
+    for (int32_t i = 0; i < MEASUREMENT_BUS_MAX_SUBSCRIBERS; i++)
+    {
+        TEST_ASSERT_EQUAL_INT32(i, measurement_bus_subscribe(&all, _receive, &subscriber_a));
+    }
+    TEST_ASSERT_EQUAL_INT32_MESSAGE(-1, measurement_bus_subscribe(&all, _receive, &subscriber_b), "ERROR: The bus should be full");
+
+    measurement_record_t record = {.sensor_id = 0, .distance_cm = 50};
+    TEST_ASSERT_EQUAL_UINT32(MEASUREMENT_BUS_MAX_SUBSCRIBERS, measurement_bus_publish(&record));
+
+    // A freed slot is reused, without the state of the old subscriber
+    measurement_bus_unsubscribe(2);
+    TEST_ASSERT_EQUAL_UINT32(MEASUREMENT_BUS_MAX_SUBSCRIBERS - 1, measurement_bus_publish(&record));
+    measurement_bus_filter_t change = {.sensor_mask = MEASUREMENT_BUS_ALL_SENSORS, .min_change_cm = 10};
+    TEST_ASSERT_EQUAL_INT32(2, measurement_bus_subscribe(&change, _receive, &subscriber_b));
+    measurement_bus_publish(&record);
+    TEST_ASSERT_EQUAL_UINT32(1, subscriber_b.count);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_sensor_filter);
+    RUN_TEST(test_change_and_rate_filter);
+    RUN_TEST(test_subscribe_unsubscribe);
+
+    exit(UNITY_END());
+}
@@ -0,0 +1,107 @@
+/**
+ * @file test_median_filter.c
+ * @brief Unit test of the median selection kernels.
+ *
+ * The reference is the previous implementation of the ultrasound FSM, which sorted a copy of the window with `qsort()` and took the middle element (see `median_filter_reference.h`). The cost of both is compared by `bench_median_filter.c`.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+/* System dependent libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW independent libraries */
+#include "median_filter.h"
+#include "median_filter_reference.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define MAX_SIZE MEDIAN_FILTER_REFERENCE_MAX_SIZE /*!< Maximum size of the arrays to test */
+#define NUM_RANDOM_TESTS 2000                     /*!< Number of random arrays to test for each size */
+
+/* Private functions ---------------------------------------------------------*/
+void setUp(void)
+{
+    srand(1234);
+}
+
+void tearDown(void)
+{
+    // Nothing to do
+}
+
+/**
+ * @brief Check all the binary inputs of a size (0-1 principle): if a network selects the median of every array of 0s and 1s, it selects the median of any array.
+ *
+ */
+static void _test_network_binary(uint32_t n)
+{
+    char msg[100];
+    for (uint32_t bits = 0; bits < (1U << n); bits++)
+    {
+        uint32_t values[MAX_SIZE];
+        uint32_t ones = 0;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            values[i] = (bits >> i) & 1U;
+            ones += values[i];
+        }
+        uint32_t expected = (ones > n / 2) ? 1 : 0;
+        sprintf(msg, "ERROR: Wrong median of %u binary values (input 0x%x)", (unsigned)n, (unsigned)bits);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected, median_filter_select(values, n), msg);
+    }
+}
+
+void test_networks_binary(void)
+{
+    _test_network_binary(3);
+    _test_network_binary(5);
+    _test_network_binary(7);
+    _test_network_binary(9);
+}
+
+void test_random_against_qsort(void)
+{
+    char msg[100];
+    for (uint32_t n = 1; n <= MAX_SIZE; n++)
+    {
+        for (uint32_t t = 0; t < NUM_RANDOM_TESTS; t++)
+        {
+            uint32_t values[MAX_SIZE];
+            for (uint32_t i = 0; i < n; i++)
+            {
+                // Small range to force repeated values, and some values near the top of the range to check there are no overflows
+                values[i] = (t % 2) ? (uint32_t)(rand() % 8) : (0xFFFFFFFFU - (uint32_t)(rand() % 8));
+            }
+            uint32_t expected = median_filter_reference_select(values, n);
+            sprintf(msg, "ERROR: Wrong median of %u random values", (unsigned)n);
+            TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected, median_filter_select(values, n), msg);
+        }
+    }
+}
+
+void test_quickselect_all_ranks(void)
+{
+    uint32_t values[MAX_SIZE];
+    for (uint32_t k = 0; k < MAX_SIZE; k++)
+    {
+        for (uint32_t i = 0; i < MAX_SIZE; i++)
+        {
+            values[i] = MAX_SIZE - 1 - i; // Reverse order: rank k is the value k
+        }
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(k, median_filter_quickselect(values, MAX_SIZE, k), "ERROR: Wrong element selected by quickselect");
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_networks_binary);
+    RUN_TEST(test_random_against_qsort);
+    RUN_TEST(test_quickselect_all_ranks);
+
+    exit(UNITY_END());
+}
@@ -0,0 +1,203 @@
+/**
+ * @file test_output_conditioner.c
+ * @brief Unit test of the conditioning of the distances shown by the outputs.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+/* System dependent libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW independent libraries */
+#include "output_conditioner.h"
+
+/* Private variables ---------------------------------------------------------*/
+/**
+ * @brief Boundaries of the tests: zones 0-5, 6-25, 26-50 and 51 cm onwards.
+ *
+ */
+static const output_conditioner_boundary_t boundaries_arr[] = {
+    {.max_cm = 5, .hysteresis_cm = 1},
+    {.max_cm = 25, .hysteresis_cm = 2},
+    {.max_cm = 50, .hysteresis_cm = 3},
+};
+
+static output_conditioner_t cond; /*!< Conditioner under test */
+
+/* Private functions ---------------------------------------------------------*/
+void setUp(void)
+{
+    output_conditioner_init(&cond, boundaries_arr, sizeof(boundaries_arr) / sizeof(boundaries_arr[0]), 0, 0);
+}
+
+void tearDown(void)
+{
+    // Nothing to do
+}
+
+/**
+ * @brief Check the validation of the configuration and the conditioner without boundaries.
+ *
+ */
+void test_config(void)
+{
+    output_conditioner_boundary_t unsorted[] = {{.max_cm = 25}, {.max_cm = 5}};
+    TEST_ASSERT_FALSE(output_conditioner_init(&cond, unsorted, 2, 0, 0));
+    TEST_ASSERT_FALSE(output_conditioner_init(&cond, boundaries_arr, OUTPUT_CONDITIONER_MAX_BOUNDARIES + 1, 0, 0));
+
+    // Without boundaries, deadband nor hold time the distances are not changed
+    TEST_ASSERT_TRUE(output_conditioner_init(&cond, NULL, 0, 0, 0));
+    for (uint32_t d = 0; d < 400; d += 7)
+    {
+        TEST_ASSERT_EQUAL_UINT32(d, output_conditioner_update(&cond, d, d));
+    }
+}
+
+/**
+ * @brief A distance that dithers around a boundary, inside its hysteresis, does not change the zone.
+ *
+ */
+void test_hysteresis(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(24, output_conditioner_update(&cond, 24, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, output_conditioner_get_zone(&cond));
+
+    // Up to the boundary plus its hysteresis, the distance is kept at the edge of the zone
+    uint32_t dither_arr[] = {25, 26, 27, 25, 26, 27, 24, 27};
+    for (uint32_t i = 0; i < sizeof(dither_arr) / sizeof(dither_arr[0]); i++)
+    {
+        uint32_t expected = (dither_arr[i] > 25) ? 25 : dither_arr[i];
+        TEST_ASSERT_EQUAL_UINT32(expected, output_conditioner_update(&cond, dither_arr[i], 0));
+        TEST_ASSERT_EQUAL_UINT32(1, output_conditioner_get_zone(&cond));
+    }
+
+    // Past the hysteresis the zone changes. The way back to the closer zone only needs to cross the boundary
+    TEST_ASSERT_EQUAL_UINT32(28, output_conditioner_update(&cond, 28, 0));
+    TEST_ASSERT_EQUAL_UINT32(2, output_conditioner_get_zone(&cond));
+    TEST_ASSERT_EQUAL_UINT32(26, output_conditioner_update(&cond, 26, 0));
+    TEST_ASSERT_EQUAL_UINT32(2, output_conditioner_get_zone(&cond));
+    TEST_ASSERT_EQUAL_UINT32(25, output_conditioner_update(&cond, 25, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, output_conditioner_get_zone(&cond));
+
+    // And the way to the farther zone needs to go past the hysteresis again
+    TEST_ASSERT_EQUAL_UINT32(25, output_conditioner_update(&cond, 27, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, output_conditioner_get_zone(&cond));
+
+    // Several zones can be crossed at once
+    TEST_ASSERT_EQUAL_UINT32(100, output_conditioner_update(&cond, 100, 0));
+    TEST_ASSERT_EQUAL_UINT32(3, output_conditioner_get_zone(&cond));
+    TEST_ASSERT_EQUAL_UINT32(0, output_conditioner_update(&cond, 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, output_conditioner_get_zone(&cond));
+}
+
+/**
+ * @brief A zone is kept for the hold time, even if the distance clearly leaves it.
+ *
+ */
+void test_hold_time(void)
+{
+    output_conditioner_init(&cond, boundaries_arr, sizeof(boundaries_arr) / sizeof(boundaries_arr[0]), 0, 100);
+    TEST_ASSERT_EQUAL_UINT32(10, output_conditioner_update(&cond, 10, 1000));
+    TEST_ASSERT_EQUAL_UINT32(25, output_conditioner_update(&cond, 40, 1050));
+    TEST_ASSERT_EQUAL_UINT32(1, output_conditioner_get_zone(&cond));
+    TEST_ASSERT_EQUAL_UINT32(40, output_conditioner_update(&cond, 40, 1100));
+    TEST_ASSERT_EQUAL_UINT32(2, output_conditioner_get_zone(&cond));
+
+    // The changes inside a zone are not held
+    TEST_ASSERT_EQUAL_UINT32(45, output_conditioner_update(&cond, 45, 1101));
+
+    // After a reset, the first distance is returned as it is
+    output_conditioner_reset(&cond);
+    TEST_ASSERT_EQUAL_UINT32(3, output_conditioner_update(&cond, 3, 1102));
+    TEST_ASSERT_EQUAL_UINT32(0, output_conditioner_get_zone(&cond));
+}
+
+/**
+ * @brief An obstacle that gets closer is shown at once: the hold time only delays the changes to a farther zone.
+ *
+ */
+void test_approach_in_hold_time(void)
+{
+    output_conditioner_init(&cond, boundaries_arr, sizeof(boundaries_arr) / sizeof(boundaries_arr[0]), 0, 100);
+    TEST_ASSERT_EQUAL_UINT32(40, output_conditioner_update(&cond, 40, 1000));
+    TEST_ASSERT_EQUAL_UINT32(2, output_conditioner_get_zone(&cond));
+
+    // Through one boundary and then another one, inside the hold time of each zone
+    TEST_ASSERT_EQUAL_UINT32(20, output_conditioner_update(&cond, 20, 1010));
+    TEST_ASSERT_EQUAL_UINT32(1, output_conditioner_get_zone(&cond));
+    TEST_ASSERT_EQUAL_UINT32(5, output_conditioner_update(&cond, 5, 1020));
+    TEST_ASSERT_EQUAL_UINT32(0, output_conditioner_get_zone(&cond));
+
+    // Going away again is held from the time the closest zone was entered
+    TEST_ASSERT_EQUAL_UINT32(5, output_conditioner_update(&cond, 20, 1110));
+    TEST_ASSERT_EQUAL_UINT32(0, output_conditioner_get_zone(&cond));
+    TEST_ASSERT_EQUAL_UINT32(20, output_conditioner_update(&cond, 20, 1120));
+    TEST_ASSERT_EQUAL_UINT32(1, output_conditioner_get_zone(&cond));
+}
+
+/**
+ * @brief Small changes inside a zone are ignored, but a change of zone is always shown.
+ *
+ */
+void test_deadband(void)
+{
+    output_conditioner_init(&cond, boundaries_arr, sizeof(boundaries_arr) / sizeof(boundaries_arr[0]), 2, 0);
+    TEST_ASSERT_EQUAL_UINT32(15, output_conditioner_update(&cond, 15, 0));
+    TEST_ASSERT_EQUAL_UINT32(15, output_conditioner_update(&cond, 17, 0));
+    TEST_ASSERT_EQUAL_UINT32(15, output_conditioner_update(&cond, 13, 0));
+    TEST_ASSERT_EQUAL_UINT32(18, output_conditioner_update(&cond, 18, 0));
+    TEST_ASSERT_EQUAL_UINT32(4, output_conditioner_update(&cond, 4, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, output_conditioner_get_zone(&cond));
+}
+
+/**
+ * @brief Count the updates of an output for a distance with noise around a boundary, with and without conditioning.
+ *
+ */
+void test_noisy_boundary(void)
+{
+    output_conditioner_t raw;
+    output_conditioner_init(&raw, NULL, 0, 0, 0);
+    output_conditioner_init(&cond, boundaries_arr, sizeof(boundaries_arr) / sizeof(boundaries_arr[0]), 2, 150);
+
+    srand(1234);
+    uint32_t raw_updates = 0;
+    uint32_t cond_updates = 0;
+    uint32_t raw_last = output_conditioner_update(&raw, 25, 0);
+    uint32_t cond_last = output_conditioner_update(&cond, 25, 0);
+    for (uint32_t t_ms = 1; t_ms <= 10000; t_ms++)
+    {
+        // A measurement every 10 ms of an obstacle at the boundary, with a noise of +-2 cm
+        if (t_ms % 10 != 0)
+        {
+            continue;
+        }
+        uint32_t distance = 23 + (uint32_t)(rand() % 5);
+        uint32_t out = output_conditioner_update(&raw, distance, t_ms);
+        raw_updates += (out != raw_last);
+        raw_last = out;
+        out = output_conditioner_update(&cond, distance, t_ms);
+        cond_updates += (out != cond_last);
+        cond_last = out;
+        TEST_ASSERT_EQUAL_UINT32(1, output_conditioner_get_zone(&cond));
+    }
+    printf("Updates of an output with noise around a boundary: %u without conditioning, %u with conditioning\n", raw_updates, cond_updates);
+    TEST_ASSERT_LESS_THAN_UINT32_MESSAGE(raw_updates / 4, cond_updates, "ERROR: The conditioning should remove most of the updates");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_config);
+    RUN_TEST(test_hysteresis);
+    RUN_TEST(test_hold_time);
+    RUN_TEST(test_approach_in_hold_time);
+    RUN_TEST(test_deadband);
+    RUN_TEST(test_noisy_boundary);
+
+    exit(UNITY_END());
+}
@@ -0,0 +1,188 @@
+/**
+ * @file test_port_event_queue.c
+ * @brief Host tests of the lock-free queue that passes the events of the interrupts to the FSMs.
+ *
+ * The stress test runs the producer (the interrupt) in a thread and the consumer (the main loop) in the main thread. Every event carries its sequence number, so a lost, repeated, reordered or torn event is detected as soon as it is popped.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+/* System dependent libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unity.h>
+
+/* HW independent libraries */
+#include "port_event_queue.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define NUM_EVENTS 20000000 /*!< Number of events pushed by the stress test */
+#define YIELD_PERIOD 256    /*!< The consumer lets the producer run before one pop out of `YIELD_PERIOD`, like an interrupt that preempts the main loop */
+
+/* Private variables ---------------------------------------------------------*/
+static port_event_queue_t queue; /*!< Queue shared between the producer thread and the consumer */
+
+/* Private functions ---------------------------------------------------------*/
+void setUp(void)
+{
+    port_event_queue_init(&queue);
+}
+
+void tearDown(void)
+{
+    // Nothing to do
+}
+
+/**
+ * @brief Simulated interrupt. Event `n` is `{timestamp_ms = ~n, data = n, type = n % 256}`. The producer waits while the queue is full, so no event is lost.
+ *
+ */
+static void *_producer_thread(void *p_arg)
+{
+    for (uint32_t n = 1; n <= NUM_EVENTS; n++)
+    {
+        while (!port_event_queue_push(&queue, (uint8_t)n, n, ~n))
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Check that the events are popped in the order they were pushed, with all their fields.
+ *
+ */
+void test_fifo_order(void)
+{
+    port_event_t event;
+    TEST_ASSERT_FALSE_MESSAGE(port_event_queue_pop(&queue, &event), "ERROR: A new queue should be empty");
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        TEST_ASSERT_TRUE(port_event_queue_push(&queue, i, 100 + i, 1000 + i));
+    }
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        // Peeking does not consume the event
+        TEST_ASSERT_TRUE(port_event_queue_peek(&queue, &event));
+        TEST_ASSERT_EQUAL_UINT32(1000 + i, event.timestamp_ms);
+        TEST_ASSERT_TRUE(port_event_queue_pop(&queue, &event));
+        TEST_ASSERT_EQUAL_UINT32(i, event.type);
+        TEST_ASSERT_EQUAL_UINT32(100 + i, event.data);
+        TEST_ASSERT_EQUAL_UINT32(1000 + i, event.timestamp_ms);
+    }
+    TEST_ASSERT_FALSE_MESSAGE(port_event_queue_pop(&queue, &event), "ERROR: The queue should be empty after popping all the events");
+    TEST_ASSERT_FALSE(port_event_queue_peek(&queue, &event));
+    TEST_ASSERT_EQUAL_UINT32(3, port_event_queue_get_count(&queue));
+    TEST_ASSERT_EQUAL_UINT32(0, port_event_queue_get_overflows(&queue));
+}
+
+/**
+ * @brief Check that the events pushed to a full queue are lost and counted, and that the queued events are kept.
+ *
+ */
+void test_overflow(void)
+{
+    port_event_t event;
+    for (uint32_t i = 0; i < PORT_EVENT_QUEUE_SIZE + 3; i++)
+    {
+        bool pushed = port_event_queue_push(&queue, 0, i, 0);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(i < PORT_EVENT_QUEUE_SIZE, pushed, "ERROR: Only PORT_EVENT_QUEUE_SIZE events fit in the queue");
+    }
+    TEST_ASSERT_EQUAL_UINT32(PORT_EVENT_QUEUE_SIZE, port_event_queue_get_count(&queue));
+    TEST_ASSERT_EQUAL_UINT32(3, port_event_queue_get_overflows(&queue));
+
+    // The oldest events are kept
+    TEST_ASSERT_TRUE(port_event_queue_pop(&queue, &event));
+    TEST_ASSERT_EQUAL_UINT32(0, event.data);
+
+    // A popped event frees room for a new one
+    TEST_ASSERT_TRUE(port_event_queue_push(&queue, 0, 1000, 0));
+    for (uint32_t i = 1; i < PORT_EVENT_QUEUE_SIZE; i++)
+    {
+        TEST_ASSERT_TRUE(port_event_queue_pop(&queue, &event));
+        TEST_ASSERT_EQUAL_UINT32(i, event.data);
+    }
+    TEST_ASSERT_TRUE(port_event_queue_pop(&queue, &event));
+    TEST_ASSERT_EQUAL_UINT32(1000, event.data);
+}
+
+/**
+ * @brief Check that the queue keeps working when its counters wrap around.
+ *
+ */
+void test_counter_wrap_around(void)
+{
+    atomic_store(&queue.head, UINT32_MAX - 2);
+    atomic_store(&queue.tail, UINT32_MAX - 2);
+
+    port_event_t event;
+    for (uint32_t i = 0; i < PORT_EVENT_QUEUE_SIZE; i++)
+    {
+        TEST_ASSERT_TRUE(port_event_queue_push(&queue, 0, i, 0));
+    }
+    TEST_ASSERT_FALSE_MESSAGE(port_event_queue_push(&queue, 0, 0, 0), "ERROR: The queue should be full across the wrap around");
+    for (uint32_t i = 0; i < PORT_EVENT_QUEUE_SIZE; i++)
+    {
+        TEST_ASSERT_TRUE(port_event_queue_pop(&queue, &event));
+        TEST_ASSERT_EQUAL_UINT32(i, event.data);
+    }
+    TEST_ASSERT_FALSE(port_event_queue_pop(&queue, &event));
+}
+
+/**
+ * @brief Push events from a producer thread and check that the consumer pops every event once, in order and complete.
+ *
+ */
+void test_stress_spsc(void)
+{
+    pthread_t producer;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&producer, NULL, _producer_thread, NULL));
+
+    uint32_t expected = 1;
+    uint32_t errors = 0;
+    uint32_t pops = 0;
+    port_event_t event;
+    while (expected <= NUM_EVENTS)
+    {
+        if ((pops % YIELD_PERIOD) == 0)
+        {
+            sched_yield();
+        }
+        if (!port_event_queue_pop(&queue, &event))
+        {
+            // Empty queue: let the producer run
+            sched_yield();
+            continue;
+        }
+        if ((event.data != expected) || (event.type != (uint8_t)expected) || (event.timestamp_ms != ~expected))
+        {
+            errors++;
+        }
+        expected = event.data + 1;
+        pops++;
+    }
+    pthread_join(producer, NULL);
+
+    printf("%u events popped, the producer found the queue full %u times\n", pops, port_event_queue_get_overflows(&queue));
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, errors, "ERROR: Some events were lost, repeated, reordered or torn");
+    TEST_ASSERT_EQUAL_UINT32(NUM_EVENTS, pops);
+    TEST_ASSERT_FALSE_MESSAGE(port_event_queue_pop(&queue, &event), "ERROR: No event should be left in the queue");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_fifo_order);
+    RUN_TEST(test_overflow);
+    RUN_TEST(test_counter_wrap_around);
+    RUN_TEST(test_stress_spsc);
+
+    exit(UNITY_END());
+}
@@ -0,0 +1,209 @@
+/**
+ * @file test_ultrasound_scheduler.c
+ * @brief Unit test and host simulation of the time-division scheduler of ultrasound sensors.
+ *
+ * The simulation triggers 2 to 8 sensors along a bumper with obstacles at random distances, checks that neighbouring sensors never measure at the same time and that the guard interval is respected, and prints the measurement rates achieved.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+/* System dependent libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW independent libraries */
+#include "ultrasound_scheduler.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIM_TIME_MS 10000       /*!< Duration of each simulation */
+#define SIM_GUARD_MS 10         /*!< Guard interval of the simulations */
+#define SIM_MIN_DISTANCE_CM 20  /*!< Minimum distance of the simulated obstacles */
+#define SIM_MAX_DISTANCE_CM 400 /*!< Maximum distance of the simulated obstacles (HC-SR04 range) */
+#define SIM_US_PER_CM 58        /*!< Duration of the echo signal per cm of distance */
+#define SIM_LOST_ECHO_MS 30     /*!< Duration of a measurement whose echo signal is lost */
+#define SIM_LOST_ECHO_PERCENT 5 /*!< Percentage of lost echoes */
+#define SIM_LATENCY_MS 1        /*!< Time from the trigger request to the trigger signal, and from the echo end to its processing */
+
+/* Private functions ---------------------------------------------------------*/
+void setUp(void)
+{
+    srand(1234);
+}
+
+void tearDown(void)
+{
+    // Nothing to do
+}
+
+/**
+ * @brief Duration in ms of a simulated measurement, from its request until its echo signal has been processed.
+ *
+ */
+static uint32_t _measurement_duration_ms(void)
+{
+    if ((rand() % 100) < SIM_LOST_ECHO_PERCENT)
+    {
+        return SIM_LOST_ECHO_MS + SIM_LATENCY_MS;
+    }
+    uint32_t distance = SIM_MIN_DISTANCE_CM + (uint32_t)(rand() % (SIM_MAX_DISTANCE_CM - SIM_MIN_DISTANCE_CM));
+    return (distance * SIM_US_PER_CM + 999) / 1000 + 2 * SIM_LATENCY_MS;
+}
+
+/**
+ * @brief Simulate a scheduler for `SIM_TIME_MS` and check its rules every ms.
+ *
+ * @return uint32_t Aggregate rate in mHz.
+ */
+static uint32_t _simulate(uint32_t num_sensors, uint32_t num_groups, uint32_t min_distance)
+{
+    char msg[120];
+    ultrasound_scheduler_t sched;
+    uint32_t busy_until[ULTRASOUND_SCHEDULER_MAX_SENSORS] = {0};
+    uint32_t completed[ULTRASOUND_SCHEDULER_MAX_SENSORS] = {0};
+    uint32_t busy_mask = 0;
+    uint32_t last_end_ms = 0;
+    bool any_end = false;
+
+    TEST_ASSERT_TRUE_MESSAGE(ultrasound_scheduler_init(&sched, num_sensors, num_groups, SIM_GUARD_MS, 0), "ERROR: Valid configuration rejected");
+
+    for (uint32_t now = 0; now < SIM_TIME_MS; now++)
+    {
+        // Measurements that end now
+        for (uint32_t s = 0; s < num_sensors; s++)
+        {
+            if ((busy_mask & (1U << s)) && (now >= busy_until[s]))
+            {
+                busy_mask &= ~(1U << s);
+                completed[s]++;
+                last_end_ms = now;
+                any_end = true;
+            }
+        }
+
+        uint32_t fire_mask = ultrasound_scheduler_update(&sched, now, busy_mask);
+        if (fire_mask == 0)
+        {
+            continue;
+        }
+        sprintf(msg, "ERROR: %u sensors: a busy sensor has been triggered at %u ms", (unsigned)num_sensors, (unsigned)now);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, fire_mask & busy_mask, msg);
+        sprintf(msg, "ERROR: %u sensors: guard interval not respected at %u ms", (unsigned)num_sensors, (unsigned)now);
+        TEST_ASSERT_TRUE_MESSAGE(!any_end || ((now - last_end_ms) >= SIM_GUARD_MS), msg);
+        for (uint32_t s = 0; s < num_sensors; s++)
+        {
+            if (fire_mask & (1U << s))
+            {
+                busy_until[s] = now + _measurement_duration_ms();
+                busy_mask |= 1U << s;
+            }
+        }
+        // Sensors closer than min_distance positions never measure at the same time
+        for (uint32_t s = 0; s < num_sensors; s++)
+        {
+            for (uint32_t d = 1; (d < min_distance) && ((s + d) < num_sensors); d++)
+            {
+                sprintf(msg, "ERROR: %u sensors: sensors %u and %u measure at the same time", (unsigned)num_sensors, (unsigned)s, (unsigned)(s + d));
+                TEST_ASSERT_FALSE_MESSAGE((busy_mask & (1U << s)) && (busy_mask & (1U << (s + d))), msg);
+            }
+        }
+    }
+
+    uint32_t min_rate_mhz = UINT32_MAX;
+    uint32_t max_interval_ms = 0;
+    for (uint32_t s = 0; s < num_sensors; s++)
+    {
+        ultrasound_scheduler_stats_t stats;
+        ultrasound_scheduler_get_stats(&sched, s, SIM_TIME_MS, &stats);
+        sprintf(msg, "ERROR: %u sensors: wrong number of measurements of sensor %u", (unsigned)num_sensors, (unsigned)s);
+        // The measurement in progress at the end of the simulation has not been counted yet by the scheduler
+        TEST_ASSERT_UINT32_WITHIN_MESSAGE(1, completed[s], stats.measurements, msg);
+        TEST_ASSERT_NOT_EQUAL_MESSAGE(0, stats.measurements, msg);
+        min_rate_mhz = (stats.rate_mhz < min_rate_mhz) ? stats.rate_mhz : min_rate_mhz;
+        max_interval_ms = (stats.max_interval_ms > max_interval_ms) ? stats.max_interval_ms : max_interval_ms;
+    }
+    uint32_t total_rate_mhz = ultrasound_scheduler_get_total_rate_mhz(&sched, SIM_TIME_MS);
+    printf("[SIM] %u sensors, %u groups: %.1f measurements/s in total, %.1f measurements/s per sensor (minimum), %u ms between measurements (maximum)\n", (unsigned)num_sensors, (unsigned)num_groups, total_rate_mhz / 1000.0, min_rate_mhz / 1000.0, (unsigned)max_interval_ms);
+    return total_rate_mhz;
+}
+
+void test_init_rejects_invalid_configurations(void)
+{
+    ultrasound_scheduler_t sched;
+    TEST_ASSERT_FALSE_MESSAGE(ultrasound_scheduler_init(&sched, 0, 1, SIM_GUARD_MS, 0), "ERROR: No sensors accepted");
+    TEST_ASSERT_FALSE_MESSAGE(ultrasound_scheduler_init(&sched, ULTRASOUND_SCHEDULER_MAX_SENSORS + 1, 2, SIM_GUARD_MS, 0), "ERROR: Too many sensors accepted");
+    TEST_ASSERT_FALSE_MESSAGE(ultrasound_scheduler_init(&sched, 3, 1, SIM_GUARD_MS, 0), "ERROR: Neighbouring sensors in the same group accepted");
+    TEST_ASSERT_FALSE_MESSAGE(ultrasound_scheduler_init(&sched, 3, 4, SIM_GUARD_MS, 0), "ERROR: Empty groups accepted");
+    TEST_ASSERT_TRUE_MESSAGE(ultrasound_scheduler_init(&sched, 1, 1, SIM_GUARD_MS, 0), "ERROR: Single sensor rejected");
+}
+
+void test_set_groups(void)
+{
+    ultrasound_scheduler_t sched;
+    TEST_ASSERT_TRUE(ultrasound_scheduler_init(&sched, 5, 2, SIM_GUARD_MS, 0));
+
+    const uint32_t neighbours[] = {0x05, 0x18, 0x02};   // Sensors 3 and 4 together
+    const uint32_t overlap[] = {0x05, 0x0A, 0x11};      // Sensor 0 twice
+    const uint32_t missing[] = {0x05, 0x0A};            // Sensor 4 in no group
+    const uint32_t valid[] = {0x09, 0x12, 0x04};        // {0, 3}, {1, 4}, {2}
+    TEST_ASSERT_FALSE_MESSAGE(ultrasound_scheduler_set_groups(&sched, neighbours, 3), "ERROR: Neighbouring sensors in the same group accepted");
+    TEST_ASSERT_FALSE_MESSAGE(ultrasound_scheduler_set_groups(&sched, overlap, 3), "ERROR: Sensor in two groups accepted");
+    TEST_ASSERT_FALSE_MESSAGE(ultrasound_scheduler_set_groups(&sched, missing, 2), "ERROR: Sensor without group accepted");
+    TEST_ASSERT_TRUE_MESSAGE(ultrasound_scheduler_set_groups(&sched, valid, 3), "ERROR: Valid groups rejected");
+
+    // The groups are triggered in order, each one after the previous has finished and the guard interval has elapsed
+    TEST_ASSERT_EQUAL_UINT32(0x09, ultrasound_scheduler_update(&sched, 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, ultrasound_scheduler_update(&sched, 5, 0x09));
+    TEST_ASSERT_EQUAL_UINT32(0, ultrasound_scheduler_update(&sched, 20, 0x01));
+    TEST_ASSERT_EQUAL_UINT32(0, ultrasound_scheduler_update(&sched, 25, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, ultrasound_scheduler_update(&sched, 25 + SIM_GUARD_MS - 1, 0));
+    TEST_ASSERT_EQUAL_UINT32(0x12, ultrasound_scheduler_update(&sched, 25 + SIM_GUARD_MS, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, ultrasound_scheduler_update(&sched, 50, 0));
+    TEST_ASSERT_EQUAL_UINT32(0x04, ultrasound_scheduler_update(&sched, 50 + SIM_GUARD_MS, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, ultrasound_scheduler_update(&sched, 70, 0));
+    TEST_ASSERT_EQUAL_UINT32(0x09, ultrasound_scheduler_update(&sched, 70 + SIM_GUARD_MS, 0));
+}
+
+void test_disabled_sensors_are_skipped(void)
+{
+    ultrasound_scheduler_t sched;
+    TEST_ASSERT_TRUE(ultrasound_scheduler_init(&sched, 6, 3, SIM_GUARD_MS, 0)); // {0, 3}, {1, 4}, {2, 5}
+    ultrasound_scheduler_set_enabled(&sched, 0x21);                              // Sensors 0 and 5
+
+    TEST_ASSERT_EQUAL_UINT32(0x01, ultrasound_scheduler_update(&sched, 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, ultrasound_scheduler_update(&sched, 10, 0));
+    // The second group has no enabled sensors, so the third one is triggered right after the guard interval
+    TEST_ASSERT_EQUAL_UINT32(0x20, ultrasound_scheduler_update(&sched, 10 + SIM_GUARD_MS, 0));
+}
+
+void test_simulation_scaling(void)
+{
+    uint32_t rate_2 = 0;
+    uint32_t rate_8 = 0;
+    for (uint32_t n = 2; n <= ULTRASOUND_SCHEDULER_MAX_SENSORS; n++)
+    {
+        uint32_t rate_sequential = _simulate(n, n, n);
+        uint32_t rate = _simulate(n, 2, 2);
+        if (n > 2)
+        {
+            TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE(rate_sequential, rate, "ERROR: Interleaved groups slower than one sensor at a time");
+        }
+        rate_2 = (n == 2) ? rate : rate_2;
+        rate_8 = (n == ULTRASOUND_SCHEDULER_MAX_SENSORS) ? rate : rate_8;
+    }
+    // 8 sensors fire 4 at a time, while 2 sensors fire 1 at a time
+    TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE(2 * rate_2, rate_8, "ERROR: The aggregate rate does not scale with the number of sensors");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_init_rejects_invalid_configurations);
+    RUN_TEST(test_set_groups);
+    RUN_TEST(test_disabled_sensors_are_skipped);
+    RUN_TEST(test_simulation_scaling);
+
+    exit(UNITY_END());
+}
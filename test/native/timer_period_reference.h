@@ -0,0 +1,40 @@
+/**
+ * @file timer_period_reference.h
+ * @brief Previous computation of the prescaler and the auto-reload values of a timer, with `double` and `round()`. It is the reference of `port_timer_period.h`.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+#ifndef TIMER_PERIOD_REFERENCE_H_
+#define TIMER_PERIOD_REFERENCE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <math.h>
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Previous computation of PSC and ARR, as `port_buzzer_set_sound()` did it in every call, with the period in seconds.
+ *
+ * @param reloj Frequency in Hz of the clock of the timer.
+ * @param periodo Period in s.
+ * @param p_psc Pointer where the value of PSC is stored.
+ * @param p_arr Pointer where the value of ARR is stored.
+ */
+static inline void timer_period_reference_solve(double reloj, double periodo, uint32_t *p_psc, uint32_t *p_arr)
+{
+    double arr = 65535.0;
+    double psc = round((periodo * reloj / (arr + 1.0)) - 1.0);
+    arr = round((periodo * reloj / (psc + 1.0)) - 1.0);
+    if (arr > 65535.0)
+    {
+        psc += 1.0;
+        arr = round((periodo * reloj / (psc + 1.0)) - 1.0);
+    }
+    *p_psc = (uint32_t)psc;
+    *p_arr = (uint32_t)arr;
+}
+
+#endif /* TIMER_PERIOD_REFERENCE_H_ */
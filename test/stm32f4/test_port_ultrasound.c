@@ -299,9 +299,11 @@ void test_trigger_timer_timeout(void)
     // Disable ULTRASOUND trigger signal interrupts to avoid any interference
     NVIC_DisableIRQ(REAR_TRIGGER_TIMER_IRQ);
 
-    // Check that the trigger_end flag is set
-    bool trigger_end = port_ultrasound_get_trigger_end(PORT_REAR_PARKING_SENSOR_ID);
-    UNITY_TEST_ASSERT_EQUAL_UINT32(true, trigger_end, __LINE__, "ERROR: ULTRASOUND trigger_end flag must be set after the timeout");
+    // Check that the interrupt queued the end of the trigger signal
+    port_event_t event;
+    bool queued = port_ultrasound_pop_event(PORT_REAR_PARKING_SENSOR_ID, &event);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, queued, __LINE__, "ERROR: ULTRASOUND trigger end event must be queued after the timeout");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_ULTRASOUND_EVENT_TRIGGER_END, event.type, __LINE__, "ERROR: ULTRASOUND queued event must be the end of the trigger signal");
 }
 
 /**
@@ -323,9 +325,9 @@ void test_echo_timer_config(void)
     uint32_t tim_echo_rcc = (REAR_ECHO_TIMER_PER_BUS)&REAR_ECHO_TIMER_PER_BUS_MASK;
     UNITY_TEST_ASSERT_EQUAL_UINT32(REAR_ECHO_TIMER_PER_BUS_MASK, tim_echo_rcc, __LINE__, "ERROR: ULTRASOUND timer for echo signal is not enabled in RCC");
 
-    // Check that the ULTRASOUND timer for echo signal is disabled
+    // Check that the ULTRASOUND timer for echo signal is running: it is the free-running timebase of all the sensors
     uint32_t tim_echo_en = (REAR_ECHO_TIMER->CR1) & TIM_CR1_CEN_Msk;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(0, tim_echo_en, __LINE__, "ERROR: ULTRASOUND timer for echo signal must be disabled after configuration");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN_Msk, tim_echo_en, __LINE__, "ERROR: ULTRASOUND timer for echo signal must be running after configuration");
 
     // Check that the ULTRASOUND timer for echo signal channel is configured with the correct capture/compare channel selection
     uint32_t tim_echo_ccmr_ccs = (REAR_ECHO_TIMER->CCMR1) & (0x1 << REAR_ECHO_TIMER_CCMR_CCS_Pos);
@@ -349,20 +351,22 @@ void test_echo_timer_config(void)
 
     // Check that the ULTRASOUND timer for echo signal has enabled the update interrupt
     uint32_t tim_echo_dier_uie = (REAR_ECHO_TIMER->DIER) & TIM_DIER_UIE_Msk;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_DIER_UIE_Msk, tim_echo_dier_uie, __LINE__, "ERROR: ULTRASOUND timer for echo signal must have enabled the update interrupts");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, tim_echo_dier_uie, __LINE__, "ERROR: ULTRASOUND timer for echo signal must not count overflows: the update interrupt must be disabled");
+    uint32_t tim_echo_dier_dma = (REAR_ECHO_TIMER->DIER) & (TIM_DIER_CC1DE_Msk | TIM_DIER_CC2DE_Msk);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_DIER_CC1DE_Msk | TIM_DIER_CC2DE_Msk, tim_echo_dier_dma, __LINE__, "ERROR: ULTRASOUND timer for echo signal must request the DMA on each capture");
 
-    // Check that the interrupts for the input capture channel is enabled
+    // Check that the interrupt for the input capture channel is disabled: the captures are copied by DMA
     uint32_t tim_echo_dier_ccie = (REAR_ECHO_TIMER->DIER) & REAR_ECHO_TIMER_DIER_CCIE;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(REAR_ECHO_TIMER_DIER_CCIE, tim_echo_dier_ccie, __LINE__, "ERROR: ULTRASOUND timer for echo signal must have enabled the interrupt for the input capture channel");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, tim_echo_dier_ccie, __LINE__, "ERROR: ULTRASOUND timer for echo signal must not interrupt on each capture");
 
     // Check that no other bits other than the needed have been modified:
     uint32_t prev_tim_echo_cr1_masked = prev_tim_echo_cr1 & ~TIM_CR1_CEN_Msk;
-    uint32_t prev_tim_echo_dier_masked = prev_tim_echo_dier & ~TIM_DIER_UIE_Msk;
+    uint32_t prev_tim_echo_dier_masked = prev_tim_echo_dier & ~(TIM_DIER_UIE_Msk | TIM_DIER_CC1IE_Msk | TIM_DIER_CC2IE_Msk | TIM_DIER_CC1DE_Msk | TIM_DIER_CC2DE_Msk);
     uint32_t prev_tim_echo_ccmr_masked = prev_tim_echo_ccmr & ~((0x1 << REAR_ECHO_TIMER_CCMR_CCS_Pos) | REAR_ECHO_TIMER_CCMR_ICF | REAR_ECHO_TIMER_CCMR_PSC);
     uint32_t prev_tim_echo_ccer_masked = prev_tim_echo_ccer & ~((0x1 << REAR_ECHO_TIMER_CCER_CCP_Pos) | (0x1 << REAR_ECHO_TIMER_CCER_CCNP_Pos) | (0x1 << REAR_ECHO_TIMER_CCER_CCE));
 
     uint32_t curr_tim_echo_cr1_masked = REAR_ECHO_TIMER->CR1 & ~TIM_CR1_CEN_Msk;
-    uint32_t curr_tim_echo_dier_masked = REAR_ECHO_TIMER->DIER & ~TIM_DIER_UIE_Msk;
+    uint32_t curr_tim_echo_dier_masked = REAR_ECHO_TIMER->DIER & ~(TIM_DIER_UIE_Msk | TIM_DIER_CC1IE_Msk | TIM_DIER_CC2IE_Msk | TIM_DIER_CC1DE_Msk | TIM_DIER_CC2DE_Msk);
     uint32_t curr_tim_echo_ccmr_masked = REAR_ECHO_TIMER->CCMR1 & ~((0x1 << REAR_ECHO_TIMER_CCMR_CCS_Pos) | REAR_ECHO_TIMER_CCMR_ICF | REAR_ECHO_TIMER_CCMR_PSC);
     uint32_t curr_tim_echo_ccer_masked = REAR_ECHO_TIMER->CCER & ~((0x1 << REAR_ECHO_TIMER_CCER_CCP_Pos) | (0x1 << REAR_ECHO_TIMER_CCER_CCNP_Pos) | (0x1 << REAR_ECHO_TIMER_CCER_CCE));
 
@@ -400,16 +404,17 @@ void test_echo_timer_precison()
     NVIC_DisableIRQ(REAR_ECHO_TIMER_IRQ);
 
     // Check the computation of the ARR and PSC for the ULTRASOUND echo signal
-    uint32_t us_test = 65536;
-    uint16_t arr = REAR_ECHO_TIMER->ARR;
+    uint32_t us_test = 1;
+    uint32_t arr = REAR_ECHO_TIMER->ARR;
     uint16_t psc = REAR_ECHO_TIMER->PSC;
-    uint32_t tim_echo_dur_us = round((((double)(arr) + 1.0) / ((double)SystemCoreClock / 1000000.0)) * ((double)(psc) + 1));
-    sprintf(msg, "ERROR: ULTRASOUND timer for echo signal ARR and PSC are not configured correctly for a precision of %ld us", us_test);
-    UNITY_TEST_ASSERT_EQUAL_UINT32(us_test, tim_echo_dur_us, __LINE__, msg);
+    uint32_t tim_echo_tick_us = round(((double)(psc) + 1) / ((double)SystemCoreClock / 1000000.0));
+    sprintf(msg, "ERROR: ULTRASOUND timer for echo signal PSC is not configured correctly for a precision of %ld us", us_test);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(us_test, tim_echo_tick_us, __LINE__, msg);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFF, arr, __LINE__, "ERROR: ULTRASOUND timer for echo signal must use the whole 32-bit range");
 
-    // Check that the ULTRASOUND timer for echo signal is enabled
+    // Check that the ULTRASOUND timer for echo signal is running
     uint32_t tim_echo_en = (REAR_ECHO_TIMER->CR1) & TIM_CR1_CEN_Msk;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(false, tim_echo_en, __LINE__, "ERROR: ULTRASOUND timer for echo should not be enabled after setting the configuration");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN_Msk, tim_echo_en, __LINE__, "ERROR: ULTRASOUND timer for echo should be running after setting the configuration");
 
     // Check that the echo_init_tick time is 0
     uint32_t echo_init_tick = port_ultrasound_get_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID);
@@ -419,10 +424,6 @@ void test_echo_timer_precison()
     uint32_t echo_end_tick = port_ultrasound_get_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID);
     UNITY_TEST_ASSERT_EQUAL_UINT32(0, echo_end_tick, __LINE__, "ERROR: ULTRASOUND echo_end_tick flag must be 0 after setting the configuration");
 
-    // Check that the echo_overflows count is 0
-    uint32_t echo_overflows = port_ultrasound_get_echo_overflows(PORT_REAR_PARKING_SENSOR_ID);
-    UNITY_TEST_ASSERT_EQUAL_UINT32(0, echo_overflows, __LINE__, "ERROR: ULTRASOUND echo_overflows must be 0 after setting the configuration");
-
     // Check that the echo_received flag is cleared
     bool echo_received = port_ultrasound_get_echo_received(PORT_REAR_PARKING_SENSOR_ID);
     UNITY_TEST_ASSERT_EQUAL_UINT32(false, echo_received, __LINE__, "ERROR: ULTRASOUND echo_received flag must be cleared after setting the configuration");
@@ -547,9 +548,11 @@ void test_meas_timer_timeout(void)
     // Disable ULTRASOUND measurement interrupts to avoid any interference
     NVIC_DisableIRQ(MEASUREMENT_TIMER_IRQ);
 
-    // Check that the meas_end flag is set
-    bool trigger_ready = port_ultrasound_get_trigger_ready(PORT_REAR_PARKING_SENSOR_ID);
-    UNITY_TEST_ASSERT_EQUAL_UINT32(true, trigger_ready, __LINE__, "ERROR: ULTRASOUND trigger_ready flag must be set after the measurement timer timeout");
+    // Check that the interrupt queued the start of a new measurement
+    port_event_t event;
+    bool queued = port_ultrasound_pop_event(PORT_REAR_PARKING_SENSOR_ID, &event);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, queued, __LINE__, "ERROR: ULTRASOUND trigger ready event must be queued after the measurement timer timeout");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_ULTRASOUND_EVENT_TRIGGER_READY, event.type, __LINE__, "ERROR: ULTRASOUND queued event must be the start of a new measurement");
 }
 
 void test_start_measurement(void)
@@ -586,8 +589,10 @@ void test_start_measurement(void)
     uint32_t tim_trigger_en = (REAR_TRIGGER_TIMER->CR1) & TIM_CR1_CEN_Msk;
     UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN_Msk, tim_trigger_en, __LINE__, "ERROR: The ULTRASOUND trigger timer has not been enabled");
 
-    uint32_t tim_echo_en = (REAR_ECHO_TIMER->CR1) & TIM_CR1_CEN_Msk;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN_Msk, tim_echo_en, __LINE__, "ERROR: The ULTRASOUND echo timer has not been enabled");
+    uint32_t tim_echo_en = (REAR_ECHO_TIMER->DIER) & TIM_DIER_CC2DE_Msk;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_DIER_CC2DE_Msk, tim_echo_en, __LINE__, "ERROR: The ULTRASOUND echo captures are not requesting the DMA");
+    uint32_t dma_echo_en = (DMA1_Stream6->CR) & DMA_SxCR_EN_Msk;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(DMA_SxCR_EN_Msk, dma_echo_en, __LINE__, "ERROR: The DMA stream of the ULTRASOUND echo captures is not enabled");
 
     uint32_t tim_meas_en = (MEASUREMENT_TIMER->CR1) & TIM_CR1_CEN_Msk;
     UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN_Msk, tim_meas_en, __LINE__, "ERROR: The ULTRASOUND measurement timer has not been enabled");
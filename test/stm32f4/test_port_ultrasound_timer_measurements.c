@@ -176,9 +176,11 @@ void test_meas_timer_timeout(void)
     // Disable ULTRASOUND measurement interrupts to avoid any interference
     NVIC_DisableIRQ(MEASUREMENT_TIMER_IRQ);
 
-    // Check that the meas_end flag is set
-    bool trigger_ready = port_ultrasound_get_trigger_ready(TEST_PORT_REAR_PARKING_SENSOR_ID);
-    UNITY_TEST_ASSERT_EQUAL_UINT32(true, trigger_ready, __LINE__, "ERROR: ULTRASOUND trigger_ready flag must be set after the measurement timer timeout");
+    // Check that the interrupt queued the start of a new measurement
+    port_event_t event;
+    bool queued = port_ultrasound_pop_event(TEST_PORT_REAR_PARKING_SENSOR_ID, &event);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, queued, __LINE__, "ERROR: ULTRASOUND trigger ready event must be queued after the measurement timer timeout");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_ULTRASOUND_EVENT_TRIGGER_READY, event.type, __LINE__, "ERROR: ULTRASOUND queued event must be the start of a new measurement");
 }
 
 void test_start_measurement(void)
@@ -220,9 +220,11 @@ void test_trigger_timer_timeout(void)
     // Disable ULTRASOUND trigger signal interrupts to avoid any interference
     NVIC_DisableIRQ(REAR_TRIGGER_TIMER_IRQ);
 
-    // Check that the trigger_end flag is set
-    bool trigger_end = port_ultrasound_get_trigger_end(TEST_PORT_REAR_PARKING_SENSOR_ID);
-    UNITY_TEST_ASSERT_EQUAL_UINT32(true, trigger_end, __LINE__, "ERROR: ULTRASOUND trigger_end flag must be set after the timeout");
+    // Check that the interrupt queued the end of the trigger signal
+    port_event_t event;
+    bool queued = port_ultrasound_pop_event(TEST_PORT_REAR_PARKING_SENSOR_ID, &event);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, queued, __LINE__, "ERROR: ULTRASOUND trigger end event must be queued after the timeout");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_ULTRASOUND_EVENT_TRIGGER_END, event.type, __LINE__, "ERROR: ULTRASOUND queued event must be the end of the trigger signal");
 }
 
 /**
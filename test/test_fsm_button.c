@@ -97,6 +97,55 @@ void test_long_button_press(void)
     _test_button_press(1000);
 }
 
+/**
+ * @brief Check that a press and a release queued by the interrupt before the FSM is fired are both processed, each one at the time it happened.
+ *
+ */
+void test_queued_press_and_release(void)
+{
+    // Both events are queued before the FSM is fired
+    port_button_push_event(PORT_PARKING_BUTTON_ID, true);
+    port_system_delay_ms(300);
+    port_button_push_event(PORT_PARKING_BUTTON_ID, false);
+    port_system_delay_ms(500);
+
+    fsm_button_fire(p_fsm_button);
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_RELEASED, fsm_button_get_state(p_fsm_button), __LINE__, "The FSM did not process both the press and the release queued before firing it");
+
+    uint32_t duration = fsm_button_get_duration(p_fsm_button);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(300, duration, __LINE__, "The duration of the press should be measured between the timestamps of the queued events");
+}
+
+/**
+ * @brief Check that the level of the button is read from its GPIO if the queue of events overflows, since the lost events are the newest ones.
+ *
+ */
+void test_queue_overflow(void)
+{
+    // Bounces that fill the queue, ending with a press: the final release does not fit
+    for (uint32_t i = 0; i < PORT_EVENT_QUEUE_SIZE; i++)
+    {
+        port_button_push_event(PORT_PARKING_BUTTON_ID, (i % 2) == 1);
+        port_system_delay_ms(1);
+    }
+    port_button_push_event(PORT_PARKING_BUTTON_ID, false);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, port_button_get_event_overflows(PORT_PARKING_BUTTON_ID), __LINE__, "The last event should not fit in the queue");
+
+    // The button is not pressed during the test, so its GPIO reads HIGH (released)
+    port_system_delay_ms(USER_BUTTON_DEBOUNCE_TIME_MS + 10);
+    fsm_button_fire(p_fsm_button);
+    bool pressed = port_button_get_pressed(PORT_PARKING_BUTTON_ID);
+    UNITY_TEST_ASSERT_EQUAL_INT(false, pressed, __LINE__, "The button should be released after the overflow, as its GPIO reads");
+
+    // The FSM settles in BUTTON_RELEASED instead of staying pressed
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        port_system_delay_ms(USER_BUTTON_DEBOUNCE_TIME_MS + 10);
+        fsm_button_fire(p_fsm_button);
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_RELEASED, fsm_button_get_state(p_fsm_button), __LINE__, "The FSM should settle in BUTTON_RELEASED after the overflow");
+}
+
 int main(void)
 {
     port_system_init();
@@ -105,6 +154,8 @@ int main(void)
     RUN_TEST(test_initial_config);
     RUN_TEST(test_short_button_press);
     RUN_TEST(test_long_button_press);
+    RUN_TEST(test_queued_press_and_release);
+    RUN_TEST(test_queue_overflow);
 
     exit(UNITY_END());
 }
@@ -187,6 +187,12 @@ void test_new_color(void)
 
 void test_check_off(void)
 {
+    // Show a color in the three LEDs first, so that turning the display off has to clear them
+    port_display_set_rgb(PORT_REAR_PARKING_DISPLAY_ID, COLOR_TURQUOISE);
+    UNITY_TEST_ASSERT(DISPLAY_RGB_PWM->CCR1 != 0, __LINE__, "The red LED should be on before turning the display off");
+    UNITY_TEST_ASSERT(DISPLAY_RGB_PWM->CCR3 != 0, __LINE__, "The green LED should be on before turning the display off");
+    UNITY_TEST_ASSERT(DISPLAY_RGB_PWM->CCR4 != 0, __LINE__, "The blue LED should be on before turning the display off");
+
     // Set state to SET_DISPLAY
     fsm_display_set_state(p_fsm_display, SET_DISPLAY);
     
@@ -200,14 +206,13 @@ void test_check_off(void)
     fsm_t *p_inner_fsm = fsm_display_get_inner_fsm(p_fsm_display);
     UNITY_TEST_ASSERT_EQUAL_INT(WAIT_DISPLAY, fsm_get_state(p_inner_fsm), __LINE__, "The FSM should move to the WAIT_DISPLAY state if the display is not active");
 
-    // Check that the color is OFF (CCxR are disabled)
-    uint32_t ccer_red = DISPLAY_RGB_PWM->CCER & TIM_CCER_CC1E;
-    uint32_t ccer_green = DISPLAY_RGB_PWM->CCER & TIM_CCER_CC3E;
-    uint32_t ccer_blue = DISPLAY_RGB_PWM->CCER & TIM_CCER_CC4E;
-    
-    UNITY_TEST_ASSERT_EQUAL_UINT32(0, ccer_red, __LINE__, "The red LED should be disabled if the display is not active");
-    UNITY_TEST_ASSERT_EQUAL_UINT32(0, ccer_green, __LINE__, "The green LED should be disabled if the display is not active");
-    UNITY_TEST_ASSERT_EQUAL_UINT32(0, ccer_blue, __LINE__, "The blue LED should be disabled if the display is not active");
+    // Check that the color is OFF: the duty cycles are 0, but the timer keeps running so the next color is applied at an update event
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, DISPLAY_RGB_PWM->CCR1, __LINE__, "The red LED should be off if the display is not active");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, DISPLAY_RGB_PWM->CCR3, __LINE__, "The green LED should be off if the display is not active");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, DISPLAY_RGB_PWM->CCR4, __LINE__, "The blue LED should be off if the display is not active");
+
+    uint32_t tim_en = DISPLAY_RGB_PWM->CR1 & TIM_CR1_CEN_Msk;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN_Msk, tim_en, __LINE__, "The timer of the display should keep running after turning the display off");
 
     // Check that it is not idle and it is not active
     bool is_active = fsm_display_get_status(p_fsm_display);
@@ -215,6 +220,87 @@ void test_check_off(void)
     UNITY_TEST_ASSERT_EQUAL_INT(false, is_active & !idle_and_active, __LINE__, "The FSM should not be active and not idle if the display is not active");    
 }
 
+/**
+ * @brief Show a distance on the active display and check the color of the RGB LED.
+ *
+ */
+static void _check_color_at(uint32_t distance_cm, rgb_color_t expected, uint32_t line)
+{
+    fsm_display_set_state(p_fsm_display, SET_DISPLAY);
+    fsm_display_set_status(p_fsm_display, true);
+    fsm_display_set_distance(p_fsm_display, distance_cm);
+    fsm_display_fire(p_fsm_display);
+
+    rgb_color_t color = port_display_get_rgb(PORT_REAR_PARKING_DISPLAY_ID);
+    sprintf(msg, "ERROR: DISPLAY color at %d cm. Expected: {%d, %d, %d}, actual: {%d, %d, %d}", (int)distance_cm, expected.r, expected.g, expected.b, color.r, color.g, color.b);
+    UNITY_TEST_ASSERT_UINT32_WITHIN(1, expected.r, color.r, line, msg);
+    UNITY_TEST_ASSERT_UINT32_WITHIN(1, expected.g, color.g, line, msg);
+    UNITY_TEST_ASSERT_UINT32_WITHIN(1, expected.b, color.b, line, msg);
+}
+
+/**
+ * @brief Check the colors of the default profile at the boundaries of its zones
+ *
+ */
+void test_default_profile(void)
+{
+    _check_color_at(HIGH_DANGER_MIN_CM, COLOR_RED, __LINE__);
+    _check_color_at(DANGER_MIN_CM, COLOR_RED, __LINE__);
+    _check_color_at(WARNING_MIN_CM, COLOR_YELLOW, __LINE__);
+    _check_color_at(NO_PROBLEM_MIN_CM, COLOR_GREEN, __LINE__);
+    _check_color_at(INFO_MIN_CM, COLOR_TURQUOISE, __LINE__);
+    _check_color_at(OK_MIN_CM, COLOR_BLUE, __LINE__);
+    _check_color_at(OK_MAX_CM, COLOR_OFF, __LINE__);
+
+    // Farther distances are out of the lookup table
+    _check_color_at(FSM_DISPLAY_LUT_SIZE, COLOR_OFF, __LINE__);
+    _check_color_at(1000, COLOR_OFF, __LINE__);
+}
+
+/**
+ * @brief Check that an invalid profile is rejected and the previous one is kept
+ *
+ */
+void test_profile_rejected(void)
+{
+    fsm_display_zone_t not_increasing[] = {{50, COLOR_RED, COLOR_RED}, {50, COLOR_GREEN, COLOR_BLUE}};
+    UNITY_TEST_ASSERT_EQUAL_INT(false, fsm_display_set_profile(p_fsm_display, not_increasing, 2), __LINE__, "A profile whose zones do not end at increasing distances should be rejected");
+
+    fsm_display_zone_t decreasing[] = {{100, COLOR_RED, COLOR_RED}, {50, COLOR_GREEN, COLOR_BLUE}};
+    UNITY_TEST_ASSERT_EQUAL_INT(false, fsm_display_set_profile(p_fsm_display, decreasing, 2), __LINE__, "A profile whose zones end at decreasing distances should be rejected");
+
+    fsm_display_zone_t too_far[] = {{10, COLOR_RED, COLOR_RED}, {FSM_DISPLAY_LUT_SIZE, COLOR_GREEN, COLOR_BLUE}};
+    UNITY_TEST_ASSERT_EQUAL_INT(false, fsm_display_set_profile(p_fsm_display, too_far, 2), __LINE__, "A profile with a zone beyond the lookup table should be rejected");
+
+    UNITY_TEST_ASSERT_EQUAL_INT(false, fsm_display_set_profile(p_fsm_display, too_far, 0), __LINE__, "A profile without zones should be rejected");
+
+    // The default profile is still shown
+    _check_color_at(DANGER_MIN_CM, COLOR_RED, __LINE__);
+    _check_color_at(WARNING_MIN_CM, COLOR_YELLOW, __LINE__);
+    _check_color_at(INFO_MIN_CM, COLOR_TURQUOISE, __LINE__);
+}
+
+/**
+ * @brief Check that a custom profile changes the colors shown, and that the default profile can be restored
+ *
+ */
+void test_custom_profile(void)
+{
+    fsm_display_zone_t custom[] = {{10, COLOR_RED, COLOR_RED}, {100, COLOR_GREEN, COLOR_BLUE}};
+    UNITY_TEST_ASSERT_EQUAL_INT(true, fsm_display_set_profile(p_fsm_display, custom, 2), __LINE__, "A valid custom profile should be accepted");
+
+    _check_color_at(10, COLOR_RED, __LINE__);
+    _check_color_at(WARNING_MIN_CM, (rgb_color_t){0, PORT_DISPLAY_RGB_MAX_VALUE * (100 - WARNING_MIN_CM) / (100 - 10), PORT_DISPLAY_RGB_MAX_VALUE * (WARNING_MIN_CM - 10) / (100 - 10)}, __LINE__);
+    _check_color_at(100, COLOR_BLUE, __LINE__);
+
+    // The default profile shows turquoise here, but it is beyond the last zone of the custom profile
+    _check_color_at(INFO_MIN_CM, COLOR_OFF, __LINE__);
+
+    UNITY_TEST_ASSERT_EQUAL_INT(true, fsm_display_set_profile(p_fsm_display, NULL, 0), __LINE__, "The default profile should be restored without zones");
+    _check_color_at(WARNING_MIN_CM, COLOR_YELLOW, __LINE__);
+    _check_color_at(INFO_MIN_CM, COLOR_TURQUOISE, __LINE__);
+}
+
 
 int main(void)
 {
@@ -225,6 +311,9 @@ int main(void)
     RUN_TEST(test_activation);
     RUN_TEST(test_new_color);
     RUN_TEST(test_check_off);
+    RUN_TEST(test_default_profile);
+    RUN_TEST(test_profile_rejected);
+    RUN_TEST(test_custom_profile);
 
     exit(UNITY_END());
 }
@@ -28,6 +28,9 @@
 #define REAR_ECHO_TIMER TIM2    /*!< Echo signal timer @hideinitializer */
 #define MEASUREMENT_TIMER TIM5  /*!< Ultrasound measurement timer @hideinitializer */
 
+// Echo signal of a real sensor
+#define ECHO_DELAY_US 500 /*!< Delay from the start of a measurement to the start of its echo signal @hideinitializer */
+
 /* Global variables ----------------------------------------------------------*/
 static char msg[200];                      /*!< Buffer for the error messages */
 static fsm_ultrasound_t *p_fsm_ultrasound; /*!< Pointer to the ultrasound FSM */
@@ -43,6 +46,42 @@ void tearDown(void)
     // Nothing to do
 }
 
+/**
+ * @brief Start a measurement and receive an echo signal.
+ *
+ * @param delay_us Delay from the start of the measurement to the start of the echo signal.
+ * @param echo_us Duration of the echo signal in us.
+ */
+static void _receive_echo_delayed(uint32_t delay_us, uint32_t echo_us)
+{
+    uint32_t ticks_per_us = port_ultrasound_get_echo_ticks_per_us(PORT_REAR_PARKING_SENSOR_ID);
+
+    // Start the measurement from SET_DISTANCE, which does not depend on the status of the sensor
+    fsm_ultrasound_set_state(p_fsm_ultrasound, SET_DISTANCE);
+    port_ultrasound_set_trigger_ready(PORT_REAR_PARKING_SENSOR_ID, true);
+    uint32_t start_tick = port_ultrasound_get_echo_current_tick(PORT_REAR_PARKING_SENSOR_ID);
+    fsm_ultrasound_fire(p_fsm_ultrasound);
+
+    // Set the state to WAIT_ECHO_END
+    fsm_ultrasound_set_state(p_fsm_ultrasound, WAIT_ECHO_END); // Avoids jumping to the next state
+    port_ultrasound_set_echo_received(PORT_REAR_PARKING_SENSOR_ID, true);
+    port_ultrasound_set_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID, start_tick + delay_us * ticks_per_us);
+    port_ultrasound_set_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID, start_tick + (delay_us + echo_us) * ticks_per_us);
+    fsm_ultrasound_fire(p_fsm_ultrasound);
+}
+
+/**
+ * @brief Start a measurement and receive its echo signal.
+ *
+ * The echo signal starts `ECHO_DELAY_US` after the start of the measurement, like the answer of a real sensor, so that it is not rejected as spurious.
+ *
+ * @param echo_us Duration of the echo signal in us.
+ */
+static void _receive_echo(uint32_t echo_us)
+{
+    _receive_echo_delayed(ECHO_DELAY_US, echo_us);
+}
+
 /**
  * @brief Test the configuration of the ultrasound FSM.
  *
@@ -54,8 +93,8 @@ void test_initial_config(void)
 
     UNITY_TEST_ASSERT_EQUAL_INT(WAIT_START, fsm_get_state(p_inner_fsm), __LINE__, "The initial state of the FSM is not WAIT_START");
 
-    // It assumes there are 6 transitions in the table plus the null transition
-    fsm_trans_t *last_transition = &p_inner_fsm->p_tt[6];
+    // It assumes there are 9 transitions in the table plus the null transition
+    fsm_trans_t *last_transition = &p_inner_fsm->p_tt[9];
 
     UNITY_TEST_ASSERT_EQUAL_INT(-1, last_transition->orig_state, __LINE__, "The origin state of the last transition of the FSM should be -1");
     UNITY_TEST_ASSERT_EQUAL_INT(NULL, last_transition->in, __LINE__, "The input condition function of the last transition of the FSM should be NULL");
@@ -123,9 +162,6 @@ void test_echo_init(void)
 
 void test_echo_received_and_distance(void)
 {
-    uint32_t init_ticks[FSM_ULTRASOUND_NUM_MEASUREMENTS] = {1, 64371, 3, 63208, 5};
-    uint32_t end_ticks[FSM_ULTRASOUND_NUM_MEASUREMENTS] = {584, 3, 1752, 4, 2920};
-    uint32_t overflows[FSM_ULTRASOUND_NUM_MEASUREMENTS] = {0, 1, 0, 1, 0};
     uint32_t expected_time_diff_ticks[FSM_ULTRASOUND_NUM_MEASUREMENTS] = {583, 1168, 1749, 2332, 2915};
     uint32_t expected_distance[FSM_ULTRASOUND_NUM_MEASUREMENTS] = {10, 20, 30, 40, 50};
     uint32_t expected_median = 30;
@@ -133,18 +169,16 @@ void test_echo_received_and_distance(void)
     // Set some values to the echo signal ticks
     for (uint32_t i = 0; i < FSM_ULTRASOUND_NUM_MEASUREMENTS; i++)
     {
-        // Set the state to WAIT_ECHO_END
-        fsm_ultrasound_set_state(p_fsm_ultrasound, WAIT_ECHO_END); // Avoids jumping to the next state
-
-        port_ultrasound_set_echo_received(PORT_REAR_PARKING_SENSOR_ID, true);
-        port_ultrasound_set_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID, init_ticks[i]);
-        port_ultrasound_set_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID, end_ticks[i]);
-        port_ultrasound_set_echo_overflows(PORT_REAR_PARKING_SENSOR_ID, overflows[i]);
+        // The second and fourth echoes wrap around the 32-bit echo timebase
+        if (i % 2 == 1)
+        {
+            REAR_ECHO_TIMER->CNT = 0xFFFFFFFF - (ECHO_DELAY_US + expected_time_diff_ticks[i] / 2) * port_ultrasound_get_echo_ticks_per_us(PORT_REAR_PARKING_SENSOR_ID);
+        }
 
-        printf("Init tick: %ld, End tick: %ld, Overflows: %ld.\n\tExpected time diff: %ld ticks, Expected distance: %ld cm.\n", init_ticks[i], end_ticks[i], overflows[i], expected_time_diff_ticks[i], expected_distance[i]);
+        printf("Echo tick: %lu.\n\tExpected time diff: %lu ticks, Expected distance: %lu cm.\n", port_ultrasound_get_echo_current_tick(PORT_REAR_PARKING_SENSOR_ID), expected_time_diff_ticks[i], expected_distance[i]);
 
         // Check the transition
-        fsm_ultrasound_fire(p_fsm_ultrasound);
+        _receive_echo(expected_time_diff_ticks[i]);
         UNITY_TEST_ASSERT_EQUAL_INT(SET_DISTANCE, fsm_ultrasound_get_state(p_fsm_ultrasound), __LINE__, "The FSM did not change to SET_DISTANCE from WAIT_ECHO_END after receiving the echo signal");
 
         // Check that the echo signal is cleared
@@ -159,26 +193,345 @@ void test_echo_received_and_distance(void)
     sprintf(msg, "ERROR: The median distance is not correctly set after the transition from WAIT_ECHO_END to SET_DISTANCE. The error is higher than 1cm");
     UNITY_TEST_ASSERT_INT_WITHIN(1, expected_median, distance, __LINE__, msg);
 
-    // Repeat the test to check that the final distance is not computed as moving median, but when the buffer is full. Set the first distances to 0
+    // Repeat the test to check that the distance is computed as a moving median, i.e. a new median is published after every echo. Set the next distances to the minimum of the sensor (1 cm after truncation)
     uint32_t mid_idx = (FSM_ULTRASOUND_NUM_MEASUREMENTS % 2 == 0) ? (FSM_ULTRASOUND_NUM_MEASUREMENTS / 2) + 1 : (FSM_ULTRASOUND_NUM_MEASUREMENTS / 2);
 
     for (uint32_t i = 0; i <= mid_idx; i++)
     {
-        // Set the state to WAIT_ECHO_END
-        fsm_ultrasound_set_state(p_fsm_ultrasound, WAIT_ECHO_END); // Avoids jumping to the next state
+        _receive_echo(FSM_ULTRASOUND_MIN_ECHO_US);
+
+        bool new_measurement = fsm_ultrasound_get_new_measurement_ready(p_fsm_ultrasound);
+        UNITY_TEST_ASSERT_EQUAL_UINT32(true, new_measurement, __LINE__, "ERROR: A new median distance should be published after every echo once the window is full");
+        distance = fsm_ultrasound_get_distance(p_fsm_ultrasound);
+    }
+
+    // Check that the distance is correctly set: more than half of the window contains the 1 cm of FSM_ULTRASOUND_MIN_ECHO_US
+    sprintf(msg, "ERROR: The median distance is not being computed as a moving median over the last %d measurements", FSM_ULTRASOUND_NUM_MEASUREMENTS); 
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, distance, __LINE__, msg);
+}
+
+/**
+ * @brief Check that the distance is also published in mm, with sub-centimetre precision.
+ *
+ */
+void test_distance_mm(void)
+{
+    // 1000 us of echo are 171.5 mm at 343 m/s
+    for (uint32_t i = 0; i < FSM_ULTRASOUND_NUM_MEASUREMENTS; i++)
+    {
+        _receive_echo(1000);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(171, fsm_ultrasound_get_distance_mm(p_fsm_ultrasound), __LINE__, "ERROR: The distance in mm is not correctly computed from the duration of the echo signal");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(17, fsm_ultrasound_get_distance(p_fsm_ultrasound), __LINE__, "ERROR: The distance in cm should be the distance in mm truncated to cm");
+
+    // 6 us more are 1 mm more: only visible in mm
+    for (uint32_t i = 0; i < FSM_ULTRASOUND_NUM_MEASUREMENTS; i++)
+    {
+        _receive_echo(1006);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(172, fsm_ultrasound_get_distance_mm(p_fsm_ultrasound), __LINE__, "ERROR: The distance in mm does not have sub-centimetre precision");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(17, fsm_ultrasound_get_distance(p_fsm_ultrasound), __LINE__, "ERROR: The distance in cm should be the distance in mm truncated to cm");
+}
+
+/**
+ * @brief Check that the speed of sound is compensated with the temperature of the air.
+ *
+ */
+void test_temperature(void)
+{
+    int32_t temperatures[] = {FSM_ULTRASOUND_MIN_TEMPERATURE_C, FSM_ULTRASOUND_DEFAULT_TEMPERATURE_C, FSM_ULTRASOUND_MAX_TEMPERATURE_C};
+    uint32_t expected_distance_mm[] = {159, 171, 178}; // 1000 us of echo at 318.9, 343.2 and 357.6 m/s
+
+    UNITY_TEST_ASSERT_EQUAL_INT(FSM_ULTRASOUND_DEFAULT_TEMPERATURE_C, fsm_ultrasound_get_temperature(p_fsm_ultrasound), __LINE__, "ERROR: The initial temperature should be FSM_ULTRASOUND_DEFAULT_TEMPERATURE_C");
+    for (uint32_t i = 0; i < sizeof(temperatures) / sizeof(temperatures[0]); i++)
+    {
+        fsm_ultrasound_set_temperature(p_fsm_ultrasound, temperatures[i]);
+        for (uint32_t j = 0; j < FSM_ULTRASOUND_NUM_MEASUREMENTS; j++)
+        {
+            _receive_echo(1000);
+        }
+        sprintf(msg, "ERROR: The distance at %ld C is not compensated with the speed of sound", (long)temperatures[i]);
+        UNITY_TEST_ASSERT_EQUAL_UINT32(expected_distance_mm[i], fsm_ultrasound_get_distance_mm(p_fsm_ultrasound), __LINE__, msg);
+    }
+
+    // Out of the operating range the temperature is saturated
+    fsm_ultrasound_set_temperature(p_fsm_ultrasound, 100);
+    UNITY_TEST_ASSERT_EQUAL_INT(FSM_ULTRASOUND_MAX_TEMPERATURE_C, fsm_ultrasound_get_temperature(p_fsm_ultrasound), __LINE__, "ERROR: The temperature should be saturated to FSM_ULTRASOUND_MAX_TEMPERATURE_C");
+    fsm_ultrasound_set_temperature(p_fsm_ultrasound, -100);
+    UNITY_TEST_ASSERT_EQUAL_INT(FSM_ULTRASOUND_MIN_TEMPERATURE_C, fsm_ultrasound_get_temperature(p_fsm_ultrasound), __LINE__, "ERROR: The temperature should be saturated to FSM_ULTRASOUND_MIN_TEMPERATURE_C");
+}
+
+/**
+ * @brief Check that a distance is published during the warm-up, before the window is full.
+ *
+ */
+void test_warm_up(void)
+{
+    uint32_t echo_ticks[3] = {583, 1749, 1163};
+    uint32_t expected_median[3] = {10, 10, 20};
+    bool expected_new[3] = {true, false, true};
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        _receive_echo(echo_ticks[i]);
+
+        bool new_measurement = fsm_ultrasound_get_new_measurement_ready(p_fsm_ultrasound);
+        UNITY_TEST_ASSERT_EQUAL_UINT32(expected_new[i], new_measurement, __LINE__, "ERROR: During the warm-up a distance must be published only after an odd number of echoes");
+        if (new_measurement)
+        {
+            uint32_t distance = fsm_ultrasound_get_distance(p_fsm_ultrasound);
+            UNITY_TEST_ASSERT_INT_WITHIN(1, expected_median[i], distance, __LINE__, "ERROR: The warm-up distance is not the median of the echoes received so far");
+        }
+    }
+
+    uint8_t confidence = fsm_ultrasound_get_confidence(p_fsm_ultrasound);
+    sprintf(msg, "ERROR: The confidence after 3 of %d measurements is not correct", FSM_ULTRASOUND_NUM_MEASUREMENTS);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(100 * 3 / FSM_ULTRASOUND_NUM_MEASUREMENTS, confidence, __LINE__, msg);
+}
+
+/**
+ * @brief Check that a lost echo signal is abandoned after the timeout. If its start was lost, the next measurement can be triggered right away. If its end was lost, the echo line may still be high, so the sensor is not triggered until the echo signal ends.
+ *
+ */
+void test_echo_timeout(void)
+{
+    uint32_t states[2] = {WAIT_ECHO_START, WAIT_ECHO_END};
+    uint32_t timeout_ms = fsm_ultrasound_get_echo_timeout_ms(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT(timeout_ms >= FSM_ULTRASOUND_ECHO_TIMEOUT_MS, __LINE__, "The echo timeout should not be shorter than FSM_ULTRASOUND_ECHO_TIMEOUT_MS");
+
+    fsm_ultrasound_set_status(p_fsm_ultrasound, true);
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        // Start a measurement whose echo never arrives
+        port_ultrasound_set_trigger_ready(PORT_REAR_PARKING_SENSOR_ID, true);
+        fsm_ultrasound_set_state(p_fsm_ultrasound, WAIT_START);
+        fsm_ultrasound_fire(p_fsm_ultrasound);
+        port_ultrasound_set_trigger_ready(PORT_REAR_PARKING_SENSOR_ID, false);
+        port_ultrasound_set_echo_received(PORT_REAR_PARKING_SENSOR_ID, false);
+        port_system_delay_ms(timeout_ms - 5);
+
+        // The rising edge arrives right now, so the echo signal reaches the timeout before the end of the range of interest
+        port_ultrasound_set_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID, (i == 0) ? 0 : port_ultrasound_get_echo_current_tick(PORT_REAR_PARKING_SENSOR_ID));
+        fsm_ultrasound_set_state(p_fsm_ultrasound, states[i]);
 
-        port_ultrasound_set_echo_received(PORT_REAR_PARKING_SENSOR_ID, true);
-        port_ultrasound_set_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID, 0);
-        port_ultrasound_set_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID, 0);
-        port_ultrasound_set_echo_overflows(PORT_REAR_PARKING_SENSOR_ID, 0);
+        // Before the timeout the FSM keeps waiting
         fsm_ultrasound_fire(p_fsm_ultrasound);
+        UNITY_TEST_ASSERT_EQUAL_INT(states[i], fsm_ultrasound_get_state(p_fsm_ultrasound), __LINE__, "The FSM should keep waiting for the echo signal before the timeout");
+
+        // After the timeout the measurement is abandoned
+        port_system_delay_ms(6);
+        fsm_ultrasound_fire(p_fsm_ultrasound);
+        UNITY_TEST_ASSERT_EQUAL_INT(SET_DISTANCE, fsm_ultrasound_get_state(p_fsm_ultrasound), __LINE__, "The FSM did not change to SET_DISTANCE after the echo timeout");
+
+        bool trigger_ready = port_ultrasound_get_trigger_ready(PORT_REAR_PARKING_SENSOR_ID);
+        if (i == 0)
+        {
+            UNITY_TEST_ASSERT_EQUAL_UINT32(true, trigger_ready, __LINE__, "The next measurement should be ready to be triggered right after the timeout of the start of the echo signal");
+        }
+        else
+        {
+            UNITY_TEST_ASSERT_EQUAL_UINT32(false, trigger_ready, __LINE__, "The sensor should not be triggered while the echo signal that timed out may still be high");
+        }
+
+        uint32_t echo_init_tick = port_ultrasound_get_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID);
+        UNITY_TEST_ASSERT_EQUAL_UINT32(0, echo_init_tick, __LINE__, "The echo init tick should be reset after the echo timeout");
     }
 
-    // Check that the distance is correctly set
-    distance = fsm_ultrasound_get_distance(p_fsm_ultrasound);
+    // Warm-up with 2 lost echoes: nothing is published after the second one, the first one is out of range
+    uint32_t distance = fsm_ultrasound_get_distance(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FSM_ULTRASOUND_NO_ECHO_CM, distance, __LINE__, "A lost echo should be stored as FSM_ULTRASOUND_NO_ECHO_CM");
+}
 
-    sprintf(msg, "ERROR: The median distance is being computed before the buffer is full, i.e. before the index is equal to the number of %d", FSM_ULTRASOUND_NUM_MEASUREMENTS); 
-    UNITY_TEST_ASSERT_INT_WITHIN(1, expected_median, distance, __LINE__, msg);
+/**
+ * @brief Check that the echo of an obstacle near the default range of interest does not time out, although it lasts longer than `FSM_ULTRASOUND_ECHO_TIMEOUT_MS`.
+ *
+ */
+void test_far_echo(void)
+{
+    uint32_t ticks_per_us = port_ultrasound_get_echo_ticks_per_us(PORT_REAR_PARKING_SENSOR_ID);
+    uint32_t echo_us = 380 * 2 * 10000 / SPEED_OF_SOUND_MS; // Obstacle at 380 cm
+
+    // Start a measurement whose echo signal starts after ECHO_DELAY_US
+    fsm_ultrasound_set_status(p_fsm_ultrasound, true);
+    fsm_ultrasound_set_state(p_fsm_ultrasound, SET_DISTANCE);
+    port_ultrasound_set_trigger_ready(PORT_REAR_PARKING_SENSOR_ID, true);
+    uint32_t start_tick = port_ultrasound_get_echo_current_tick(PORT_REAR_PARKING_SENSOR_ID);
+    fsm_ultrasound_fire(p_fsm_ultrasound);
+    fsm_ultrasound_set_state(p_fsm_ultrasound, WAIT_ECHO_END);
+    port_ultrasound_set_echo_received(PORT_REAR_PARKING_SENSOR_ID, false);
+    port_ultrasound_set_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID, start_tick + ECHO_DELAY_US * ticks_per_us);
+
+    // The echo signal is still high after FSM_ULTRASOUND_ECHO_TIMEOUT_MS
+    port_system_delay_ms((ECHO_DELAY_US + echo_us) / 1000);
+    UNITY_TEST_ASSERT((ECHO_DELAY_US + echo_us) / 1000 > FSM_ULTRASOUND_ECHO_TIMEOUT_MS, __LINE__, "The echo of the test should last longer than FSM_ULTRASOUND_ECHO_TIMEOUT_MS");
+    fsm_ultrasound_fire(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_EQUAL_INT(WAIT_ECHO_END, fsm_ultrasound_get_state(p_fsm_ultrasound), __LINE__, "The echo of an obstacle in the range of interest should not time out");
+
+    // Its end is received and measured
+    port_ultrasound_set_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID, start_tick + (ECHO_DELAY_US + echo_us) * ticks_per_us);
+    port_ultrasound_set_echo_received(PORT_REAR_PARKING_SENSOR_ID, true);
+    fsm_ultrasound_fire(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_EQUAL_INT(SET_DISTANCE, fsm_ultrasound_get_state(p_fsm_ultrasound), __LINE__, "The FSM did not change to SET_DISTANCE after receiving the far echo");
+
+    fsm_ultrasound_history_it_t it;
+    const fsm_ultrasound_sample_t *p_sample = fsm_ultrasound_history_begin(p_fsm_ultrasound, &it);
+    UNITY_TEST_ASSERT_NOT_NULL(p_sample, __LINE__, "The far echo should be stored in the history");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FSM_ULTRASOUND_SAMPLE_OK, p_sample->status, __LINE__, "The far echo should be stored as a valid measurement");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(echo_us * ticks_per_us, p_sample->echo_ticks, __LINE__, "The duration of the far echo is not the one received");
+}
+
+/**
+ * @brief Check that an echo longer than the range of interest is abandoned before its end.
+ *
+ */
+void test_range_gate(void)
+{
+    fsm_ultrasound_set_max_range(p_fsm_ultrasound, 100);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(100, fsm_ultrasound_get_max_range(p_fsm_ultrasound), __LINE__, "The range of interest has not been set");
+
+    // Set the state to WAIT_ECHO_END with an echo that started 100000 ticks ago (about 17 m)
+    fsm_ultrasound_set_state(p_fsm_ultrasound, WAIT_ECHO_END);
+    port_ultrasound_set_trigger_ready(PORT_REAR_PARKING_SENSOR_ID, false);
+    port_ultrasound_set_echo_received(PORT_REAR_PARKING_SENSOR_ID, false);
+    port_ultrasound_set_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID, port_ultrasound_get_echo_current_tick(PORT_REAR_PARKING_SENSOR_ID) - 100000);
+    port_ultrasound_set_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID, 0);
+
+    // Check the transition
+    fsm_ultrasound_fire(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_EQUAL_INT(SET_DISTANCE, fsm_ultrasound_get_state(p_fsm_ultrasound), __LINE__, "The FSM did not change to SET_DISTANCE after the echo exceeded the range of interest");
+
+    uint32_t distance = fsm_ultrasound_get_distance(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FSM_ULTRASOUND_NO_ECHO_CM, distance, __LINE__, "An echo beyond the range of interest should be stored as FSM_ULTRASOUND_NO_ECHO_CM");
+
+    uint32_t echo_init_tick = port_ultrasound_get_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, echo_init_tick, __LINE__, "The echo init tick should be reset after abandoning the echo");
+}
+
+/**
+ * @brief Check that the period between measurements shrinks when the obstacle is near.
+ *
+ */
+void test_adaptive_period(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_PARKING_SENSOR_TIMEOUT_MS, fsm_ultrasound_get_measurement_period_ms(p_fsm_ultrasound), __LINE__, "The initial period between measurements should be PORT_PARKING_SENSOR_TIMEOUT_MS");
+
+    // Receive an echo of an obstacle at 10 cm
+    _receive_echo(583);
+
+    uint32_t period_ms = fsm_ultrasound_get_measurement_period_ms(p_fsm_ultrasound);
+    sprintf(msg, "ERROR: The period between measurements with an obstacle at 10 cm should be between %d and %d ms", FSM_ULTRASOUND_MIN_PERIOD_MS, PORT_PARKING_SENSOR_TIMEOUT_MS);
+    UNITY_TEST_ASSERT(period_ms >= FSM_ULTRASOUND_MIN_PERIOD_MS && period_ms < PORT_PARKING_SENSOR_TIMEOUT_MS, __LINE__, msg);
+
+    uint32_t port_period_ms = port_ultrasound_get_measurement_period_ms(PORT_REAR_PARKING_SENSOR_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(period_ms, port_period_ms, __LINE__, "The period between measurements has not been set in the port");
+}
+
+/**
+ * @brief Check the closing speed and time to collision of an obstacle that approaches at 100 cm/s.
+ *
+ */
+void test_tracker(void)
+{
+    fsm_ultrasound_start(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FSM_ULTRASOUND_TTC_INFINITE, fsm_ultrasound_get_ttc_ms(p_fsm_ultrasound), __LINE__, "The time to collision should be infinite before any measurement");
+
+    uint32_t distance = 200;
+    for (uint32_t i = 0; i < 12; i++)
+    {
+        // Trigger a measurement every 100 ms and receive the echo of the obstacle
+        port_system_delay_ms(100);
+        distance -= 10;
+        _receive_echo(1 + distance * 20000 / SPEED_OF_SOUND_MS);
+    }
+
+    int32_t closing_speed = fsm_ultrasound_get_closing_speed(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_INT_WITHIN(50, 100, closing_speed, __LINE__, "ERROR: The closing speed of an obstacle that approaches at 100 cm/s is not correct");
+
+    // The tracker is fed with the median of the window, which lags FSM_ULTRASOUND_NUM_MEASUREMENTS / 2 measurements (10 cm each) behind
+    uint32_t filtered_distance = fsm_ultrasound_get_filtered_distance(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_INT_WITHIN(10 * (FSM_ULTRASOUND_NUM_MEASUREMENTS / 2) + 5, distance, filtered_distance, __LINE__, "ERROR: The filtered distance is too far from the real distance");
+
+    uint32_t ttc = fsm_ultrasound_get_ttc_ms(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT(ttc < 2000, __LINE__, "ERROR: The time to collision of an obstacle at 80 cm that approaches at 100 cm/s should be below 2 s");
+}
+
+/**
+ * @brief Check that the measurements are stored in the history from the newest to the oldest, with their status and timestamps.
+ *
+ */
+void test_history(void)
+{
+    fsm_ultrasound_history_it_t it;
+    UNITY_TEST_ASSERT_NULL(fsm_ultrasound_history_begin(p_fsm_ultrasound, &it), __LINE__, "The history should be empty after creating the FSM");
+
+    fsm_ultrasound_set_status(p_fsm_ultrasound, true);
+    for (uint32_t i = 0; i < FSM_ULTRASOUND_HISTORY_SIZE + 2; i++)
+    {
+        // Trigger a measurement every 10 ms and receive an echo of 1 ms + (i + 1) * 100 us (about 2 cm more each time)
+        port_system_delay_ms(10);
+        _receive_echo(1000 + (i + 1) * 100);
+    }
+
+    uint32_t ticks_per_us = port_ultrasound_get_echo_ticks_per_us(PORT_REAR_PARKING_SENSOR_ID);
+    uint32_t num_samples = 0;
+    uint32_t expected_ticks = (1000 + (FSM_ULTRASOUND_HISTORY_SIZE + 2) * 100) * ticks_per_us;
+    const fsm_ultrasound_sample_t *p_newer = NULL;
+    for (const fsm_ultrasound_sample_t *p_sample = fsm_ultrasound_history_begin(p_fsm_ultrasound, &it); p_sample != NULL; p_sample = fsm_ultrasound_history_next(&it))
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(expected_ticks, p_sample->echo_ticks, __LINE__, "ERROR: The history is not ordered from the newest to the oldest measurement");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(FSM_ULTRASOUND_SAMPLE_OK, p_sample->status, __LINE__, "ERROR: The status of a received echo should be FSM_ULTRASOUND_SAMPLE_OK");
+        if (p_newer != NULL)
+        {
+            UNITY_TEST_ASSERT(p_newer->timestamp_tick - p_sample->timestamp_tick >= 10000 * ticks_per_us, __LINE__, "ERROR: The timestamps of the history are not 10 ms apart");
+        }
+        p_newer = p_sample;
+        expected_ticks -= 100 * ticks_per_us;
+        num_samples++;
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FSM_ULTRASOUND_HISTORY_SIZE, num_samples, __LINE__, "ERROR: The history should keep the last FSM_ULTRASOUND_HISTORY_SIZE measurements");
+}
+
+/**
+ * @brief Check that spurious echoes and echoes far from the tracked obstacle are rejected, and that a real change of obstacle is followed.
+ *
+ */
+void test_plausibility(void)
+{
+    uint32_t echo_100_cm = 100 * 20000 / SPEED_OF_SOUND_MS;
+    uint32_t echo_40_cm = 40 * 20000 / SPEED_OF_SOUND_MS;
+
+    // Track an obstacle at 100 cm
+    fsm_ultrasound_start(p_fsm_ultrasound);
+    for (uint32_t i = 0; i < FSM_ULTRASOUND_NUM_MEASUREMENTS; i++)
+    {
+        port_system_delay_ms(100);
+        _receive_echo(echo_100_cm);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fsm_ultrasound_get_rejections(p_fsm_ultrasound), __LINE__, "ERROR: Plausible echoes have been rejected");
+
+    // Spurious echoes: too short, too early and too late
+    _receive_echo(FSM_ULTRASOUND_MIN_ECHO_US - 1);
+    _receive_echo_delayed(FSM_ULTRASOUND_MIN_ECHO_DELAY_US - 1, echo_100_cm);
+    _receive_echo_delayed(FSM_ULTRASOUND_MAX_ECHO_DELAY_US + 1, echo_100_cm);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, fsm_ultrasound_get_rejections(p_fsm_ultrasound), __LINE__, "ERROR: Spurious echoes have not been rejected");
+    UNITY_TEST_ASSERT_INT_WITHIN(1, 100, fsm_ultrasound_get_distance(p_fsm_ultrasound), __LINE__, "ERROR: A rejected echo has changed the distance");
+
+    fsm_ultrasound_history_it_t it;
+    const fsm_ultrasound_sample_t *p_sample = fsm_ultrasound_history_begin(p_fsm_ultrasound, &it);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FSM_ULTRASOUND_SAMPLE_REJECTED, p_sample->status, __LINE__, "ERROR: A rejected echo should be stored in the history as FSM_ULTRASOUND_SAMPLE_REJECTED");
+
+    // Echoes at 40 cm every 10 ms (e.g. crosstalk) are rejected FSM_ULTRASOUND_MAX_REJECTIONS times, then the filter follows the new obstacle
+    for (uint32_t i = 0; i < FSM_ULTRASOUND_MAX_REJECTIONS; i++)
+    {
+        port_system_delay_ms(10);
+        _receive_echo(echo_40_cm);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3 + FSM_ULTRASOUND_MAX_REJECTIONS, fsm_ultrasound_get_rejections(p_fsm_ultrasound), __LINE__, "ERROR: Echoes far from the tracked obstacle have not been rejected");
+
+    port_system_delay_ms(10);
+    _receive_echo(echo_40_cm);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3 + FSM_ULTRASOUND_MAX_REJECTIONS, fsm_ultrasound_get_rejections(p_fsm_ultrasound), __LINE__, "ERROR: The filter does not follow a persistent change of obstacle");
+    UNITY_TEST_ASSERT_INT_WITHIN(1, 40, fsm_ultrasound_get_distance(p_fsm_ultrasound), __LINE__, "ERROR: The distance of the new obstacle has not been published");
 }
 
 /**
@@ -221,8 +574,9 @@ void test_stop_measurement(void)
     uint32_t tim_trigger_en = (REAR_TRIGGER_TIMER->CR1) & TIM_CR1_CEN_Msk;
     UNITY_TEST_ASSERT_EQUAL_UINT32(false, tim_trigger_en, __LINE__, "The trigger timer should be disabled after stopping the measurement");
 
-    uint32_t tim_echo_en = (REAR_ECHO_TIMER->CR1) & TIM_CR1_CEN_Msk;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(false, tim_echo_en, __LINE__, "The echo timer should be disabled after stopping the measurement");
+    // The echo timebase is shared and keeps running, and its captures are copied by DMA: no capture interrupt is ever enabled
+    uint32_t tim_echo_en = (REAR_ECHO_TIMER->DIER) & TIM_DIER_CC2IE_Msk;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(false, tim_echo_en, __LINE__, "The echo capture interrupt should be disabled after stopping the measurement");
 
     uint32_t tim_meas_en = (MEASUREMENT_TIMER->CR1) & TIM_CR1_CEN_Msk;
     UNITY_TEST_ASSERT_EQUAL_UINT32(false, tim_meas_en, __LINE__, "The measurement timer should be disabled after stopping the measurement");
@@ -234,14 +588,34 @@ void test_stop_measurement(void)
     uint32_t echo_end_tick = port_ultrasound_get_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID);
     UNITY_TEST_ASSERT_EQUAL_UINT32(0, echo_end_tick, __LINE__, "The echo end tick should be reset after stopping the measurement");
 
-    uint32_t echo_overflows = port_ultrasound_get_echo_overflows(PORT_REAR_PARKING_SENSOR_ID);
-    UNITY_TEST_ASSERT_EQUAL_UINT32(0, echo_overflows, __LINE__, "The echo overflows should be reset after stopping the measurement");
-
     // Check that the echo signal is cleared
     bool echo_received = port_ultrasound_get_echo_received(PORT_REAR_PARKING_SENSOR_ID);
     UNITY_TEST_ASSERT_EQUAL_UINT32(false, echo_received, __LINE__, "The echo signal should be cleared after stopping the measurement");
 }
 
+/**
+ * @brief Check that the expiries of the timer of new measurements queued before the FSM is fired are not collapsed: the one that starts a measurement is used and the other one is counted as missed.
+ *
+ */
+void test_missed_period(void)
+{
+    fsm_ultrasound_set_status(p_fsm_ultrasound, true);
+    port_ultrasound_set_trigger_ready(PORT_REAR_PARKING_SENSOR_ID, false);
+    fsm_ultrasound_set_state(p_fsm_ultrasound, SET_DISTANCE);
+
+    // The timer of new measurements expires twice before the FSM is fired
+    port_system_delay_ms(1);
+    stm32f4_ultrasound_timer_isr(STM32F4_REAR_PARKING_SENSOR_PERIOD_TIMER);
+    port_system_delay_ms(1);
+    stm32f4_ultrasound_timer_isr(STM32F4_REAR_PARKING_SENSOR_PERIOD_TIMER);
+
+    fsm_ultrasound_fire(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, fsm_ultrasound_is_measuring(p_fsm_ultrasound), __LINE__, "The first expiry of the timer of new measurements should start a measurement");
+
+    uint32_t missed_periods = fsm_ultrasound_get_missed_periods(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, missed_periods, __LINE__, "The second expiry of the timer of new measurements should be counted as missed");
+}
+
 int main(void)
 {
     port_system_init();
@@ -252,7 +626,18 @@ int main(void)
     RUN_TEST(test_trigger_end);
     RUN_TEST(test_echo_init);
     RUN_TEST(test_echo_received_and_distance);
+    RUN_TEST(test_distance_mm);
+    RUN_TEST(test_temperature);
+    RUN_TEST(test_warm_up);
+    RUN_TEST(test_echo_timeout);
+    RUN_TEST(test_far_echo);
+    RUN_TEST(test_range_gate);
+    RUN_TEST(test_adaptive_period);
+    RUN_TEST(test_tracker);
+    RUN_TEST(test_history);
+    RUN_TEST(test_plausibility);
     RUN_TEST(test_new_measurement);
     RUN_TEST(test_stop_measurement);
+    RUN_TEST(test_missed_period);
     exit(UNITY_END());
 }
@@ -0,0 +1,201 @@
+/**
+ * @file test_fsm_urbanite.c
+ * @brief Unit test for the Urbanite FSM when the front and rear sides are measured at the same time (see `fsm_urbanite_set_measure_both()`).
+ *
+ * The distances are published on the measurement bus by the test, as the ultrasound FSMs do, so no echo signal is needed.
+ *
+ * @author Javier Morales
+ * @author Cristian Lapides
+ * @date 2026-10-16
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW independent libraries */
+#include "port_button.h"
+#include "port_ultrasound.h"
+#include "port_display.h"
+#include "port_buzzer.h"
+#include "port_system.h"
+
+/* Include FSM libraries */
+#include "fsm.h"
+#include "fsm_urbanite.h"
+#include "measurement_bus.h"
+
+/* Defines */
+#define ON_OFF_PRESS_TIME_MS 3000  /*!< Button press time in ms to turn the system ON or OFF @hideinitializer */
+#define CHANGE_PRESS_TIME_MS 1000  /*!< Button press time in ms to change the gear @hideinitializer */
+#define PAUSE_DISPLAY_TIME_MS 500  /*!< Button press time in ms to pause the displays @hideinitializer */
+#define ECHO_INIT_TICK 1234        /*!< Echo init tick of a measurement in progress @hideinitializer */
+
+static fsm_button_t *p_fsm_button;
+static fsm_ultrasound_t *p_fsm_ultrasound_front;
+static fsm_display_t *p_fsm_display_front;
+static fsm_ultrasound_t *p_fsm_ultrasound_rear;
+static fsm_display_t *p_fsm_display_rear;
+static fsm_buzzer_t *p_fsm_buzzer;
+static fsm_urbanite_t *p_fsm_urbanite;
+
+/* The Urbanite reads the records by reference in its next fire, so they must outlive the publication */
+static measurement_record_t records[2];
+
+void setUp(void)
+{
+    p_fsm_button = fsm_button_new(PORT_PARKING_BUTTON_DEBOUNCE_TIME_MS, PORT_PARKING_BUTTON_ID);
+    port_button_disable_interrupts(PORT_PARKING_BUTTON_ID); // Disable EXTI to avoid unwanted interrupts
+    p_fsm_ultrasound_front = fsm_ultrasound_new(PORT_FRONT_PARKING_SENSOR_ID);
+    p_fsm_display_front = fsm_display_new(PORT_FRONT_PARKING_DISPLAY_ID);
+    p_fsm_ultrasound_rear = fsm_ultrasound_new(PORT_REAR_PARKING_SENSOR_ID);
+    p_fsm_display_rear = fsm_display_new(PORT_REAR_PARKING_DISPLAY_ID);
+    p_fsm_buzzer = fsm_buzzer_new(PORT_PARKING_BUZZER_ID);
+    p_fsm_urbanite = fsm_urbanite_new(p_fsm_button, ON_OFF_PRESS_TIME_MS, CHANGE_PRESS_TIME_MS, PAUSE_DISPLAY_TIME_MS, p_fsm_ultrasound_front, p_fsm_display_front, p_fsm_ultrasound_rear, p_fsm_display_rear, p_fsm_buzzer);
+}
+
+void tearDown(void)
+{
+    fsm_urbanite_destroy(p_fsm_urbanite);
+    fsm_buzzer_destroy(p_fsm_buzzer);
+    fsm_display_destroy(p_fsm_display_rear);
+    fsm_ultrasound_destroy(p_fsm_ultrasound_rear);
+    fsm_display_destroy(p_fsm_display_front);
+    fsm_ultrasound_destroy(p_fsm_ultrasound_front);
+    fsm_button_destroy(p_fsm_button);
+}
+
+/**
+ * @brief Press the button for a time and fire the Urbanite FSM once the press has been measured.
+ *
+ */
+static void _press_button(uint32_t press_time_ms)
+{
+    port_button_push_event(PORT_PARKING_BUTTON_ID, true);
+    port_system_delay_ms(press_time_ms);
+    port_button_push_event(PORT_PARKING_BUTTON_ID, false);
+    port_system_delay_ms(PORT_PARKING_BUTTON_DEBOUNCE_TIME_MS + 10);
+    fsm_button_fire(p_fsm_button);
+    fsm_urbanite_fire(p_fsm_urbanite);
+}
+
+/**
+ * @brief Publish a distance of an ultrasound on the measurement bus, without time to collision, and fire the Urbanite FSM.
+ *
+ */
+static void _publish_distance(uint32_t ultrasound_id, uint32_t distance_cm)
+{
+    measurement_record_t *p_record = &records[ultrasound_id];
+    p_record->sensor_id = ultrasound_id;
+    p_record->timestamp_ms = port_system_get_millis();
+    p_record->distance_cm = distance_cm;
+    p_record->distance_mm = distance_cm * 10;
+    p_record->ttc_ms = FSM_ULTRASOUND_TTC_INFINITE;
+    p_record->confidence = 100;
+    measurement_bus_publish(p_record);
+    fsm_urbanite_fire(p_fsm_urbanite);
+}
+
+/**
+ * @brief Turn the system ON measuring both sides. The current gear is FRONT.
+ *
+ */
+static void _turn_on_measuring_both(void)
+{
+    fsm_urbanite_set_measure_both(p_fsm_urbanite, true);
+    _press_button(ON_OFF_PRESS_TIME_MS);
+    UNITY_TEST_ASSERT_EQUAL_INT(MEASURE_FRONT, fsm_get_state((fsm_t *)p_fsm_urbanite), __LINE__, "The Urbanite did not turn ON");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, fsm_ultrasound_get_status(p_fsm_ultrasound_front), __LINE__, "The front ultrasound should measure after turning ON");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, fsm_ultrasound_get_status(p_fsm_ultrasound_rear), __LINE__, "The rear ultrasound should also measure after turning ON if both sides are measured");
+}
+
+/**
+ * @brief Check that each display shows its own side and the buzzer sounds the closer side, whatever the current gear.
+ *
+ */
+void test_measure_both_buzzer_closer(void)
+{
+    _turn_on_measuring_both();
+
+    // The rear side is closer although the current gear is FRONT
+    _publish_distance(PORT_REAR_PARKING_SENSOR_ID, 150);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, fsm_display_get_status(p_fsm_display_rear), __LINE__, "The rear display should show the rear distance");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(150, fsm_buzzer_get_distance(p_fsm_buzzer), __LINE__, "The buzzer should sound the rear side, which is the closer one");
+
+    // Then the front side is the closer one
+    _publish_distance(PORT_FRONT_PARKING_SENSOR_ID, 40);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, fsm_display_get_status(p_fsm_display_front), __LINE__, "The front display should show the front distance");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, fsm_display_get_status(p_fsm_display_rear), __LINE__, "The rear display should keep showing the rear distance");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(40, fsm_buzzer_get_distance(p_fsm_buzzer), __LINE__, "The buzzer should sound the front side, which is the closer one");
+}
+
+/**
+ * @brief Check that a change of gear while both sides are measured does not restart any ultrasound, so no measurement in progress is lost.
+ *
+ */
+void test_measure_both_gear_change(void)
+{
+    _turn_on_measuring_both();
+    _publish_distance(PORT_FRONT_PARKING_SENSOR_ID, 120);
+    _publish_distance(PORT_REAR_PARKING_SENSOR_ID, 80);
+
+    uint32_t ultrasound_ids[2] = {PORT_FRONT_PARKING_SENSOR_ID, PORT_REAR_PARKING_SENSOR_ID};
+    int32_t gears[2] = {MEASURE_REAR, MEASURE_FRONT};
+    for (uint32_t g = 0; g < 2; g++)
+    {
+        // Both ultrasounds have a measurement in progress
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            port_ultrasound_set_trigger_ready(ultrasound_ids[i], false);
+            port_ultrasound_set_echo_init_tick(ultrasound_ids[i], ECHO_INIT_TICK);
+        }
+
+        _press_button(CHANGE_PRESS_TIME_MS);
+        UNITY_TEST_ASSERT_EQUAL_INT(gears[g], fsm_get_state((fsm_t *)p_fsm_urbanite), __LINE__, "The Urbanite did not change the gear");
+
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            UNITY_TEST_ASSERT_EQUAL_UINT32(false, port_ultrasound_get_trigger_ready(ultrasound_ids[i]), __LINE__, "No ultrasound should be triggered again by a change of gear");
+            UNITY_TEST_ASSERT_EQUAL_UINT32(ECHO_INIT_TICK, port_ultrasound_get_echo_init_tick(ultrasound_ids[i]), __LINE__, "The measurement in progress should not be reset by a change of gear");
+        }
+        UNITY_TEST_ASSERT_EQUAL_UINT32(true, fsm_ultrasound_get_status(p_fsm_ultrasound_front), __LINE__, "The front ultrasound should keep measuring after a change of gear");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(true, fsm_ultrasound_get_status(p_fsm_ultrasound_rear), __LINE__, "The rear ultrasound should keep measuring after a change of gear");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(true, fsm_display_get_status(p_fsm_display_front), __LINE__, "The front display should keep showing its distance after a change of gear");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(true, fsm_display_get_status(p_fsm_display_rear), __LINE__, "The rear display should keep showing its distance after a change of gear");
+    }
+}
+
+/**
+ * @brief Check that measuring only the current side again stops the ultrasound of the other side and blanks its display.
+ *
+ */
+void test_measure_both_off(void)
+{
+    _turn_on_measuring_both();
+    _publish_distance(PORT_FRONT_PARKING_SENSOR_ID, 120);
+    _publish_distance(PORT_REAR_PARKING_SENSOR_ID, 50);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(50, fsm_buzzer_get_distance(p_fsm_buzzer), __LINE__, "The buzzer should sound the closer side");
+
+    fsm_urbanite_set_measure_both(p_fsm_urbanite, false);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(false, fsm_urbanite_get_measure_both(p_fsm_urbanite), __LINE__, "Both sides should not be measured anymore");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(false, fsm_ultrasound_get_status(p_fsm_ultrasound_rear), __LINE__, "The rear ultrasound should be stopped, since the current gear is FRONT");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(false, fsm_display_get_status(p_fsm_display_rear), __LINE__, "The rear display should be OFF, since the current gear is FRONT");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, fsm_ultrasound_get_status(p_fsm_ultrasound_front), __LINE__, "The front ultrasound should keep measuring");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, fsm_display_get_status(p_fsm_display_front), __LINE__, "The front display should keep showing its distance");
+
+    // The buzzer only sounds the current side, although the last rear distance was closer
+    _publish_distance(PORT_FRONT_PARKING_SENSOR_ID, 110);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(110, fsm_buzzer_get_distance(p_fsm_buzzer), __LINE__, "The buzzer should only sound the current side");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(false, fsm_display_get_status(p_fsm_display_rear), __LINE__, "The rear display should stay OFF");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+
+    RUN_TEST(test_measure_both_buzzer_closer);
+    RUN_TEST(test_measure_both_gear_change);
+    RUN_TEST(test_measure_both_off);
+
+    exit(UNITY_END());
+}